@@ -0,0 +1,38 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+#include <stdio.h>
+#include <time.h>
+
+/** Current time in seconds (monotonic enough for benchmarks) */
+static inline double bench_now(void) {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/** Print a benchmark result line */
+static inline void bench_report(const char *name, size_t iterations, double seconds) {
+	printf("%-40s %10.1f ns/op\n", name, seconds * 1e9 / (double) iterations);
+}
+
+void bench_dynstr_printf(void);
+void bench_dynstrnum(void);
+void bench_dynstrsearch(void);
+void bench_charset(void);
+void bench_strbuilder(void);
+void bench_dynstr_arena(void);
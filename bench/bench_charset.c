@@ -0,0 +1,52 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <CEssentials/dynstr.h>
+#include "bench.h"
+
+#define ITERATIONS 100000
+
+void bench_charset(void) {
+	// A line padded with 200 blanks on each side
+	char line[512];
+	memset(line, ' ', sizeof(line));
+	for (size_t i = 200; i < 300; i++) {
+		line[i] = "\t\r\n"[i % 3];
+	}
+	memcpy(line + 240, "payload", 7);
+	const char *blank = " \t\r\n";
+	charset_t blank_set = charset_make(blank);
+	size_t total = 0;
+	
+	double start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		size_t j = 0, k = sizeof(line);
+		while (j < k && strchr(blank, line[j]) != NULL) j++;
+		while (k > j && strchr(blank, line[k - 1]) != NULL) k--;
+		total += k - j;
+	}
+	bench_report("trim with strchr (512 chars)", ITERATIONS, bench_now() - start);
+	
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		size_t j = charset_span(&blank_set, line, sizeof(line));
+		total += sizeof(line) - j - charset_rspan(&blank_set, line + j, sizeof(line) - j);
+	}
+	bench_report("trim with charset (512 chars)", ITERATIONS, bench_now() - start);
+	
+	printf("(checksum %zu)\n", total);
+}
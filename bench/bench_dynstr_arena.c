@@ -0,0 +1,56 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <stdio.h>
+#include <CEssentials/dynstr.h>
+#include "bench.h"
+
+#define ITERATIONS 100
+#define STRINGS 10000
+
+void bench_dynstr_arena(void) {
+	// Build and throw away a batch of short strings, as done per request by a server
+	static dynstr strings[STRINGS];
+	size_t total = 0;
+	
+	double start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		for (size_t j = 0; j < STRINGS; j++) {
+			strings[j] = dynstr_new("header-");
+			strings[j] = dynstr_append(strings[j], "value");
+			total += dynstr_size(strings[j]);
+		}
+		for (size_t j = 0; j < STRINGS; j++) {
+			dynstr_free(strings[j]);
+		}
+	}
+	bench_report("dynstr_new + append + free", ITERATIONS * STRINGS, bench_now() - start);
+	
+	dynstr_arena_t arena;
+	dynstr_arena_init(&arena, 0);
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		for (size_t j = 0; j < STRINGS; j++) {
+			strings[j] = dynstr_arena_new(&arena, "header-");
+			strings[j] = dynstr_append(strings[j], "value");
+			total += dynstr_size(strings[j]);
+		}
+		dynstr_arena_reset(&arena);
+	}
+	bench_report("dynstr_arena_new + append + reset", ITERATIONS * STRINGS, bench_now() - start);
+	dynstr_arena_destroy(&arena);
+	
+	printf("(checksum %zu)\n", total);
+}
@@ -0,0 +1,72 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <stdarg.h>
+#include <stdio.h>
+#include <CEssentials/dynstr.h>
+#include "bench.h"
+
+#define ITERATIONS 1000000
+
+// The previous implementation: measure with vsnprintf(NULL, 0, ...) and then format again
+static dynstr two_pass_printf(dynstr dest, const char *fmt, ...) {
+	va_list args, args_copy;
+	va_start(args, fmt);
+	va_copy(args_copy, args);
+	int count = vsnprintf(NULL, 0, fmt, args_copy);
+	va_end(args_copy);
+	dest = dynstr_reserve2(dest, dynstr_size(dest) + (size_t) count);
+	if (dest) {
+		vsnprintf(dest + dynstr_size(dest), (size_t) count + 1, fmt, args);
+		dynstr_set_size(dest, dynstr_size(dest) + (size_t) count);
+	}
+	va_end(args);
+	return dest;
+}
+
+#define BENCH_FORMAT "%s:%i [%s] request %lu took %.3f ms\n"
+#define BENCH_ARGS "server.c", 128, "info", (unsigned long) i, (double) i * 0.001
+
+void bench_dynstr_printf(void) {
+	dynstr s = dynstr_alloc(4096);
+	size_t total = 0;
+	
+	double start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		s = dynstr_clear(s);
+		s = two_pass_printf(s, BENCH_FORMAT, BENCH_ARGS);
+		total += dynstr_size(s);
+	}
+	bench_report("dynstr_printf (two passes, old)", ITERATIONS, bench_now() - start);
+	
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		s = dynstr_clear(s);
+		s = dynstr_printf(s, BENCH_FORMAT, BENCH_ARGS);
+		total += dynstr_size(s);
+	}
+	bench_report("dynstr_printf (spare capacity)", ITERATIONS, bench_now() - start);
+	
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		dynstr t = dynstr_new_printf(BENCH_FORMAT, BENCH_ARGS);
+		total += dynstr_size(t);
+		dynstr_free(t);
+	}
+	bench_report("dynstr_new_printf (stack buffer)", ITERATIONS, bench_now() - start);
+	
+	dynstr_free(s);
+	printf("(checksum %zu)\n", total);
+}
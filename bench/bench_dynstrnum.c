@@ -0,0 +1,101 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <CEssentials/dynstrnum.h>
+#include "bench.h"
+
+#define ITERATIONS 1000000
+
+void bench_dynstrnum(void) {
+	dynstr s = dynstr_alloc(64);
+	size_t total = 0;
+	
+	double start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		s = dynstr_clear(s);
+		s = dynstr_printf(s, "%lld", (long long) (i * 2654435761u));
+		total += dynstr_size(s);
+	}
+	bench_report("dynstr_printf(\"%lld\")", ITERATIONS, bench_now() - start);
+	
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		s = dynstr_clear(s);
+		s = dynstr_append_i64(s, (int64_t) (i * 2654435761u));
+		total += dynstr_size(s);
+	}
+	bench_report("dynstr_append_i64", ITERATIONS, bench_now() - start);
+	
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		s = dynstr_clear(s);
+		s = dynstr_printf(s, "%.17g", (double) i * 0.001);
+		total += dynstr_size(s);
+	}
+	bench_report("dynstr_printf(\"%.17g\")", ITERATIONS, bench_now() - start);
+	
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		s = dynstr_clear(s);
+		s = dynstr_append_double(s, (double) i * 0.001);
+		total += dynstr_size(s);
+	}
+	bench_report("dynstr_append_double", ITERATIONS, bench_now() - start);
+	
+	// Parse the formatted values back
+	char texts[1024][STR_DOUBLE_MAX_CHARS + 1];
+	size_t lengths[1024];
+	for (size_t i = 0; i < 1024; i++) {
+		lengths[i] = i % 2 ? str_format_i64(texts[i], (int64_t) (i * 2654435761u))
+				: str_format_double(texts[i], (double) i * 1.1e-3);
+		texts[i][lengths[i]] = '\0';
+	}
+	
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		total += (size_t) strtoll(texts[(i % 512) * 2 + 1], NULL, 10);
+	}
+	bench_report("strtoll", ITERATIONS, bench_now() - start);
+	
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		int64_t value = 0;
+		size_t k = (i % 512) * 2 + 1;
+		str_to_i64(texts[k], lengths[k], &value);
+		total += (size_t) value;
+	}
+	bench_report("str_to_i64", ITERATIONS, bench_now() - start);
+	
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		total += (size_t) (strtod(texts[(i % 512) * 2], NULL) * 1000);
+	}
+	bench_report("strtod", ITERATIONS, bench_now() - start);
+	
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		double value = 0;
+		size_t k = (i % 512) * 2;
+		str_to_double(texts[k], lengths[k], &value);
+		total += (size_t) (value * 1000);
+	}
+	bench_report("str_to_double", ITERATIONS, bench_now() - start);
+	
+	dynstr_free(s);
+	printf("(checksum %zu)\n", total);
+}
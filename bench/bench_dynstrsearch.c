@@ -0,0 +1,87 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <CEssentials/dynstrsearch.h>
+#include "bench.h"
+
+#define ITERATIONS 2000
+
+/** Naive replacement on top of strstr (how replacing was done before dynstr_replace_all()) */
+static dynstr replace_strstr(dynstr s, const char *from, const char *to) {
+	dynstr result = dynstr_new("");
+	size_t from_count = strlen(from);
+	const char *begin = s, *end;
+	while ((end = strstr(begin, from)) != NULL) {
+		result = dynstr_push_chars(result, begin, (size_t) (end - begin));
+		result = dynstr_append(result, to);
+		begin = end + from_count;
+	}
+	result = dynstr_append(result, begin);
+	dynstr_free(s);
+	return result;
+}
+
+void bench_dynstrsearch(void) {
+	// 64 KiB of pseudo-random words between the needles for backward and forward search
+	dynstr text = dynstr_new("haystack ");
+	unsigned int seed = 1;
+	while (dynstr_size(text) < (1 << 16) - 16) {
+		seed = seed * 1103515245 + 12345;
+		static const char *const words[] = {"lorem ", "ipsum ", "dolor ", "sit ", "amet ", "consectetur "};
+		text = dynstr_append(text, words[(seed >> 16) % 6]);
+	}
+	text = dynstr_append(text, "needle");
+	size_t total = 0;
+	
+	double start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		total += (size_t) (strstr(text + (i & 7), "needle") - text);
+	}
+	bench_report("strstr (64 KiB)", ITERATIONS, bench_now() - start);
+	
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		total += str_find(text + (i & 7), dynstr_size(text) - (i & 7), "needle", 6);
+	}
+	bench_report("dynstr_find (64 KiB)", ITERATIONS, bench_now() - start);
+	
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		total += dynstr_rfind(text, "haystack");
+	}
+	bench_report("dynstr_rfind (64 KiB)", ITERATIONS, bench_now() - start);
+	
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS / 10; i++) {
+		dynstr s = replace_strstr(dynstr_dup(text), "ipsum", "IPSUM!");
+		total += dynstr_size(s);
+		dynstr_free(s);
+	}
+	bench_report("replace with strstr (64 KiB)", ITERATIONS / 10, bench_now() - start);
+	
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS / 10; i++) {
+		dynstr s = dynstr_replace_all(dynstr_dup(text), "ipsum", "IPSUM!");
+		total += dynstr_size(s);
+		dynstr_free(s);
+	}
+	bench_report("dynstr_replace_all (64 KiB)", ITERATIONS / 10, bench_now() - start);
+	
+	dynstr_free(text);
+	printf("(checksum %zu)\n", total);
+}
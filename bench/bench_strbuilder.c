@@ -0,0 +1,69 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <CEssentials/strbuilder.h>
+#include "bench.h"
+
+#define ITERATIONS 20
+#define PIECES 100000
+
+void bench_strbuilder(void) {
+	// Build an 8 MB response out of 80-character pieces
+	char piece[80];
+	memset(piece, '.', sizeof(piece));
+	size_t total = 0;
+	
+	double start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		dynstr s = dynstr_new("");
+		for (size_t j = 0; j < PIECES; j++) {
+			s = dynstr_push_chars(s, piece, sizeof(piece));
+		}
+		total += dynstr_size(s);
+		dynstr_free(s);
+	}
+	bench_report("dynstr_push_chars (8 MB)", ITERATIONS, bench_now() - start);
+	
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		strbuilder_t b;
+		strbuilder_init(&b, 0);
+		for (size_t j = 0; j < PIECES; j++) {
+			strbuilder_push_chars(&b, piece, sizeof(piece));
+		}
+		strbuilder_iovec_t iov[64];
+		total += strbuilder_iovec(&b, iov, 64);
+		strbuilder_destroy(&b);
+	}
+	bench_report("strbuilder_push_chars + iovec (8 MB)", ITERATIONS, bench_now() - start);
+	
+	start = bench_now();
+	for (size_t i = 0; i < ITERATIONS; i++) {
+		strbuilder_t b;
+		strbuilder_init(&b, 0);
+		for (size_t j = 0; j < PIECES; j++) {
+			strbuilder_push_chars(&b, piece, sizeof(piece));
+		}
+		dynstr s = strbuilder_to_dynstr(&b, NULL);
+		total += dynstr_size(s);
+		dynstr_free(s);
+		strbuilder_destroy(&b);
+	}
+	bench_report("strbuilder_push_chars + to_dynstr (8 MB)", ITERATIONS, bench_now() - start);
+	
+	printf("(checksum %zu)\n", total);
+}
@@ -0,0 +1,171 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+/**
+ * @file
+ * @brief Bit manipulation helpers (bit scan, population count) and fast byte search used by containers.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BITOPS_SSE2 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define BITOPS_LITTLE_ENDIAN 1
+#endif
+#elif defined(_WIN32) || defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define BITOPS_LITTLE_ENDIAN 1
+#endif
+
+/** Count trailing zero bits of a 32-bit integer (\p x must not be zero). */
+static inline unsigned int bitops_ctz32(uint32_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (unsigned int) __builtin_ctz(x);
+#elif defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, x);
+	return (unsigned int) index;
+#else
+	unsigned int n = 0;
+	while (!(x & 1)) {
+		x >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/** Count trailing zero bits of a 64-bit integer (\p x must not be zero). */
+static inline unsigned int bitops_ctz64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (unsigned int) __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return (unsigned int) index;
+#else
+	uint32_t low = (uint32_t) x;
+	return low ? bitops_ctz32(low) : 32 + bitops_ctz32((uint32_t) (x >> 32));
+#endif
+}
+
+/** Count leading zero bits of a 64-bit integer (\p x must not be zero). */
+static inline unsigned int bitops_clz64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (unsigned int) __builtin_clzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, x);
+	return 63 - (unsigned int) index;
+#else
+	unsigned int n = 0;
+	while (!(x & (1ull << 63))) {
+		x <<= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/** Count set bits of a 32-bit integer. */
+static inline unsigned int bitops_popcount32(uint32_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (unsigned int) __builtin_popcount(x);
+#else
+	x = x - ((x >> 1) & 0x55555555u);
+	x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+	x = (x + (x >> 4)) & 0x0F0F0F0Fu;
+	return (unsigned int) ((x * 0x01010101u) >> 24);
+#endif
+}
+
+/** Count set bits of a 64-bit integer. */
+static inline unsigned int bitops_popcount64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return (unsigned int) __builtin_popcountll(x);
+#else
+	return bitops_popcount32((uint32_t) x) + bitops_popcount32((uint32_t) (x >> 32));
+#endif
+}
+
+/**
+ * Multiply two 64-bit integers into a 128-bit product.
+ *
+ * Returns the lower half of the product and stores the upper half into \p high.
+ */
+static inline uint64_t bitops_mul128(uint64_t a, uint64_t b, uint64_t *high) {
+#if defined(__SIZEOF_INT128__)
+	__extension__ unsigned __int128 product = (unsigned __int128) a * b;
+	*high = (uint64_t) (product >> 64);
+	return (uint64_t) product;
+#elif defined(_MSC_VER) && defined(_M_X64)
+	return _umul128(a, b, high);
+#else
+	uint64_t a_low = (uint32_t) a, a_high = a >> 32, b_low = (uint32_t) b, b_high = b >> 32;
+	uint64_t low_low = a_low * b_low, high_low = a_high * b_low, low_high = a_low * b_high;
+	uint64_t cross = (low_low >> 32) + (uint32_t) high_low + low_high; // Can't overflow
+	*high = a_high * b_high + (high_low >> 32) + (cross >> 32);
+	return (cross << 32) | (uint32_t) low_low;
+#endif
+}
+
+/**
+ * Find the first position not less than \p index where \p data contains byte \p value.
+ * Returns \p size if there is no such byte.
+ *
+ * Checks 16 (SSE2) or 8 (SWAR) bytes per iteration, so sparse arrays are scanned quickly.
+ */
+static inline size_t bitops_find_byte(const char *data, size_t size, size_t index, char value) {
+#if defined(BITOPS_SSE2)
+	__m128i pattern = _mm_set1_epi8(value);
+	while (index + 16 <= size) {
+		__m128i chunk = _mm_loadu_si128((const __m128i*) (data + index));
+		unsigned int mask = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern));
+		if (mask) {
+			return index + bitops_ctz32(mask);
+		}
+		index += 16;
+	}
+#elif defined(BITOPS_LITTLE_ENDIAN)
+	const uint64_t ones = 0x0101010101010101ull;
+	const uint64_t pattern = ones * (unsigned char) value;
+	while (index + 8 <= size) {
+		uint64_t chunk;
+		memcpy(&chunk, data + index, sizeof(chunk));
+		chunk ^= pattern; // Matching bytes become zero
+		uint64_t zeros = (chunk - ones) & ~chunk & (ones << 7);
+		if (zeros) {
+			return index + bitops_ctz64(zeros) / 8;
+		}
+		index += 8;
+	}
+#endif
+	while (index < size && data[index] != value) {
+		index++;
+	}
+	return index;
+}
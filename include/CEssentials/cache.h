@@ -0,0 +1,215 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+/**
+ * @file
+ * @brief Generic bounded cache with CLOCK eviction built on top of the hash table.
+ * @details
+ * Every element has a cost (e.g. its size in bytes), the cache evicts elements when total cost exceeds the limit.
+ * The eviction uses CLOCK algorithm (second chance approximation of LRU): a hand sweeps over hash table slots,
+ * clearing reference bits set by cache_get() and evicting the first element which wasn't referenced since
+ * the previous sweep. Reference bits and costs are stored inline in the hash table values, so the cache doesn't
+ * need any additional lists. All operations are O(1) amortized.
+ *
+ * Values are stored in entries declared with CACHE_ENTRY() which must be given a type name:
+ * \code
+ * typedef CACHE_ENTRY(dynstr) page_entry_t;
+ * CACHE(const char*, page_entry_t) cache; size_t index; int absent; dynstr old_page;
+ * cache_init(cache, 1024 * 1024);
+ *
+ * #define free_page(key, value) dynstr_free(value)
+ * cache_put_str(cache, page_entry_t, "index.html", page, dynstr_size(page), index, absent, old_page, free_page);
+ * if (absent == 0) {
+ *     dynstr_free(old_page); // The page was replaced
+ * }
+ *
+ * cache_get_str(cache, "index.html", index);
+ * if (cache_valid(cache, index)) {
+ *     printf("%s\n", cache_value(cache, index));
+ * }
+ *
+ * cache_for_each(cache, i) {
+ *     dynstr_free(cache_value(cache, i));
+ * }
+ * cache_destroy(cache);
+ * \endcode
+ */
+
+#include "hashtable.h"
+
+/** A cache entry struct definition (holds a value, its cost and the reference bit) */
+#define CACHE_ENTRY(value_type) struct { \
+	value_type value; \
+	size_t cost; \
+	bool referenced; \
+}
+
+/** A cache struct definition. \p entry_type must be a named type declared with CACHE_ENTRY(). */
+#define CACHE(key_type, entry_type) struct { \
+	HT(key_type, entry_type) table; \
+	size_t cost, max_cost, hand; \
+	size_t hits, misses, evictions; \
+}
+
+/** Initialize a empty cache which holds elements with total cost up to \p limit (no memory allocation performed). */
+#define cache_init(c, limit) do { \
+	ht_init((c).table); \
+	(c).cost = 0; \
+	(c).max_cost = (limit); \
+	(c).hand = 0; \
+	(c).hits = (c).misses = (c).evictions = 0; \
+} while (0)
+
+/**
+ * Destroy a cache.
+ *
+ * Eviction callback isn't called, so you might need manually destroy keys and values if they are complex.
+ */
+#define cache_destroy(c) ht_destroy((c).table)
+
+/** Get number of elements stored in the cache. */
+#define cache_size(c) ht_size((c).table)
+
+/** Get total cost of elements stored in the cache. */
+#define cache_cost(c) ((c).cost)
+
+/** Get maximum total cost of elements stored in the cache. */
+#define cache_max_cost(c) ((c).max_cost)
+
+/** Get number of successful lookups. */
+#define cache_hits(c) ((c).hits)
+
+/** Get number of failed lookups. */
+#define cache_misses(c) ((c).misses)
+
+/** Get number of evicted elements. */
+#define cache_evictions(c) ((c).evictions)
+
+/** Eviction callback which does nothing */
+#define cache_evict_none(key, value) ((void) 0)
+
+/**
+ * Evict elements until total cost fits the limit. The element at \p keep index (if valid) is never evicted.
+ *
+ * \p evict_func is called as `evict_func(key, value)` for each evicted element before its removal.
+ */
+#define cache_evict(c, keep, evict_func) do { \
+	size_t cache_keep = (keep); \
+	size_t cache_pinned = cache_keep < ht_capacity((c).table) && ht_valid((c).table, cache_keep) ? 1 : 0; \
+	while ((c).cost > (c).max_cost && ht_size((c).table) > cache_pinned) { \
+		size_t cache_i = ht_next_valid_index((c).table.flags, ht_capacity((c).table), (c).hand); \
+		if (cache_i >= ht_capacity((c).table)) { \
+			(c).hand = 0; \
+			continue; \
+		} \
+		(c).hand = cache_i + 1; \
+		if (cache_i == cache_keep) continue; \
+		if (ht_value((c).table, cache_i).referenced) { \
+			ht_value((c).table, cache_i).referenced = false; \
+			continue; \
+		} \
+		evict_func(ht_key((c).table, cache_i), ht_value((c).table, cache_i).value); \
+		(c).cost -= ht_value((c).table, cache_i).cost; \
+		ht_delete((c).table, cache_i); \
+		(c).evictions++; \
+	} \
+} while (0)
+
+/** Change maximum total cost of elements stored in the cache evicting elements if needed. */
+#define cache_set_max_cost(c, limit, evict_func) do { \
+	(c).max_cost = (limit); \
+	cache_evict((c), ht_capacity((c).table), evict_func); \
+} while (0)
+
+/**
+ * Perform cache lookup and return in \p result index of matched element if any.
+ *
+ * You have to check returned value with cache_valid() to determine if the element has been found.
+ * Found element is marked as recently used.
+ */
+#define cache_get(c, key, result, hash_func, eq_func) do { \
+	ht_get((c).table, (key), (result), hash_func, eq_func); \
+	if (ht_valid((c).table, (result))) { \
+		ht_value((c).table, (result)).referenced = true; \
+		(c).hits++; \
+	} else { \
+		(c).misses++; \
+	} \
+} while (0)
+
+/**
+ * Insert or replace an element of the cache and return its index. Evicts other elements if total cost
+ * exceeds the limit (the inserted element itself is never evicted by this call).
+ *
+ * \p absent has the same meaning as for ht_put(). If the key was already present, the stored key is kept,
+ * the previous value is written to \p old_value (which is left untouched otherwise) and replaced, so the caller
+ * must release it. \p evict_func is called only for other elements evicted to make room.
+ */
+#define cache_put(c, key_type, entry_type, key, new_value, new_cost, index, absent, old_value, hash_func, eq_func, evict_func) do { \
+	ht_put((c).table, key_type, entry_type, (key), (index), (absent), hash_func, eq_func); \
+	if ((absent) < 0) { \
+		break; \
+	} \
+	if ((absent) == 0) { \
+		(old_value) = ht_value((c).table, (index)).value; \
+		(c).cost -= ht_value((c).table, (index)).cost; \
+		ht_value((c).table, (index)).referenced = true; \
+	} else { \
+		ht_value((c).table, (index)).referenced = false; \
+	} \
+	ht_value((c).table, (index)).value = (new_value); \
+	ht_value((c).table, (index)).cost = (new_cost); \
+	(c).cost += (new_cost); \
+	cache_evict((c), (index), evict_func); \
+} while (0)
+
+/** Delete an element from the cache by its index (eviction callback isn't called). */
+#define cache_delete(c, index) do { \
+	(c).cost -= ht_value((c).table, (index)).cost; \
+	ht_delete((c).table, (index)); \
+} while (0)
+
+/** Verify cache element index for validity (needed for cache_get() and for iteration) */
+#define cache_valid(c, index) ht_valid((c).table, (index))
+
+/** Access key by cache element index */
+#define cache_key(c, index) ht_key((c).table, (index))
+
+/** Access value by cache element index */
+#define cache_value(c, index) (ht_value((c).table, (index)).value)
+
+/** Access cost by cache element index */
+#define cache_entry_cost(c, index) (ht_value((c).table, (index)).cost)
+
+/** For each loop over the cache using provided \p index variable (doesn't affect reference bits). */
+#define cache_for_each(c, index) ht_for_each((c).table, index)
+
+/** Lookup implementation for the cache with string keys */
+#define cache_get_str(c, key, result) \
+cache_get((c), (key), (result), ht_str_hash, ht_str_eq)
+
+/** Insertion implementation for the cache with string keys */
+#define cache_put_str(c, entry_type, key, new_value, new_cost, index, absent, old_value, evict_func) \
+cache_put((c), const char*, entry_type, (key), (new_value), (new_cost), (index), (absent), old_value, ht_str_hash, ht_str_eq, evict_func)
+
+/** Lookup implementation for the cache with 64-bit unsigned integer keys */
+#define cache_get_u64(c, key, result) \
+cache_get((c), (key), (result), ht_u64_hash, ht_int_eq)
+
+/** Insertion implementation for the cache with 64-bit unsigned integer keys */
+#define cache_put_u64(c, entry_type, key, new_value, new_cost, index, absent, old_value, evict_func) \
+cache_put((c), uint64_t, entry_type, (key), (new_value), (new_cost), (index), (absent), old_value, ht_u64_hash, ht_int_eq, evict_func)
@@ -0,0 +1,116 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+/**
+ * @file
+ * @brief Precompiled character sets (256-bit bitmaps) for trimming, tokenizing and searching any of several characters.
+ * @details
+ * Membership of a character is a single bit test instead of a `strchr` call per character, so scanning a string
+ * is linear regardless of the set size. Sets of up to CHARSET_SMALL_SIZE characters also remember their members,
+ * which lets scanning functions compare 16 characters at once with SSE2. A set is built once and then can be
+ * passed to any number of calls. Unlike NULL-terminated character lists, a set may contain the NULL character.
+ *
+ * Example of usage:
+ * \code
+ * charset_t separators = charset_make(" ,;");
+ * const char *s = "one, two;three";
+ * size_t word = charset_cspan(&separators, s, strlen(s)); // 3
+ * size_t gap = charset_span(&separators, s + word, strlen(s) - word); // 2
+ * \endcode
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Maximum number of members of a set scanned with SIMD comparisons. */
+#define CHARSET_SMALL_SIZE 8
+
+/** A set of characters. */
+typedef struct charset {
+	uint64_t bits[4]; //!< Bitmap of members indexed by unsigned character values.
+	unsigned int size; //!< Number of members.
+	unsigned char members[CHARSET_SMALL_SIZE]; //!< Members in insertion order (valid if size <= CHARSET_SMALL_SIZE).
+} charset_t;
+
+/** Make an empty set. */
+static inline charset_t charset_empty(void) {
+	charset_t set = { { 0, 0, 0, 0 }, 0, { 0 } };
+	return set;
+}
+
+/** Check if a character belongs to a set. */
+static inline bool charset_contains(const charset_t *set, char c) {
+	unsigned char value = (unsigned char) c;
+	return (set->bits[value >> 6] >> (value & 63)) & 1;
+}
+
+/** Add a character to a set (does nothing if it's already there). */
+static inline void charset_add(charset_t *set, char c) {
+	unsigned char value = (unsigned char) c;
+	if (!charset_contains(set, c)) {
+		set->bits[value >> 6] |= (uint64_t) 1 << (value & 63);
+		if (set->size < CHARSET_SMALL_SIZE) {
+			set->members[set->size] = value;
+		}
+		set->size++;
+	}
+}
+
+/** Add \p count characters starting from \p chars to a set. */
+static inline void charset_add_chars(charset_t *set, const char *chars, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		charset_add(set, chars[i]);
+	}
+}
+
+/** Add all characters from \p first to \p last (inclusive, compared as unsigned characters) to a set. */
+static inline void charset_add_range(charset_t *set, char first, char last) {
+	for (unsigned int c = (unsigned char) first; c <= (unsigned char) last; c++) {
+		charset_add(set, (char) c);
+	}
+}
+
+/** Make a set of characters of a NULL-terminated string (the NULL character isn't added). */
+static inline charset_t charset_make(const char *chars) {
+	charset_t set = charset_empty();
+	while (*chars) {
+		charset_add(&set, *chars++);
+	}
+	return set;
+}
+
+/** Replace a set by its complement (all characters which don't belong to it). */
+void charset_invert(charset_t *set);
+
+/** Get length of the longest prefix of \p count characters starting at \p data which consists of set members. */
+size_t charset_span(const charset_t *set, const char *data, size_t count);
+
+/**
+ * Get length of the longest prefix of \p count characters starting at \p data without set members
+ * (index of the first member or \p count if there are none).
+ */
+size_t charset_cspan(const charset_t *set, const char *data, size_t count);
+
+/** Get length of the longest suffix of \p count characters starting at \p data which consists of set members. */
+size_t charset_rspan(const charset_t *set, const char *data, size_t count);
+
+/**
+ * Get length of the longest suffix of \p count characters starting at \p data without set members
+ * (so the last member has index `count - result - 1`, \p count is returned if there are none).
+ */
+size_t charset_rcspan(const charset_t *set, const char *data, size_t count);
@@ -0,0 +1,477 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+/**
+ * @file
+ * @brief Generic hash table with quadratic probing for a single writer and multiple lock-free readers.
+ * @details
+ * One thread (the writer) modifies the hash table, any number of other threads can look up elements at the same time
+ * without taking locks. Lookups never wait for the writer and never retry.
+ *
+ * The slot state bytes are atomic: the writer fills key and value of an empty slot and only then publishes it
+ * (release store), readers load slot states with acquire semantics. A published slot is never modified again:
+ * deleted slots are not reused and an update of an existing key inserts a new element further along its probe
+ * sequence before deleting the old one, so readers observe either the old value or the new one.
+ *
+ * Deleted slots are reclaimed by a rehash which allocates new arrays and atomically swaps them in.
+ * Old arrays are freed using epoch-based reclamation: each reader thread registers itself once
+ * (up to CHT_MAX_READERS threads) and each lookup publishes the current epoch for its duration, so the writer frees
+ * old arrays only after all readers that could have seen them have finished their lookups.
+ *
+ * Keys and values are copied out by lookups. If they point to other memory (e.g. string keys), the writer must not
+ * free it while it can still be accessed by readers.
+ *
+ * Example of usage:
+ * \code
+ * CHT(int, int) ht; int absent;
+ * cht_init(ht);
+ *
+ * // Writer thread
+ * cht_put_int(ht, int, 10, 100, absent);
+ *
+ * // Reader thread
+ * int reader = cht_register_reader(ht);
+ * int value; bool found;
+ * cht_get_int(ht, int, reader, 10, value, found);
+ * cht_unregister_reader(ht, reader);
+ *
+ * cht_destroy(ht);
+ * \endcode
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "roundup.h"
+
+/** Maximal number of registered reader threads of a concurrent hash table */
+#ifndef CHT_MAX_READERS
+#define CHT_MAX_READERS 64
+#endif
+
+/** Maximum load factor of a concurrent hash table (deleted elements are counted too) */
+#define CHT_MAX_LOAD 0.75f
+
+/** Concurrent hash table arrays. Normally shouldn't be accessed directly from user code. */
+typedef struct cht_arrays {
+	size_t capacity; //!< Number of slots (a power of 2).
+	atomic_uchar *flags; //!< Slot states (0 - empty, 1 - occupied, 2 - deleted).
+	void *keys; //!< Keys.
+	void *values; //!< Values.
+	uint_fast64_t retire_epoch; //!< Epoch when the arrays were replaced.
+	struct cht_arrays *next; //!< Next retired arrays.
+} cht_arrays_t;
+
+/** Reader state of a concurrent hash table. Normally shouldn't be accessed directly from user code. */
+typedef struct cht_reader {
+	atomic_uint_fast64_t epoch; //!< Epoch observed by the current lookup (0 - not in a lookup).
+	atomic_bool registered; //!< True if the reader is used by some thread.
+	char padding[64 - sizeof(atomic_uint_fast64_t) - sizeof(atomic_bool)]; //!< Keeps readers on separate cache lines.
+} cht_reader_t;
+
+/** Epoch-based reclamation state of a concurrent hash table. Normally shouldn't be accessed directly from user code. */
+typedef struct cht_epoch {
+	atomic_uint_fast64_t epoch; //!< Global epoch (starts from 1).
+	cht_arrays_t *retired; //!< Replaced arrays that can still be accessed by readers.
+	cht_reader_t readers[CHT_MAX_READERS]; //!< Reader states.
+} cht_epoch_t;
+
+/** A concurrent hash table struct definition */
+#define CHT(key_type, value_type) struct { \
+	_Atomic(cht_arrays_t*) arrays; \
+	size_t size, used, max_used; \
+	cht_epoch_t epoch; \
+}
+
+/** Initialize epoch-based reclamation state. Normally shouldn't be used directly from user code. */
+static inline void cht_epoch_init(cht_epoch_t *e) {
+	atomic_init(&e->epoch, 1);
+	e->retired = NULL;
+	for (size_t i = 0; i < CHT_MAX_READERS; i++) {
+		atomic_init(&e->readers[i].epoch, 0);
+		atomic_init(&e->readers[i].registered, false);
+	}
+}
+
+/** Free concurrent hash table arrays. Normally shouldn't be used directly from user code. */
+static inline void cht_arrays_free(cht_arrays_t *arrays) {
+	if (!arrays) return;
+	free(arrays->values);
+	free(arrays->keys);
+	free(arrays->flags);
+	free(arrays);
+}
+
+/**
+ * Allocate concurrent hash table arrays with all slots empty.
+ * Returns NULL on memory allocation failure. Normally shouldn't be used directly from user code.
+ */
+static inline cht_arrays_t *cht_arrays_alloc(size_t capacity, size_t key_size, size_t value_size) {
+	if (capacity > SIZE_MAX / key_size || capacity > SIZE_MAX / value_size) {
+		return NULL;
+	}
+	cht_arrays_t *arrays = malloc(sizeof(cht_arrays_t));
+	if (!arrays) {
+		return NULL;
+	}
+	arrays->capacity = capacity;
+	arrays->flags = malloc(capacity * sizeof(atomic_uchar));
+	arrays->keys = malloc(capacity * key_size);
+	arrays->values = malloc(capacity * value_size);
+	arrays->next = NULL;
+	if (!arrays->flags || !arrays->keys || !arrays->values) {
+		cht_arrays_free(arrays);
+		return NULL;
+	}
+	for (size_t i = 0; i < capacity; i++) {
+		atomic_init(&arrays->flags[i], 0);
+	}
+	return arrays;
+}
+
+/**
+ * Free all retired arrays which can't be accessed by readers anymore.
+ * Returns true if there are no retired arrays left. Normally shouldn't be used directly from user code.
+ */
+static inline bool cht_epoch_collect(cht_epoch_t *e) {
+	uint_fast64_t min_epoch = UINT_FAST64_MAX;
+	for (size_t i = 0; i < CHT_MAX_READERS; i++) {
+		uint_fast64_t epoch = atomic_load(&e->readers[i].epoch);
+		if (epoch && epoch < min_epoch) {
+			min_epoch = epoch;
+		}
+	}
+	cht_arrays_t **link = &e->retired;
+	while (*link) {
+		cht_arrays_t *arrays = *link;
+		if (arrays->retire_epoch < min_epoch) { // All active readers have started after the replacement
+			*link = arrays->next;
+			cht_arrays_free(arrays);
+		} else {
+			link = &arrays->next;
+		}
+	}
+	return !e->retired;
+}
+
+/** Retire replaced arrays. Normally shouldn't be used directly from user code. */
+static inline void cht_epoch_retire(cht_epoch_t *e, cht_arrays_t *arrays) {
+	if (!arrays) return;
+	arrays->retire_epoch = atomic_fetch_add(&e->epoch, 1);
+	arrays->next = e->retired;
+	e->retired = arrays;
+	cht_epoch_collect(e);
+}
+
+/** Mark the beginning of a lookup by a reader. Normally shouldn't be used directly from user code. */
+static inline void cht_epoch_enter(cht_epoch_t *e, int reader) {
+	atomic_store(&e->readers[reader].epoch, atomic_load(&e->epoch));
+}
+
+/** Mark the end of a lookup by a reader. Normally shouldn't be used directly from user code. */
+static inline void cht_epoch_exit(cht_epoch_t *e, int reader) {
+	atomic_store_explicit(&e->readers[reader].epoch, 0, memory_order_release);
+}
+
+/** Register a reader thread. Returns a reader index or -1 if there are too many readers. Thread-safe. */
+static inline int cht_epoch_register(cht_epoch_t *e) {
+	for (int i = 0; i < CHT_MAX_READERS; i++) {
+		bool expected = false;
+		if (atomic_compare_exchange_strong(&e->readers[i].registered, &expected, true)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/** Initialize a empty concurrent hash table (no memory allocation performed). Not thread-safe. */
+#define cht_init(h) do { \
+	atomic_init(&(h).arrays, NULL); \
+	(h).size = (h).used = (h).max_used = 0; \
+	cht_epoch_init(&(h).epoch); \
+} while (0)
+
+/** Destroy the concurrent hash table. There must be no readers accessing it. */
+#define cht_destroy(h) do { \
+	cht_arrays_free(atomic_load(&(h).arrays)); \
+	while ((h).epoch.retired) { \
+		cht_arrays_t *cht_next = (h).epoch.retired->next; \
+		cht_arrays_free((h).epoch.retired); \
+		(h).epoch.retired = cht_next; \
+	} \
+} while (0)
+
+/** Get number of elements stored in the concurrent hash table (only for the writer). */
+#define cht_size(h) ((h).size)
+
+/** Get number of slots of the concurrent hash table (only for the writer). */
+#define cht_capacity(h) (atomic_load_explicit(&(h).arrays, memory_order_relaxed) ? \
+	atomic_load_explicit(&(h).arrays, memory_order_relaxed)->capacity : 0)
+
+/**
+ * Register a reader thread and return its index which must be passed to lookups (-1 if there are too many readers).
+ * A reader index must be used only by one thread at the same time. Thread-safe.
+ */
+#define cht_register_reader(h) cht_epoch_register(&(h).epoch)
+
+/** Unregister a reader thread (it must not be in the middle of a lookup). Thread-safe. */
+#define cht_unregister_reader(h, reader) \
+atomic_store(&(h).epoch.readers[(reader)].registered, false)
+
+/**
+ * Free arrays replaced by previous rehashes if they can't be accessed by readers anymore (only for the writer).
+ * Returns true if all replaced arrays have been freed. Rehash calls it automatically.
+ */
+#define cht_collect(h) cht_epoch_collect(&(h).epoch)
+
+/** Compute how many slots of a concurrent hash table with \p capacity can be occupied. */
+static inline size_t cht_max_used_for(size_t capacity) {
+	size_t limit = (size_t) ((double) capacity * CHT_MAX_LOAD);
+	if (limit >= capacity) {
+		limit = capacity - 1; // At least one slot must be empty to stop probing
+	}
+	if (!limit && capacity > 1) {
+		limit = 1;
+	}
+	return limit;
+}
+
+/**
+ * Compute minimal concurrent hash table capacity (a power of 2) able to hold \p count elements.
+ * Returns 0 in case of integer overflow.
+ */
+static inline size_t cht_capacity_for(size_t count) {
+	size_t capacity = count;
+	roundupsize(capacity);
+	if (capacity < count) { // Integer overflow
+		return 0;
+	}
+	while (cht_max_used_for(capacity) < count) {
+		if (capacity > SIZE_MAX / 2) { // Integer overflow
+			return 0;
+		}
+		capacity <<= 1;
+	}
+	return capacity;
+}
+
+/**
+ * Rebuild concurrent hash table with exactly \p new_capacity slots (must be a power of 2 able to hold all elements)
+ * and publish new arrays to readers (only for the writer).
+ * Success will be assigned to false in case of memory allocation failure.
+ */
+#define cht_rehash(h, key_type, value_type, new_capacity, success, hash_func) do { \
+	size_t cht_rehash_capacity = (new_capacity); \
+	cht_arrays_t *cht_new_arrays = cht_arrays_alloc(cht_rehash_capacity, sizeof(key_type), sizeof(value_type)); \
+	if (!cht_new_arrays) { \
+		(success) = false; \
+		break; \
+	} \
+	cht_arrays_t *cht_old_arrays = atomic_load_explicit(&(h).arrays, memory_order_relaxed); \
+	size_t cht_rehash_mask = cht_rehash_capacity - 1; \
+	for (size_t cht_i = 0; cht_old_arrays && cht_i < cht_old_arrays->capacity; cht_i++) { \
+		if (atomic_load_explicit(&cht_old_arrays->flags[cht_i], memory_order_relaxed) != 1) continue; \
+		key_type cht_rehash_key = ((key_type*) cht_old_arrays->keys)[cht_i]; \
+		size_t cht_j = hash_func(cht_rehash_key) & cht_rehash_mask; \
+		size_t cht_step = 0; \
+		while (atomic_load_explicit(&cht_new_arrays->flags[cht_j], memory_order_relaxed)) { \
+			cht_j = (cht_j + ++cht_step) & cht_rehash_mask; \
+		} \
+		atomic_store_explicit(&cht_new_arrays->flags[cht_j], 1, memory_order_relaxed); \
+		((key_type*) cht_new_arrays->keys)[cht_j] = cht_rehash_key; \
+		((value_type*) cht_new_arrays->values)[cht_j] = ((value_type*) cht_old_arrays->values)[cht_i]; \
+	} \
+	atomic_store(&(h).arrays, cht_new_arrays); \
+	cht_epoch_retire(&(h).epoch, cht_old_arrays); \
+	(h).used = (h).size; \
+	(h).max_used = cht_max_used_for(cht_rehash_capacity); \
+	(success) = true; \
+} while (0)
+
+/**
+ * Resize concurrent hash table to be able to hold at least new_capacity elements (only for the writer).
+ * Success will be assigned to false in case of memory allocation failure.
+ */
+#define cht_reserve(h, key_type, value_type, new_capacity, success, hash_func) do { \
+	if ((new_capacity) <= (h).max_used) { \
+		(success) = true; \
+		break; \
+	} \
+	size_t cht_reserve_capacity = cht_capacity_for((new_capacity)); \
+	if (!cht_reserve_capacity) { /* Integer overflow */ \
+		(success) = false; \
+		break; \
+	} \
+	cht_rehash((h), key_type, value_type, cht_reserve_capacity, (success), hash_func); \
+} while (0)
+
+/**
+ * Perform concurrent hash table lookup by a registered \p reader (see cht_register_reader()).
+ * If the element is found, its value is copied into \p value and \p found is assigned to true.
+ * Can be called from any number of reader threads concurrently with the writer.
+ */
+#define cht_get(h, key_type, value_type, reader, key, value, found, hash_func, eq_func) do { \
+	cht_epoch_enter(&(h).epoch, (reader)); \
+	cht_arrays_t *cht_get_arrays = atomic_load(&(h).arrays); \
+	(found) = false; \
+	if (cht_get_arrays) { \
+		size_t cht_get_mask = cht_get_arrays->capacity - 1; \
+		size_t cht_get_index = hash_func(key) & cht_get_mask; \
+		size_t cht_get_step = 0; \
+		unsigned char cht_get_flag; \
+		while ((cht_get_flag = atomic_load_explicit(&cht_get_arrays->flags[cht_get_index], memory_order_acquire))) { \
+			if (cht_get_flag == 1 && eq_func(((key_type*) cht_get_arrays->keys)[cht_get_index], (key))) { \
+				(value) = ((value_type*) cht_get_arrays->values)[cht_get_index]; \
+				(found) = true; \
+				break; \
+			} \
+			cht_get_index = (cht_get_index + ++cht_get_step) & cht_get_mask; \
+		} \
+	} \
+	cht_epoch_exit(&(h).epoch, (reader)); \
+} while (0)
+
+/**
+ * Insert an element inside the concurrent hash table or replace the value of an existing one (only for the writer).
+ *
+ * \p absent specifies the operation result. 1 means that the element was successfully inserted.
+ * 0 means that the element with given key was already existed in the hash table and its value was replaced,
+ * -1 means that memory allocation failure happened (the hash table remains untouched).
+ */
+#define cht_put(h, key_type, value_type, key, value, absent, hash_func, eq_func) do { \
+	if ((h).used >= (h).max_used) { \
+		size_t cht_put_capacity = cht_capacity(h); \
+		if ((h).size >= (h).max_used / 2) { /* Otherwise just drop deleted elements */ \
+			cht_put_capacity = cht_capacity_for((h).size ? (h).size + 1 : 2); \
+			if (cht_put_capacity <= cht_capacity(h)) { \
+				cht_put_capacity = cht_capacity(h) <= SIZE_MAX / 2 ? cht_capacity(h) << 1 : 0; \
+			} \
+			if (!cht_put_capacity) { /* Integer overflow */ \
+				(absent) = -1; \
+				break; \
+			} \
+		} \
+		bool cht_put_success; \
+		cht_rehash((h), key_type, value_type, cht_put_capacity, cht_put_success, hash_func); \
+		if (!cht_put_success) { \
+			(absent) = -1; \
+			break; \
+		} \
+	} \
+	cht_arrays_t *cht_put_arrays = atomic_load_explicit(&(h).arrays, memory_order_relaxed); \
+	size_t cht_put_mask = cht_put_arrays->capacity - 1; \
+	size_t cht_put_index = hash_func(key) & cht_put_mask; \
+	size_t cht_put_step = 0; \
+	size_t cht_put_old = cht_put_arrays->capacity; \
+	unsigned char cht_put_flag; \
+	while ((cht_put_flag = atomic_load_explicit(&cht_put_arrays->flags[cht_put_index], memory_order_relaxed))) { \
+		if (cht_put_flag == 1 && cht_put_old == cht_put_arrays->capacity && \
+				eq_func(((key_type*) cht_put_arrays->keys)[cht_put_index], (key))) { \
+			cht_put_old = cht_put_index; \
+		} \
+		cht_put_index = (cht_put_index + ++cht_put_step) & cht_put_mask; \
+	} \
+	((key_type*) cht_put_arrays->keys)[cht_put_index] = (key); \
+	((value_type*) cht_put_arrays->values)[cht_put_index] = (value); \
+	atomic_store_explicit(&cht_put_arrays->flags[cht_put_index], 1, memory_order_release); \
+	(h).used++; \
+	if (cht_put_old != cht_put_arrays->capacity) { \
+		atomic_store_explicit(&cht_put_arrays->flags[cht_put_old], 2, memory_order_release); \
+		(absent) = 0; \
+	} else { \
+		(h).size++; \
+		(absent) = 1; \
+	} \
+} while (0)
+
+/**
+ * Delete an element from the concurrent hash table by its key (only for the writer).
+ * \p deleted will be assigned to true if the element was found.
+ */
+#define cht_delete(h, key_type, key, deleted, hash_func, eq_func) do { \
+	cht_arrays_t *cht_delete_arrays = atomic_load_explicit(&(h).arrays, memory_order_relaxed); \
+	(deleted) = false; \
+	if (!cht_delete_arrays) break; \
+	size_t cht_delete_mask = cht_delete_arrays->capacity - 1; \
+	size_t cht_delete_index = hash_func(key) & cht_delete_mask; \
+	size_t cht_delete_step = 0; \
+	unsigned char cht_delete_flag; \
+	while ((cht_delete_flag = atomic_load_explicit(&cht_delete_arrays->flags[cht_delete_index], memory_order_relaxed))) { \
+		if (cht_delete_flag == 1 && eq_func(((key_type*) cht_delete_arrays->keys)[cht_delete_index], (key))) { \
+			atomic_store_explicit(&cht_delete_arrays->flags[cht_delete_index], 2, memory_order_release); \
+			(h).size--; \
+			(deleted) = true; \
+			break; \
+		} \
+		cht_delete_index = (cht_delete_index + ++cht_delete_step) & cht_delete_mask; \
+	} \
+} while (0)
+
+/** Default hash implementation for integers */
+#define cht_int_hash(key) ((size_t) (key))
+
+/** Default equality implementation for integers */
+#define cht_int_eq(a, b) ((a) == (b))
+
+/** Reserve implementation for the concurrent hash table with integer keys */
+#define cht_reserve_int(h, value_type, new_capacity, success) \
+cht_reserve((h), int, value_type, (new_capacity), (success), cht_int_hash)
+
+/** Lookup implementation for the concurrent hash table with integer keys */
+#define cht_get_int(h, value_type, reader, key, value, found) \
+cht_get((h), int, value_type, (reader), (key), (value), (found), cht_int_hash, cht_int_eq)
+
+/** Insertion implementation for the concurrent hash table with integer keys */
+#define cht_put_int(h, value_type, key, value, absent) \
+cht_put((h), int, value_type, (key), (value), (absent), cht_int_hash, cht_int_eq)
+
+/** Deletion implementation for the concurrent hash table with integer keys */
+#define cht_delete_int(h, key, deleted) \
+cht_delete((h), int, (key), (deleted), cht_int_hash, cht_int_eq)
+
+/** Default hash implementation for strings */
+static inline size_t cht_str_hash(const char *s) {
+	size_t h = (size_t) *s;
+	if (h) {
+		for(++s; *s; ++s) {
+			h = (h << 5) - h + (size_t) *s;
+		}
+	}
+	return h;
+}
+
+/** Default equality implementation for strings */
+#define cht_str_eq(a, b) (strcmp((a), (b)) == 0)
+
+/** Reserve implementation for the concurrent hash table with string keys */
+#define cht_reserve_str(h, value_type, new_capacity, success) \
+cht_reserve((h), const char*, value_type, (new_capacity), (success), cht_str_hash)
+
+/** Lookup implementation for the concurrent hash table with string keys */
+#define cht_get_str(h, value_type, reader, key, value, found) \
+cht_get((h), const char*, value_type, (reader), (key), (value), (found), cht_str_hash, cht_str_eq)
+
+/** Insertion implementation for the concurrent hash table with string keys */
+#define cht_put_str(h, value_type, key, value, absent) \
+cht_put((h), const char*, value_type, (key), (value), (absent), cht_str_hash, cht_str_eq)
+
+/** Deletion implementation for the concurrent hash table with string keys */
+#define cht_delete_str(h, key, deleted) \
+cht_delete((h), const char*, (key), (deleted), cht_str_hash, cht_str_eq)
@@ -39,6 +39,14 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  * 
  * dynstr explicitly stores its length, so size computation has O(1) complexity. Also they can allocate more memory than needed
  * while you are doing multiple appending, so it might reduce number of total memory allocations.
+ * The header width depends on the string capacity (3 bytes for strings shorter than 256 characters), so short strings
+ * don't pay for 64-bit size and capacity fields.
+ *
+ * A dynstr can be made reference-counted with dynstr_make_refcounted(), then dynstr_retain() and dynstr_dup() share
+ * it without copying and modifying functions copy it only while it has other references (copy-on-write).
+ *
+ * Short-lived strings can be allocated in a dynstr_arena_t (see dynstr_arena_new()) and dropped all at once
+ * by dynstr_arena_reset() instead of a separate `free` for each of them. All dynstr functions accept arena strings.
  *
  * All dynstr instances must be freed using a special function dynstr_free(). You cannot pass dynstr instance to a usual libc free()
  * function, because dynstr has a special header just before it's character data.
@@ -56,6 +64,8 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include "charset.h"
 
 #ifndef _MSC_VER
 #define DYNSTR_FMT_FUNC(fmt_index, first_arg_index) __attribute__((format(printf, fmt_index, first_arg_index)))
@@ -76,20 +86,222 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 /** A typedef for dynamic strings (just an alias for `char*`). */
 typedef char *dynstr;
 
-/** A header that prepended to all dynstr. Normally shouldn't be accessed directly from user code. */
-typedef struct dynstr_header {
-	size_t size; //!< String length.
-	size_t capacity; //!< String memory block length.
-} dynstr_header_t;
+/**
+ * @name Dynamic string headers
+ * A header is prepended to all dynstr. Its width depends on the string capacity: strings shorter than 256 characters
+ * use a 3 byte header with 8-bit size and capacity, longer strings use 16, 32 or 64-bit fields. The last byte of
+ * every header is the type byte (stored just before the character data) which selects the header width,
+ * so size and capacity are still available in constant time. Normally headers shouldn't be accessed directly
+ * from user code.
+ * @{
+ */
+
+#define DYNSTR_TYPE_8 0 //!< Header with 8-bit size and capacity.
+#define DYNSTR_TYPE_16 1 //!< Header with 16-bit size and capacity.
+#define DYNSTR_TYPE_32 2 //!< Header with 32-bit size and capacity.
+#define DYNSTR_TYPE_64 3 //!< Header with 64-bit size and capacity.
+#define DYNSTR_TYPE_MASK 3 //!< Bits of the type byte which hold the header type (the rest are reserved for flags).
+#define DYNSTR_FLAG_REFCOUNTED 4 //!< The string is reference-counted (the counter is stored before the header).
+#define DYNSTR_FLAG_ARENA 8 //!< The string is allocated in an arena (a pointer to the arena is stored before the header).
+
+#ifdef _MSC_VER
+#pragma pack(push, 1)
+#define DYNSTR_PACKED
+#else
+#define DYNSTR_PACKED __attribute__((packed))
+#endif
+
+/** A header of dynstr with capacity up to `UINT8_MAX`. */
+typedef struct DYNSTR_PACKED dynstr_header8 {
+	uint8_t size; //!< String length.
+	uint8_t capacity; //!< String memory block length.
+	uint8_t type; //!< Header type and flags.
+} dynstr_header8_t;
+
+/** A header of dynstr with capacity up to `UINT16_MAX`. */
+typedef struct DYNSTR_PACKED dynstr_header16 {
+	uint16_t size; //!< String length.
+	uint16_t capacity; //!< String memory block length.
+	uint8_t type; //!< Header type and flags.
+} dynstr_header16_t;
+
+/** A header of dynstr with capacity up to `UINT32_MAX`. */
+typedef struct DYNSTR_PACKED dynstr_header32 {
+	uint32_t size; //!< String length.
+	uint32_t capacity; //!< String memory block length.
+	uint8_t type; //!< Header type and flags.
+} dynstr_header32_t;
+
+/** A header of dynstr with any capacity. */
+typedef struct DYNSTR_PACKED dynstr_header64 {
+	uint64_t size; //!< String length.
+	uint64_t capacity; //!< String memory block length.
+	uint8_t type; //!< Header type and flags.
+} dynstr_header64_t;
+
+#ifdef _MSC_VER
+#pragma pack(pop)
+#endif
 
-/** Obtain a pointer to a dynamic string header. Normally shouldn't be accessed directly from user code. */
-#define dynstr_header(s) (((dynstr_header_t*) (s)) - 1)
+/** Get the type byte of a dynamic string (header type and flags). */
+#define dynstr_type_byte(s) (((unsigned char*) (s))[-1])
+
+/** Get the header type of a dynamic string. */
+#define dynstr_type(s) (dynstr_type_byte(s) & DYNSTR_TYPE_MASK)
+
+/** Obtain a pointer to a dynamic string header of the specified width (8, 16, 32 or 64). */
+#define dynstr_header(s, bits) (((dynstr_header ## bits ## _t*) (char*) (s)) - 1)
+
+/** Get size of a header of the specified type. */
+static inline size_t dynstr_type_header_size(unsigned type) {
+	switch (type) {
+		case DYNSTR_TYPE_8: return sizeof(dynstr_header8_t);
+		case DYNSTR_TYPE_16: return sizeof(dynstr_header16_t);
+		case DYNSTR_TYPE_32: return sizeof(dynstr_header32_t);
+		default: return sizeof(dynstr_header64_t);
+	}
+}
+
+/** Get the smallest header type which can hold the specified capacity. */
+static inline unsigned dynstr_capacity_type(size_t capacity) {
+	if (capacity <= UINT8_MAX) return DYNSTR_TYPE_8;
+	if (capacity <= UINT16_MAX) return DYNSTR_TYPE_16;
+	if (capacity <= UINT32_MAX) return DYNSTR_TYPE_32;
+	return DYNSTR_TYPE_64;
+}
+
+/** Get size of a dynamic string header. */
+#define dynstr_header_size(s) dynstr_type_header_size(dynstr_type(s))
+
+/**
+ * Write a header of the specified type and flags just before \p s.
+ *
+ * The memory for the header must be already allocated and \p capacity must fit into the header type.
+ */
+static inline void dynstr_init_header(char *s, unsigned type_byte, size_t size, size_t capacity) {
+	switch (type_byte & DYNSTR_TYPE_MASK) {
+		case DYNSTR_TYPE_8:
+			dynstr_header(s, 8)->size = (uint8_t) size;
+			dynstr_header(s, 8)->capacity = (uint8_t) capacity;
+			break;
+		case DYNSTR_TYPE_16:
+			dynstr_header(s, 16)->size = (uint16_t) size;
+			dynstr_header(s, 16)->capacity = (uint16_t) capacity;
+			break;
+		case DYNSTR_TYPE_32:
+			dynstr_header(s, 32)->size = (uint32_t) size;
+			dynstr_header(s, 32)->capacity = (uint32_t) capacity;
+			break;
+		default:
+			dynstr_header(s, 64)->size = size;
+			dynstr_header(s, 64)->capacity = capacity;
+			break;
+	}
+	dynstr_type_byte(s) = (unsigned char) type_byte;
+}
+
+/** Obtain a pointer to the reference counter of a reference-counted dynamic string. */
+#define dynstr_refcount_ptr(s) (((size_t*) ((char*) (s) - dynstr_header_size(s))) - 1)
+
+/** Obtain a pointer to the arena pointer of a dynamic string allocated in an arena. */
+#define dynstr_arena_ptr(s) (((struct dynstr_arena**) ((char*) (s) - dynstr_header_size(s))) - 1)
+
+/** @} */
 
 /** Get dynamic string length. Constant time operation. */
-#define dynstr_size(s) (dynstr_header(s)->size)
+static inline size_t dynstr_size(const char *s) {
+	switch (dynstr_type(s)) {
+		case DYNSTR_TYPE_8: return dynstr_header(s, 8)->size;
+		case DYNSTR_TYPE_16: return dynstr_header(s, 16)->size;
+		case DYNSTR_TYPE_32: return dynstr_header(s, 32)->size;
+		default: return (size_t) dynstr_header(s, 64)->size;
+	}
+}
 
 /** Get dynamic string memory block length (how many characters can string hold without reallocation). */
-#define dynstr_capacity(s) (dynstr_header(s)->capacity)
+static inline size_t dynstr_capacity(const char *s) {
+	switch (dynstr_type(s)) {
+		case DYNSTR_TYPE_8: return dynstr_header(s, 8)->capacity;
+		case DYNSTR_TYPE_16: return dynstr_header(s, 16)->capacity;
+		case DYNSTR_TYPE_32: return dynstr_header(s, 32)->capacity;
+		default: return (size_t) dynstr_header(s, 64)->capacity;
+	}
+}
+
+/**
+ * Get number of references to a dynamic string (always 1 for strings which are not reference-counted).
+ */
+static inline size_t dynstr_refcount(const char *s) {
+	return (dynstr_type_byte(s) & DYNSTR_FLAG_REFCOUNTED) ? *dynstr_refcount_ptr(s) : 1;
+}
+
+/**
+ * Set dynamic string length without touching its contents (the NULL character isn't written).
+ *
+ * \p size must not exceed the string capacity. The string must not be shared (see dynstr_unshare()).
+ */
+static inline void dynstr_set_size(char *s, size_t size) {
+	switch (dynstr_type(s)) {
+		case DYNSTR_TYPE_8: dynstr_header(s, 8)->size = (uint8_t) size; break;
+		case DYNSTR_TYPE_16: dynstr_header(s, 16)->size = (uint16_t) size; break;
+		case DYNSTR_TYPE_32: dynstr_header(s, 32)->size = (uint32_t) size; break;
+		default: dynstr_header(s, 64)->size = size; break;
+	}
+}
+
+/** A chunk of arena memory (followed by its characters). */
+typedef struct dynstr_arena_chunk {
+	struct dynstr_arena_chunk *next; //!< Next chunk (chunks are kept for reuse after a reset).
+	size_t capacity; //!< Number of bytes in the chunk.
+} dynstr_arena_chunk_t;
+
+/**
+ * An arena for dynamic strings which are freed all at once.
+ *
+ * Strings are allocated one after another in large chunks, dynstr_free() for them does nothing (except
+ * returning the memory of the last allocated string). A string which is the last allocation of the arena grows
+ * in place, others are copied to the end of the arena when they grow. dynstr_arena_reset() drops all strings
+ * in constant time and keeps the chunks for reuse. Arena strings can't be reference-counted, dynstr_retain() and
+ * dynstr_dup() copy them into the same arena. An arena is not thread-safe.
+ */
+typedef struct dynstr_arena {
+	dynstr_arena_chunk_t *head; //!< First chunk or NULL.
+	dynstr_arena_chunk_t *current; //!< Chunk used for new allocations or NULL.
+	char *top; //!< First free byte of the current chunk.
+	char *end; //!< End of the current chunk.
+	char *last; //!< Memory block of the last allocated string (it can grow in place) or NULL.
+	size_t chunk_size; //!< Minimal size of new chunks.
+} dynstr_arena_t;
+
+/** Default size of arena chunks. */
+#define DYNSTR_ARENA_DEFAULT_CHUNK_SIZE 65536
+
+/** Initialize an empty arena (\p chunk_size is the minimal size of its memory chunks, 0 means the default). */
+void dynstr_arena_init(dynstr_arena_t *arena, size_t chunk_size);
+
+/** Free all memory of an arena (all its strings become invalid). */
+void dynstr_arena_destroy(dynstr_arena_t *arena);
+
+/** Drop all strings allocated in an arena in constant time, keeping its memory for new strings. */
+void dynstr_arena_reset(dynstr_arena_t *arena);
+
+/** Get the arena of a dynamic string (NULL if it's allocated on the heap). */
+static inline dynstr_arena_t *dynstr_arena_of(const char *s) {
+	return (dynstr_type_byte(s) & DYNSTR_FLAG_ARENA) ? *dynstr_arena_ptr(s) : NULL;
+}
+
+/** Allocate an empty dynamic string with specified capacity in an arena. */
+dynstr dynstr_arena_alloc(dynstr_arena_t *arena, size_t capacity) DYNSTR_WARN_UNUSED;
+
+/** Allocate a dynamic string from provided character array in an arena (uninitialized if \p data is `NULL`). */
+dynstr dynstr_arena_new_chars(dynstr_arena_t *arena, const char *data, size_t count) DYNSTR_WARN_UNUSED;
+
+/** Allocate a dynamic string copying contents from NULL-terminated string in an arena. */
+dynstr dynstr_arena_new(dynstr_arena_t *arena, const char *data) DYNSTR_WARN_UNUSED;
+
+/** Allocate a dynamic string using printf-formatted contents in an arena. */
+dynstr dynstr_arena_new_printf(dynstr_arena_t *arena, DYNSTR_FMT_ARG const char *fmt, ...) DYNSTR_FMT_FUNC(2, 3)
+	DYNSTR_WARN_UNUSED;
 
 /** Allocate a empty dynamic string with specified capacity */
 dynstr dynstr_alloc(size_t capacity) DYNSTR_WARN_UNUSED;
@@ -108,13 +320,51 @@ dynstr dynstr_new_printf(DYNSTR_FMT_ARG const char *fmt, ...) DYNSTR_FMT_FUNC(1,
 /** Allocate a dynamic string using printf-formatted contents using `va_list` arguments. */
 dynstr dynstr_new_vprintf(const char *fmt, va_list args) DYNSTR_WARN_UNUSED;
 
-/** Allocate a dynamic string copying existing dynamic string */
+/**
+ * Allocate a dynamic string copying existing dynamic string.
+ *
+ * Reference-counted strings aren't copied, a new reference is returned instead (see dynstr_retain()).
+ */
 dynstr dynstr_dup(dynstr s) DYNSTR_WARN_UNUSED;
 
-/** Free dynamic string. All dynamic strings should be freed by this function. Accepts NULL (as usual `free`). */
+/**
+ * Free dynamic string. All dynamic strings should be freed by this function. Accepts NULL (as usual `free`).
+ *
+ * For reference-counted strings drops one reference, the memory is freed when the last reference is dropped.
+ */
 void dynstr_free(dynstr s);
 
-/** Shrink dynamic string memory block to its actual length. */
+/**
+ * Make a dynamic string reference-counted with a single reference (opt-in, strings are not reference-counted
+ * by default).
+ *
+ * References to a reference-counted string are shared by dynstr_retain() and dynstr_dup() without copying.
+ * All functions which modify a string copy it first if it has other references (copy-on-write),
+ * so modifications are never visible through other references. Reference counters are not atomic,
+ * so a string can't be shared between threads without external synchronization.
+ * Strings allocated in an arena are returned unchanged.
+ */
+dynstr dynstr_make_refcounted(dynstr s) DYNSTR_WARN_UNUSED;
+
+/**
+ * Get a new reference to a dynamic string.
+ *
+ * If the string is reference-counted, increments its reference counter and returns the same pointer,
+ * otherwise returns a copy. The reference must be dropped by dynstr_release() or dynstr_free().
+ */
+dynstr dynstr_retain(dynstr s) DYNSTR_WARN_UNUSED;
+
+/** Drop a reference to a dynamic string (the same as dynstr_free()). */
+void dynstr_release(dynstr s);
+
+/**
+ * Make sure that a dynamic string is not shared with other references, copying it if needed.
+ *
+ * All modifying functions call it implicitly, use it before modifying string characters directly.
+ */
+dynstr dynstr_unshare(dynstr s) DYNSTR_WARN_UNUSED;
+
+/** Shrink dynamic string memory block to its actual length (does nothing for shared strings). */
 dynstr dynstr_shrink(dynstr s) DYNSTR_WARN_UNUSED;
 
 /**
@@ -144,9 +394,9 @@ dynstr dynstr_resize(dynstr s, size_t size) DYNSTR_WARN_UNUSED;
 /**
  * Set dynamic string size to zero.
  *
- * Guaranteed to not trigger reallocation.
+ * Guaranteed to not trigger reallocation unless the string is shared.
  */
-void dynstr_clear(dynstr s);
+dynstr dynstr_clear(dynstr s) DYNSTR_WARN_UNUSED;
 
 /** Assign dynamic string from a character array. */
 dynstr dynstr_set_chars(dynstr s, const char *data, size_t count) DYNSTR_WARN_UNUSED;
@@ -192,22 +442,37 @@ dynstr dynstr_vprintf(dynstr dest, const char *fmt, va_list args) DYNSTR_WARN_UN
  *
  * Both arguments can be negative (in this case they counted relatively to the string end).
  */
-void dynstr_range(dynstr s, ptrdiff_t start, ptrdiff_t count);
+dynstr dynstr_range(dynstr s, ptrdiff_t start, ptrdiff_t count) DYNSTR_WARN_UNUSED;
 
 /**
  * In-place trims first characters from a provided character set (NULL-terminated).
  */
-void dynstr_trim_start(dynstr s, const char *chars);
+dynstr dynstr_trim_start(dynstr s, const char *chars) DYNSTR_WARN_UNUSED;
 
 /**
  * In-place trims last characters from a provided character set (NULL-terminated).
  */
-void dynstr_trim_end(dynstr s, const char *chars);
+dynstr dynstr_trim_end(dynstr s, const char *chars) DYNSTR_WARN_UNUSED;
 
 /**
  * In-place trims first and last characters from a provided character set (NULL-terminated).
  */
-void dynstr_trim(dynstr s, const char *chars);
+dynstr dynstr_trim(dynstr s, const char *chars) DYNSTR_WARN_UNUSED;
+
+/**
+ * In-place trims first characters which belong to a character set.
+ */
+dynstr dynstr_trim_start_charset(dynstr s, const charset_t *set) DYNSTR_WARN_UNUSED;
+
+/**
+ * In-place trims last characters which belong to a character set.
+ */
+dynstr dynstr_trim_end_charset(dynstr s, const charset_t *set) DYNSTR_WARN_UNUSED;
+
+/**
+ * In-place trims first and last characters which belong to a character set.
+ */
+dynstr dynstr_trim_charset(dynstr s, const charset_t *set) DYNSTR_WARN_UNUSED;
 
 /**
  * Compare two dynamic strings.
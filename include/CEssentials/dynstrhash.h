@@ -0,0 +1,170 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+/**
+ * @file
+ * @brief Dynamic strings as hash table and hash set keys.
+ * @details
+ * Hash and equality functions use dynstr length, so they don't need `strlen`/`strcmp` and work for strings with
+ * NULL characters inside. Lookup can be performed with a character array (pointer and length) without allocating
+ * a temporary dynstr, insertion allocates a key only if it is absent.
+ *
+ * Example of usage:
+ * \code
+ * HT(dynstr, int) ht; size_t index; int absent;
+ * ht_init(ht);
+ *
+ * const char *line = "key=value";
+ * ht_put_dynstr_chars(ht, int, line, 3, index, absent); // Inserts "key"
+ * if (absent == 1) {
+ *     ht_value(ht, index) = 1;
+ * }
+ *
+ * ht_get_dynstr_chars(ht, "key", 3, index);
+ *
+ * ht_free_dynstr_keys(ht);
+ * ht_destroy(ht);
+ * \endcode
+ */
+
+#include "dynstr.h"
+#include "hashtable.h"
+#include "hashset.h"
+
+/** Hash implementation for dynamic strings (equal to ht_str_hash() for strings without NULL characters) */
+#define ht_dynstr_hash(s) ht_strn_hash((s), dynstr_size(s))
+
+/** Equality implementation for dynamic strings */
+#define ht_dynstr_eq(a, b) (dynstr_size(a) == dynstr_size(b) && memcmp((a), (b), dynstr_size(a)) == 0)
+
+/** Equality implementation for a stored dynamic string and ht_strn_t */
+#define ht_dynstr_chars_eq(a, b) (dynstr_size(a) == (b).len && memcmp((a), (b).ptr, (b).len) == 0)
+
+/** Reserve implementation for the hash table with dynamic string keys */
+#define ht_reserve_dynstr(h, value_type, new_capacity, success) \
+ht_reserve((h), dynstr, value_type, (new_capacity), (success), ht_dynstr_hash)
+
+/** Lookup implementation for the hash table with dynamic string keys */
+#define ht_get_dynstr(h, key, result) \
+ht_get((h), (key), (result), ht_dynstr_hash, ht_dynstr_eq)
+
+/** Insertion implementation for the hash table with dynamic string keys (\p key is stored as is) */
+#define ht_put_dynstr(h, value_type, key, index, absent) \
+ht_put((h), dynstr, value_type, (key), (index), (absent), ht_dynstr_hash, ht_dynstr_eq)
+
+/** Lookup implementation for the hash table with dynamic string keys using a character array */
+#define ht_get_dynstr_chars(h, chars, chars_size, result) do { \
+	ht_strn_t ht_chars_key = { (chars), (chars_size) }; \
+	ht_get_hashed((h), ht_chars_key, ht_strn_hash(ht_chars_key.ptr, ht_chars_key.len), (result), ht_dynstr_chars_eq); \
+} while (0)
+
+/**
+ * Insertion implementation for the hash table with dynamic string keys using a character array.
+ *
+ * A new dynamic string key is allocated only if the key is absent. It is owned by the hash table
+ * (see ht_free_dynstr_keys()).
+ */
+#define ht_put_dynstr_chars(h, value_type, chars, chars_size, index, absent) do { \
+	ht_strn_t ht_chars_key = { (chars), (chars_size) }; \
+	size_t ht_chars_hash = ht_strn_hash(ht_chars_key.ptr, ht_chars_key.len); \
+	ht_get_hashed((h), ht_chars_key, ht_chars_hash, (index), ht_dynstr_chars_eq); \
+	if (ht_valid((h), (index))) { \
+		(absent) = 0; \
+		break; \
+	} \
+	bool ht_chars_success; \
+	ht_ensure_room((h), dynstr, value_type, ht_chars_success, ht_dynstr_hash); \
+	if (!ht_chars_success) { \
+		(absent) = -1; \
+		break; \
+	} \
+	dynstr ht_chars_copy = dynstr_new_chars(ht_chars_key.ptr, ht_chars_key.len); \
+	if (!ht_chars_copy) { \
+		(absent) = -1; \
+		break; \
+	} \
+	ht_put_hashed((h), ht_chars_copy, ht_chars_hash, (index), (absent), ht_dynstr_eq); \
+} while (0)
+
+/** Free all dynamic string keys of the hash table (doesn't destroy the hash table itself). */
+#define ht_free_dynstr_keys(h) do { \
+	ht_for_each((h), ht_i) { \
+		dynstr_free(ht_key((h), ht_i)); \
+	} \
+} while (0)
+
+/** Hash implementation for dynamic strings (equal to hs_str_hash() for strings without NULL characters) */
+#define hs_dynstr_hash(s) hs_strn_hash((s), dynstr_size(s))
+
+/** Equality implementation for dynamic strings */
+#define hs_dynstr_eq(a, b) (dynstr_size(a) == dynstr_size(b) && memcmp((a), (b), dynstr_size(a)) == 0)
+
+/** Equality implementation for a stored dynamic string and hs_strn_t */
+#define hs_dynstr_chars_eq(a, b) (dynstr_size(a) == (b).len && memcmp((a), (b).ptr, (b).len) == 0)
+
+/** Reserve implementation for the hash set with dynamic string keys */
+#define hs_reserve_dynstr(h, new_capacity, success) \
+hs_reserve((h), dynstr, (new_capacity), (success), hs_dynstr_hash)
+
+/** Lookup implementation for the hash set with dynamic string keys */
+#define hs_get_dynstr(h, key, result) \
+hs_get((h), (key), (result), hs_dynstr_hash, hs_dynstr_eq)
+
+/** Insertion implementation for the hash set with dynamic string keys (\p key is stored as is) */
+#define hs_put_dynstr(h, key, index, absent) \
+hs_put((h), dynstr, (key), (index), (absent), hs_dynstr_hash, hs_dynstr_eq)
+
+/** Lookup implementation for the hash set with dynamic string keys using a character array */
+#define hs_get_dynstr_chars(h, chars, chars_size, result) do { \
+	hs_strn_t hs_chars_key = { (chars), (chars_size) }; \
+	hs_get_hashed((h), hs_chars_key, hs_strn_hash(hs_chars_key.ptr, hs_chars_key.len), (result), hs_dynstr_chars_eq); \
+} while (0)
+
+/**
+ * Insertion implementation for the hash set with dynamic string keys using a character array.
+ *
+ * A new dynamic string key is allocated only if the key is absent. It is owned by the hash set
+ * (see hs_free_dynstr_keys()).
+ */
+#define hs_put_dynstr_chars(h, chars, chars_size, index, absent) do { \
+	hs_strn_t hs_chars_key = { (chars), (chars_size) }; \
+	size_t hs_chars_hash = hs_strn_hash(hs_chars_key.ptr, hs_chars_key.len); \
+	hs_get_hashed((h), hs_chars_key, hs_chars_hash, (index), hs_dynstr_chars_eq); \
+	if (hs_valid((h), (index))) { \
+		(absent) = 0; \
+		break; \
+	} \
+	bool hs_chars_success; \
+	hs_ensure_room((h), dynstr, hs_chars_success, hs_dynstr_hash); \
+	if (!hs_chars_success) { \
+		(absent) = -1; \
+		break; \
+	} \
+	dynstr hs_chars_copy = dynstr_new_chars(hs_chars_key.ptr, hs_chars_key.len); \
+	if (!hs_chars_copy) { \
+		(absent) = -1; \
+		break; \
+	} \
+	hs_put_hashed((h), hs_chars_copy, hs_chars_hash, (index), (absent), hs_dynstr_eq); \
+} while (0)
+
+/** Free all dynamic string keys of the hash set (doesn't destroy the hash set itself). */
+#define hs_free_dynstr_keys(h) do { \
+	hs_for_each((h), hs_i) { \
+		dynstr_free(hs_key((h), hs_i)); \
+	} \
+} while (0)
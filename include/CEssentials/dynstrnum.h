@@ -0,0 +1,172 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+/**
+ * @file
+ * @brief Fast conversions between numbers and dynamic strings (or string views).
+ * @details
+ * Unlike dynstr_printf() these functions don't parse a format string and write digits straight into the reserved
+ * capacity of the string. Integers are written two digits at a time using a digit pair table. Doubles are written
+ * with the Grisu2 algorithm: the result is always read back to the same value and is the shortest such form
+ * in the vast majority of cases (rarely, about once in a thousand values, it has one extra digit). The JavaScript
+ * notation is used (e.g. `0.1`, `100`, `1.5e-7`, `1e21`) which is also valid in JSON and CSV. The result doesn't
+ * depend on the locale.
+ *
+ * The parsing functions (str_to_u64(), str_to_i64(), str_to_double() and their dynstr_ and strview_ wrappers)
+ * accept a span of characters which must contain exactly one number (no whitespace or trailing characters),
+ * so they can be applied to fields produced by splitting without copying them into NULL-terminated buffers.
+ * Integers are validated and converted 8 digits at a time, doubles are converted with the Eisel-Lemire algorithm
+ * and fall back to strtod() only for inputs with more than 19 significant digits which can't be rounded otherwise.
+ * The decimal point is always '.' regardless of the locale.
+ *
+ * Example of usage:
+ * \code
+ * dynstr s = dynstr_new("");
+ * s = dynstr_append_i64(s, -42);
+ * s = dynstr_push(s, ',');
+ * s = dynstr_append_double(s, 0.1);
+ * s = dynstr_push(s, ',');
+ * s = dynstr_append_hex(s, 255);
+ * printf("%s\n", s); // -42,0.1,ff
+ *
+ * int64_t value;
+ * if (strview_to_i64(strview_make(s, 3), &value) == STR_PARSE_OK) {
+ *     printf("%lld\n", (long long) value); // -42
+ * }
+ * dynstr_free(s);
+ * \endcode
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dynstr.h"
+#include "strview.h"
+
+/** Maximum number of characters written by str_format_i64() and str_format_u64(). */
+#define STR_INT_MAX_CHARS 20
+
+/** Maximum number of characters written by str_format_hex(). */
+#define STR_HEX_MAX_CHARS 16
+
+/** Maximum number of characters written by str_format_double(). */
+#define STR_DOUBLE_MAX_CHARS 25
+
+/** The whole input was parsed. */
+#define STR_PARSE_OK 0
+
+/** The input isn't a number, the result is left unchanged. */
+#define STR_PARSE_INVALID 1
+
+/** The number is out of range, the result is clamped to the nearest representable value (or infinity). */
+#define STR_PARSE_RANGE 2
+
+/**
+ * Write decimal representation of an unsigned integer into \p buffer (at least STR_INT_MAX_CHARS characters).
+ *
+ * Returns number of written characters (the NULL character isn't written).
+ */
+size_t str_format_u64(char *buffer, uint64_t value);
+
+/**
+ * Write decimal representation of a signed integer into \p buffer (at least STR_INT_MAX_CHARS characters).
+ *
+ * Returns number of written characters (the NULL character isn't written).
+ */
+size_t str_format_i64(char *buffer, int64_t value);
+
+/**
+ * Write lowercase hexadecimal representation of an integer (without prefix and leading zeros) into \p buffer
+ * (at least STR_HEX_MAX_CHARS characters).
+ *
+ * Returns number of written characters (the NULL character isn't written).
+ */
+size_t str_format_hex(char *buffer, uint64_t value);
+
+/**
+ * Write a representation of a double which is read back to the same value into \p buffer (at least
+ * STR_DOUBLE_MAX_CHARS characters). It is the shortest one in the vast majority of cases, but this isn't guaranteed
+ * (e.g. `30892612233637952` may be written where `30892612233637950` would do).
+ * Infinities are written as `inf`/`-inf` and NaN as `nan`.
+ *
+ * Returns number of written characters (the NULL character isn't written).
+ */
+size_t str_format_double(char *buffer, double value);
+
+/** Append decimal representation of an unsigned integer to a dynamic string. */
+dynstr dynstr_append_u64(dynstr s, uint64_t value) DYNSTR_WARN_UNUSED;
+
+/** Append decimal representation of a signed integer to a dynamic string. */
+dynstr dynstr_append_i64(dynstr s, int64_t value) DYNSTR_WARN_UNUSED;
+
+/** Append lowercase hexadecimal representation of an integer (without prefix) to a dynamic string. */
+dynstr dynstr_append_hex(dynstr s, uint64_t value) DYNSTR_WARN_UNUSED;
+
+/** Append a round-trip (usually the shortest) representation of a double to a dynamic string (see str_format_double()). */
+dynstr dynstr_append_double(dynstr s, double value) DYNSTR_WARN_UNUSED;
+
+/**
+ * Parse an unsigned decimal integer (with an optional '+' sign) from \p count characters starting at \p data.
+ *
+ * Returns STR_PARSE_OK, STR_PARSE_INVALID or STR_PARSE_RANGE (\p result is set to UINT64_MAX).
+ */
+int str_to_u64(const char *data, size_t count, uint64_t *result);
+
+/**
+ * Parse a signed decimal integer (with an optional '+' or '-' sign) from \p count characters starting at \p data.
+ *
+ * Returns STR_PARSE_OK, STR_PARSE_INVALID or STR_PARSE_RANGE (\p result is set to INT64_MIN or INT64_MAX).
+ */
+int str_to_i64(const char *data, size_t count, int64_t *result);
+
+/**
+ * Parse a double in the decimal notation (e.g. `-1.5`, `.5`, `1e-7`) or one of `inf`, `infinity`, `nan`
+ * (case-insensitive) from \p count characters starting at \p data. The result is correctly rounded.
+ *
+ * Returns STR_PARSE_OK, STR_PARSE_INVALID or STR_PARSE_RANGE (\p result is set to an infinity). Underflow
+ * to zero isn't reported as an error.
+ */
+int str_to_double(const char *data, size_t count, double *result);
+
+/** Parse a dynamic string as an unsigned integer (see str_to_u64()). */
+static inline int dynstr_to_u64(const char *s, uint64_t *result) {
+	return str_to_u64(s, dynstr_size(s), result);
+}
+
+/** Parse a dynamic string as a signed integer (see str_to_i64()). */
+static inline int dynstr_to_i64(const char *s, int64_t *result) {
+	return str_to_i64(s, dynstr_size(s), result);
+}
+
+/** Parse a dynamic string as a double (see str_to_double()). */
+static inline int dynstr_to_double(const char *s, double *result) {
+	return str_to_double(s, dynstr_size(s), result);
+}
+
+/** Parse a view as an unsigned integer (see str_to_u64()). */
+static inline int strview_to_u64(strview_t v, uint64_t *result) {
+	return str_to_u64(v.ptr, v.len, result);
+}
+
+/** Parse a view as a signed integer (see str_to_i64()). */
+static inline int strview_to_i64(strview_t v, int64_t *result) {
+	return str_to_i64(v.ptr, v.len, result);
+}
+
+/** Parse a view as a double (see str_to_double()). */
+static inline int strview_to_double(strview_t v, double *result) {
+	return str_to_double(v.ptr, v.len, result);
+}
@@ -0,0 +1,125 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+/**
+ * @file
+ * @brief Substring search, counting and replacement for dynamic strings and character arrays.
+ * @details
+ * Unlike `strstr` all functions take explicit lengths, so both the string and the needle may contain NULL
+ * characters. Candidates are found by comparing the first two and the last characters of the needle with 16 positions
+ * at once (SSE2, or a `memchr` based loop on other targets), so only positions where all of them match are
+ * compared completely. If a needle produces too many false candidates (e.g. `"aaaaab"` in `"aaaa..."`), the search
+ * switches to the Two-Way algorithm which is linear in the worst case.
+ *
+ * Example of usage:
+ * \code
+ * dynstr s = dynstr_new("one fish, two fish");
+ * size_t first = dynstr_find(s, "fish"); // 4
+ * size_t last = dynstr_rfind(s, "fish"); // 14
+ * size_t count = dynstr_count(s, "fish"); // 2
+ * s = dynstr_replace_all(s, "fish", "cat");
+ * printf("%s\n", s); // one cat, two cat
+ * dynstr_free(s);
+ * \endcode
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "dynstr.h"
+
+/** Index returned by search functions when nothing is found. */
+#define STR_NPOS SIZE_MAX
+
+/**
+ * Find the first occurrence of \p needle (\p needle_count characters) in \p count characters starting at \p data.
+ *
+ * Returns index of the occurrence or STR_NPOS. An empty needle is found at index 0.
+ */
+size_t str_find(const char *data, size_t count, const char *needle, size_t needle_count);
+
+/**
+ * Find the last occurrence of \p needle (\p needle_count characters) in \p count characters starting at \p data.
+ *
+ * Returns index of the occurrence or STR_NPOS. An empty needle is found at index \p count.
+ */
+size_t str_rfind(const char *data, size_t count, const char *needle, size_t needle_count);
+
+/**
+ * Count non-overlapping occurrences of \p needle (\p needle_count characters) in \p count characters
+ * starting at \p data (the same occurrences which are replaced by dynstr_replace_all()).
+ *
+ * Returns 0 for an empty needle.
+ */
+size_t str_count(const char *data, size_t count, const char *needle, size_t needle_count);
+
+/** Find the first occurrence of a character array in a dynamic string (see str_find()). */
+static inline size_t dynstr_find_chars(const char *s, const char *needle, size_t needle_count) {
+	return str_find(s, dynstr_size(s), needle, needle_count);
+}
+
+/** Find the first occurrence of a NULL-terminated string in a dynamic string (see str_find()). */
+static inline size_t dynstr_find(const char *s, const char *needle) {
+	return dynstr_find_chars(s, needle, strlen(needle));
+}
+
+/** Find the last occurrence of a character array in a dynamic string (see str_rfind()). */
+static inline size_t dynstr_rfind_chars(const char *s, const char *needle, size_t needle_count) {
+	return str_rfind(s, dynstr_size(s), needle, needle_count);
+}
+
+/** Find the last occurrence of a NULL-terminated string in a dynamic string (see str_rfind()). */
+static inline size_t dynstr_rfind(const char *s, const char *needle) {
+	return dynstr_rfind_chars(s, needle, strlen(needle));
+}
+
+/** Count non-overlapping occurrences of a character array in a dynamic string (see str_count()). */
+static inline size_t dynstr_count_chars(const char *s, const char *needle, size_t needle_count) {
+	return str_count(s, dynstr_size(s), needle, needle_count);
+}
+
+/** Count non-overlapping occurrences of a NULL-terminated string in a dynamic string (see str_count()). */
+static inline size_t dynstr_count(const char *s, const char *needle) {
+	return dynstr_count_chars(s, needle, strlen(needle));
+}
+
+/** Find the first character of a dynamic string which belongs to a character set. Returns its index or STR_NPOS. */
+static inline size_t dynstr_find_any(const char *s, const charset_t *set) {
+	size_t index = charset_cspan(set, s, dynstr_size(s));
+	return index < dynstr_size(s) ? index : STR_NPOS;
+}
+
+/** Find the last character of a dynamic string which belongs to a character set. Returns its index or STR_NPOS. */
+static inline size_t dynstr_rfind_any(const char *s, const charset_t *set) {
+	size_t count = charset_rcspan(set, s, dynstr_size(s));
+	return count < dynstr_size(s) ? dynstr_size(s) - count - 1 : STR_NPOS;
+}
+
+/**
+ * Replace all non-overlapping occurrences of \p from (\p from_count characters) by \p to (\p to_count characters),
+ * scanning from left to right. An empty \p from isn't replaced.
+ *
+ * The result size is computed before any modification, so the string is reallocated at most once (never if the
+ * replacement isn't longer than the replaced part). \p from and \p to must not point inside \p s.
+ */
+dynstr dynstr_replace_all_chars(dynstr s, const char *from, size_t from_count, const char *to, size_t to_count)
+	DYNSTR_WARN_UNUSED;
+
+/** Replace all occurrences of a NULL-terminated string by another one (see dynstr_replace_all_chars()). */
+static inline DYNSTR_WARN_UNUSED dynstr dynstr_replace_all(dynstr s, const char *from, const char *to) {
+	return dynstr_replace_all_chars(s, from, strlen(from), to, strlen(to));
+}
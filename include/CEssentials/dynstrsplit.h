@@ -38,6 +38,16 @@ typedef dynvec(dynstr) dynstr_list_t;
  */
 bool str_split(const char *s, const char *separator, int max_split, dynstr_list_t *result);
 
+/**
+ * Split \p s by any separator character from \p separators and store the result in \p result
+ * (must be initialized using dynvec_init() first). Adjacent separators produce empty strings.
+ *
+ * \p if max_split greater than zero, the result count cannot be greater than this limit.
+ *
+ * Returns false on memory allocation failure.
+ */
+bool str_split_any(const char *s, const charset_t *separators, int max_split, dynstr_list_t *result);
+
 /**
  * Joins back split result using \p separator.
  *
@@ -0,0 +1,299 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+/**
+ * @file
+ * @brief Generic sorted flat map (sorted continuous array of key-value entries) built on top of dynvec.
+ * @details
+ * For small and medium read-mostly maps a sorted array takes less memory than HT and is much faster to iterate
+ * (entries are iterated in key order). Lookups use a branchless binary search, so their cost is predictable
+ * and doesn't depend on hash quality.
+ *
+ * Single insertions and deletions with flatmap_put() and flatmap_delete() shift the tail of the array and cost O(n).
+ * Bulk loads should append entries with flatmap_push() (they aren't visible to lookups yet) and then call
+ * flatmap_build() once: it sorts the new entries (the sort is skipped if they are already sorted) and merges them
+ * with the existing ones in O(n + m log m).
+ *
+ * Comparators receive keys (not pointers to them) and act like strcmp/memcmp. All macros may evaluate the key
+ * argument several times.
+ *
+ * Entries are declared with FLATMAP_ENTRY() which must be given a type name:
+ * \code
+ * typedef FLATMAP_ENTRY(int, const char*) my_entry_t;
+ * FLATMAP(my_entry_t) m; size_t index, begin, end; bool success;
+ * flatmap_init(m);
+ *
+ * flatmap_push(m, my_entry_t, 20, "twenty");
+ * flatmap_push(m, my_entry_t, 10, "ten");
+ * flatmap_push(m, my_entry_t, 30, "thirty");
+ * flatmap_build_int(m, my_entry_t, success);
+ *
+ * flatmap_get_int(m, 20, index);
+ * if (flatmap_valid(m, index)) {
+ *     printf("%s\n", flatmap_value(m, index));
+ * }
+ *
+ * flatmap_range_int(m, 15, 35, begin, end); // Keys in [15, 35)
+ * for (size_t i = begin; i < end; i++) {
+ *     printf("%i: %s\n", flatmap_key(m, i), flatmap_value(m, i));
+ * }
+ *
+ * flatmap_destroy(m);
+ * \endcode
+ */
+
+#include <string.h>
+#include "dynvec.h"
+#include "qsort.h"
+
+/** A flat map entry struct definition */
+#define FLATMAP_ENTRY(key_type, value_type) struct { \
+	key_type key; \
+	value_type value; \
+}
+
+/**
+ * A flat map struct definition. \p entry_type must be a named type declared with FLATMAP_ENTRY().
+ *
+ * It is a dynvec of entries, the first `sorted` entries are sorted by key, the rest are pushed but not built yet.
+ */
+#define FLATMAP(entry_type) struct { \
+	entry_type *data; \
+	size_t size, capacity, sorted; \
+}
+
+/** Sort key of a flat map entry (used by shared flat container macros) */
+#define flat_entry_key(e) ((e).key)
+
+/** Sort key of a flat set element (used by shared flat container macros) */
+#define flat_element_key(e) (e)
+
+/**
+ * Branchless binary search over \p data[0, count) for the first element which `key_of(element) less key` is false.
+ *
+ * Pass `<` as \p less to find the lower bound and `<=` to find the upper bound.
+ * The loop body has no data dependent branches, so it is compiled into a conditional move.
+ */
+#define flat_bound(data, count, key_of, key, result, cmp, less) do { \
+	size_t flat_base = 0, flat_n = (count); \
+	if (flat_n) { \
+		while (flat_n > 1) { \
+			size_t flat_half = flat_n / 2; \
+			flat_base = cmp(key_of((data)[flat_base + flat_half]), (key)) less 0 ? flat_base + flat_half : flat_base; \
+			flat_n -= flat_half; \
+		} \
+		flat_base += cmp(key_of((data)[flat_base]), (key)) less 0; \
+	} \
+	(result) = flat_base; \
+} while (0)
+
+/** Find an element of the flat container \p v equal to \p key, \p result is set to `(v).size` if not found. */
+#define flat_get(v, key_of, key, result, cmp) do { \
+	flat_bound((v).data, (v).sorted, key_of, (key), (result), cmp, <); \
+	if ((result) >= (v).sorted || cmp(key_of((v).data[(result)]), (key)) != 0) { \
+		(result) = (v).size; \
+	} \
+} while (0)
+
+/** Insert \p key into the sorted part of the flat container \p v keeping the order (see flatmap_put()). */
+#define flat_put(v, type, key_of, key, index, absent, cmp) do { \
+	flat_bound((v).data, (v).sorted, key_of, (key), (index), cmp, <); \
+	if ((index) < (v).sorted && cmp(key_of((v).data[(index)]), (key)) == 0) { \
+		(absent) = 0; \
+	} else if ((v).size < (v).capacity || \
+			((v).capacity <= SIZE_MAX / 2 && dynvec_reserve((v), (v).capacity ? (v).capacity * 2 : 16, type))) { \
+		memmove((v).data + (index) + 1, (v).data + (index), ((v).size - (index)) * sizeof(type)); \
+		key_of((v).data[(index)]) = (key); \
+		(v).size++; \
+		(v).sorted++; \
+		(absent) = 1; \
+	} else { \
+		(absent) = -1; \
+	} \
+} while (0)
+
+/** Delete an element of the flat container \p v by its index shifting following elements. */
+#define flat_delete(v, index) do { \
+	size_t flat_index = (index); \
+	memmove((v).data + flat_index, (v).data + flat_index + 1, ((v).size - flat_index - 1) * sizeof(*(v).data)); \
+	(v).size--; \
+	if (flat_index < (v).sorted) { \
+		(v).sorted--; \
+	} \
+} while (0)
+
+/**
+ * Sort pushed elements of the flat container \p v and merge them into its sorted part (see flatmap_build()).
+ *
+ * Pushed elements replace equal sorted ones. The merge runs backwards from the end of the array, so it needs
+ * a temporary buffer only for the pushed elements. When all pushed elements are greater than the sorted ones
+ * (e.g. when the container is loaded from sorted input) no buffer and no moves are needed at all.
+ */
+#define flat_build(v, type, key_of, success, cmp) do { \
+	size_t flat_sorted = (v).sorted, flat_count = (v).size - flat_sorted; \
+	type *flat_pending = (v).data + flat_sorted; \
+	(success) = true; \
+	if (!flat_count) { \
+		break; \
+	} \
+	size_t flat_i = 1; \
+	while (flat_i < flat_count && cmp(key_of(flat_pending[flat_i - 1]), key_of(flat_pending[flat_i])) <= 0) { \
+		flat_i++; \
+	} \
+	if (flat_i < flat_count) { \
+		qsort_by(flat_pending, flat_count, type, key_of, cmp); \
+	} \
+	size_t flat_w = 0; \
+	for (flat_i = 1; flat_i < flat_count; flat_i++) { \
+		if (cmp(key_of(flat_pending[flat_w]), key_of(flat_pending[flat_i])) != 0) { \
+			flat_w++; \
+		} \
+		flat_pending[flat_w] = flat_pending[flat_i]; \
+	} \
+	flat_count = flat_w + 1; \
+	(v).size = flat_sorted + flat_count; \
+	if (flat_sorted && cmp(key_of((v).data[flat_sorted - 1]), key_of(flat_pending[0])) >= 0) { \
+		type *flat_tmp = malloc(flat_count * sizeof(type)); \
+		if (!flat_tmp) { \
+			(success) = false; \
+			break; \
+		} \
+		memcpy(flat_tmp, flat_pending, flat_count * sizeof(type)); \
+		size_t flat_a = flat_sorted, flat_b = flat_count, flat_out = (v).size; \
+		while (flat_b) { \
+			int flat_c = flat_a ? cmp(key_of((v).data[flat_a - 1]), key_of(flat_tmp[flat_b - 1])) : -1; \
+			if (flat_c > 0) { \
+				(v).data[--flat_out] = (v).data[--flat_a]; \
+			} else { \
+				(v).data[--flat_out] = flat_tmp[--flat_b]; \
+				flat_a -= flat_c == 0; /* Drop the replaced element */ \
+			} \
+		} \
+		/* Replaced elements leave a gap between the rest of the sorted part and the merged tail */ \
+		memmove((v).data + flat_a, (v).data + flat_out, ((v).size - flat_out) * sizeof(type)); \
+		(v).size -= flat_out - flat_a; \
+		free(flat_tmp); \
+	} \
+	(v).sorted = (v).size; \
+} while (0)
+
+/** Initialize a empty flat map (no memory allocation performed). */
+#define flatmap_init(m) do { dynvec_init(m); (m).sorted = 0; } while (0)
+
+/** Destroy a flat map. */
+#define flatmap_destroy(m) dynvec_destroy(m)
+
+/** Get number of entries visible to lookups (pushed entries are counted only after flatmap_build()). */
+#define flatmap_size(m) ((m).sorted)
+
+/** Get flat map capacity (number of entries it can store without reallocation). */
+#define flatmap_capacity(m) ((m).capacity)
+
+/** Remove all entries from the flat map. */
+#define flatmap_clear(m) do { (m).size = (m).sorted = 0; } while (0)
+
+/** Try to increase flat map capacity. Returns `true` on success and `false` on memory allocation failure. */
+#define flatmap_reserve(m, entry_type, new_capacity) dynvec_reserve((m), (new_capacity), entry_type)
+
+/**
+ * Append an entry to the flat map without sorting.
+ *
+ * The entry is not visible to lookups until flatmap_build() is called.
+ * Returns `true` on success and `false` on memory allocation failure.
+ */
+#define flatmap_push(m, entry_type, k, v) ( \
+	dynvec_append((m), entry_type) ? \
+		((m).data[(m).size - 1].key = (k), (m).data[(m).size - 1].value = (v), true) : \
+		false \
+)
+
+/**
+ * Sort entries appended by flatmap_push() and merge them into the flat map.
+ *
+ * A pushed entry replaces an existing entry with the same key. If several pushed entries have the same key,
+ * only one of them (which one is unspecified) is kept. \p success is set to `false` on memory allocation failure,
+ * in this case pushed entries stay pending (the flat map remains valid) and the call can be repeated.
+ */
+#define flatmap_build(m, entry_type, success, cmp) flat_build((m), entry_type, flat_entry_key, (success), cmp)
+
+/** Find index of the first entry which key is not less than \p key (`flatmap_size(m)` if there is no such entry). */
+#define flatmap_lower_bound(m, key, result, cmp) \
+	flat_bound((m).data, (m).sorted, flat_entry_key, (key), (result), cmp, <)
+
+/** Find index of the first entry which key is greater than \p key (`flatmap_size(m)` if there is no such entry). */
+#define flatmap_upper_bound(m, key, result, cmp) \
+	flat_bound((m).data, (m).sorted, flat_entry_key, (key), (result), cmp, <=)
+
+/** Find range of entries [\p begin, \p end) which keys are in [\p lo, \p hi). */
+#define flatmap_range(m, lo, hi, begin, end, cmp) do { \
+	flatmap_lower_bound((m), (lo), (begin), cmp); \
+	flatmap_lower_bound((m), (hi), (end), cmp); \
+	if ((end) < (begin)) { \
+		(end) = (begin); \
+	} \
+} while (0)
+
+/**
+ * Find an entry in the flat map.
+ *
+ * You have to check returned value with flatmap_valid() to determine if the entry has been found.
+ */
+#define flatmap_get(m, key, result, cmp) flat_get((m), flat_entry_key, (key), (result), cmp)
+
+/**
+ * Insert a key into the flat map keeping it sorted (the value is left uninitialized and should be set
+ * using flatmap_value()).
+ *
+ * \p absent specifies the operation result. 1 means that the key was successfully inserted.
+ * 0 means that the key was already existed in the flat map (and its index was returned),
+ * -1 means that memory allocation failure happened.
+ */
+#define flatmap_put(m, entry_type, key, index, absent, cmp) \
+	flat_put((m), entry_type, flat_entry_key, (key), (index), (absent), cmp)
+
+/** Delete an entry from the flat map by its index (following indices are shifted). */
+#define flatmap_delete(m, index) flat_delete((m), (index))
+
+/** Verify flat map entry index for validity (needed for flatmap_get()) */
+#define flatmap_valid(m, index) ((index) < (m).sorted)
+
+/** Access key by flat map entry index */
+#define flatmap_key(m, index) ((m).data[(index)].key)
+
+/** Access value by flat map entry index */
+#define flatmap_value(m, index) ((m).data[(index)].value)
+
+/** For each loop over the flat map entries in key order using provided \p index variable. */
+#define flatmap_for_each(m, index) for (size_t index = 0; index < (m).sorted; index++)
+
+/** Comparator for numeric keys */
+#define flatmap_int_cmp(a, b) (((a) > (b)) - ((a) < (b)))
+
+/** Comparator for C-string keys */
+#define flatmap_str_cmp(a, b) strcmp((a), (b))
+
+#define flatmap_build_int(m, entry_type, success) flatmap_build((m), entry_type, (success), flatmap_int_cmp)
+#define flatmap_get_int(m, key, result) flatmap_get((m), (key), (result), flatmap_int_cmp)
+#define flatmap_put_int(m, entry_type, key, index, absent) \
+	flatmap_put((m), entry_type, (key), (index), (absent), flatmap_int_cmp)
+#define flatmap_range_int(m, lo, hi, begin, end) flatmap_range((m), (lo), (hi), (begin), (end), flatmap_int_cmp)
+
+#define flatmap_build_str(m, entry_type, success) flatmap_build((m), entry_type, (success), flatmap_str_cmp)
+#define flatmap_get_str(m, key, result) flatmap_get((m), (key), (result), flatmap_str_cmp)
+#define flatmap_put_str(m, entry_type, key, index, absent) \
+	flatmap_put((m), entry_type, (key), (index), (absent), flatmap_str_cmp)
+#define flatmap_range_str(m, lo, hi, begin, end) flatmap_range((m), (lo), (hi), (begin), (end), flatmap_str_cmp)
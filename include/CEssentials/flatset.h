@@ -0,0 +1,236 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+/**
+ * @file
+ * @brief Generic sorted flat set (sorted continuous array of keys) built on top of dynvec.
+ * @details
+ * The set counterpart of flatmap.h: lookups use a branchless binary search, bulk loads use flatset_push() followed
+ * by flatset_build(). Union, intersection and difference of two flat sets are computed by a linear merge of
+ * their sorted arrays.
+ *
+ * Example of usage:
+ * \code
+ * FLATSET(int) a, b, c; size_t index; int absent; bool success;
+ * flatset_init(a);
+ * flatset_init(b);
+ * flatset_init(c);
+ *
+ * flatset_push(a, int, 3);
+ * flatset_push(a, int, 1);
+ * flatset_build_int(a, int, success);
+ * flatset_put_int(b, int, 3, index, absent);
+ *
+ * flatset_intersection_int(c, a, b, int, success);
+ * flatset_for_each(c, i) {
+ *     printf("%i\n", flatset_key(c, i));
+ * }
+ *
+ * flatset_destroy(a);
+ * flatset_destroy(b);
+ * flatset_destroy(c);
+ * \endcode
+ */
+
+#include "flatmap.h"
+
+/** A flat set struct definition (a dynvec of keys, the first `sorted` keys are sorted). */
+#define FLATSET(key_type) struct { \
+	key_type *data; \
+	size_t size, capacity, sorted; \
+}
+
+/** Initialize a empty flat set (no memory allocation performed). */
+#define flatset_init(s) do { dynvec_init(s); (s).sorted = 0; } while (0)
+
+/** Destroy a flat set. */
+#define flatset_destroy(s) dynvec_destroy(s)
+
+/** Get number of keys visible to lookups (pushed keys are counted only after flatset_build()). */
+#define flatset_size(s) ((s).sorted)
+
+/** Get flat set capacity (number of keys it can store without reallocation). */
+#define flatset_capacity(s) ((s).capacity)
+
+/** Remove all keys from the flat set. */
+#define flatset_clear(s) do { (s).size = (s).sorted = 0; } while (0)
+
+/** Try to increase flat set capacity. Returns `true` on success and `false` on memory allocation failure. */
+#define flatset_reserve(s, key_type, new_capacity) dynvec_reserve((s), (new_capacity), key_type)
+
+/**
+ * Append a key to the flat set without sorting.
+ *
+ * The key is not visible to lookups until flatset_build() is called.
+ * Returns `true` on success and `false` on memory allocation failure.
+ */
+#define flatset_push(s, key_type, key) dynvec_push((s), key_type, (key))
+
+/**
+ * Sort keys appended by flatset_push(), remove duplicates and merge them into the flat set.
+ *
+ * \p success is set to `false` on memory allocation failure, in this case pushed keys stay pending
+ * (the flat set remains valid) and the call can be repeated.
+ */
+#define flatset_build(s, key_type, success, cmp) flat_build((s), key_type, flat_element_key, (success), cmp)
+
+/** Find index of the first key which is not less than \p key (`flatset_size(s)` if there is no such key). */
+#define flatset_lower_bound(s, key, result, cmp) \
+	flat_bound((s).data, (s).sorted, flat_element_key, (key), (result), cmp, <)
+
+/** Find index of the first key which is greater than \p key (`flatset_size(s)` if there is no such key). */
+#define flatset_upper_bound(s, key, result, cmp) \
+	flat_bound((s).data, (s).sorted, flat_element_key, (key), (result), cmp, <=)
+
+/** Find range of keys [\p begin, \p end) which are in [\p lo, \p hi). */
+#define flatset_range(s, lo, hi, begin, end, cmp) do { \
+	flatset_lower_bound((s), (lo), (begin), cmp); \
+	flatset_lower_bound((s), (hi), (end), cmp); \
+	if ((end) < (begin)) { \
+		(end) = (begin); \
+	} \
+} while (0)
+
+/**
+ * Find a key in the flat set.
+ *
+ * You have to check returned value with flatset_valid() to determine if the key has been found.
+ */
+#define flatset_get(s, key, result, cmp) flat_get((s), flat_element_key, (key), (result), cmp)
+
+/**
+ * Insert a key into the flat set keeping it sorted.
+ *
+ * \p absent specifies the operation result. 1 means that the key was successfully inserted.
+ * 0 means that the key was already existed in the flat set (and its index was returned),
+ * -1 means that memory allocation failure happened.
+ */
+#define flatset_put(s, key_type, key, index, absent, cmp) \
+	flat_put((s), key_type, flat_element_key, (key), (index), (absent), cmp)
+
+/** Delete a key from the flat set by its index (following indices are shifted). */
+#define flatset_delete(s, index) flat_delete((s), (index))
+
+/** Verify flat set key index for validity (needed for flatset_get()) */
+#define flatset_valid(s, index) ((index) < (s).sorted)
+
+/** Access key by flat set index */
+#define flatset_key(s, index) ((s).data[(index)])
+
+/** For each loop over the flat set keys in ascending order using provided \p index variable. */
+#define flatset_for_each(s, index) for (size_t index = 0; index < (s).sorted; index++)
+
+/**
+ * Store union of flat sets \p a and \p b into flat set \p dest (previous contents of \p dest are discarded).
+ *
+ * \p dest must not be one of the arguments. Pending keys of the arguments (not built yet) are ignored.
+ * \p success is set to `false` on memory allocation failure (\p dest is left empty).
+ */
+#define flatset_union(dest, a, b, key_type, success, cmp) do { \
+	flatset_clear(dest); \
+	if (!((success) = flatset_reserve((dest), key_type, (a).sorted + (b).sorted))) { \
+		break; \
+	} \
+	size_t flatset_i = 0, flatset_j = 0, flatset_n = 0; \
+	while (flatset_i < (a).sorted && flatset_j < (b).sorted) { \
+		int flatset_c = cmp((a).data[flatset_i], (b).data[flatset_j]); \
+		(dest).data[flatset_n++] = flatset_c <= 0 ? (a).data[flatset_i] : (b).data[flatset_j]; \
+		flatset_i += flatset_c <= 0; \
+		flatset_j += flatset_c >= 0; \
+	} \
+	while (flatset_i < (a).sorted) { \
+		(dest).data[flatset_n++] = (a).data[flatset_i++]; \
+	} \
+	while (flatset_j < (b).sorted) { \
+		(dest).data[flatset_n++] = (b).data[flatset_j++]; \
+	} \
+	(dest).size = (dest).sorted = flatset_n; \
+} while (0)
+
+/**
+ * Store intersection of flat sets \p a and \p b into flat set \p dest (previous contents of \p dest are discarded).
+ *
+ * \p dest must not be one of the arguments. Pending keys of the arguments (not built yet) are ignored.
+ * \p success is set to `false` on memory allocation failure (\p dest is left empty).
+ */
+#define flatset_intersection(dest, a, b, key_type, success, cmp) do { \
+	flatset_clear(dest); \
+	if (!((success) = flatset_reserve((dest), key_type, (a).sorted < (b).sorted ? (a).sorted : (b).sorted))) { \
+		break; \
+	} \
+	size_t flatset_i = 0, flatset_j = 0, flatset_n = 0; \
+	while (flatset_i < (a).sorted && flatset_j < (b).sorted) { \
+		int flatset_c = cmp((a).data[flatset_i], (b).data[flatset_j]); \
+		if (flatset_c == 0) { \
+			(dest).data[flatset_n++] = (a).data[flatset_i]; \
+		} \
+		flatset_i += flatset_c <= 0; \
+		flatset_j += flatset_c >= 0; \
+	} \
+	(dest).size = (dest).sorted = flatset_n; \
+} while (0)
+
+/**
+ * Store difference of flat sets \p a and \p b (keys of \p a which are not in \p b) into flat set \p dest
+ * (previous contents of \p dest are discarded).
+ *
+ * \p dest must not be one of the arguments. Pending keys of the arguments (not built yet) are ignored.
+ * \p success is set to `false` on memory allocation failure (\p dest is left empty).
+ */
+#define flatset_difference(dest, a, b, key_type, success, cmp) do { \
+	flatset_clear(dest); \
+	if (!((success) = flatset_reserve((dest), key_type, (a).sorted))) { \
+		break; \
+	} \
+	size_t flatset_i = 0, flatset_j = 0, flatset_n = 0; \
+	while (flatset_i < (a).sorted && flatset_j < (b).sorted) { \
+		int flatset_c = cmp((a).data[flatset_i], (b).data[flatset_j]); \
+		if (flatset_c < 0) { \
+			(dest).data[flatset_n++] = (a).data[flatset_i]; \
+		} \
+		flatset_i += flatset_c <= 0; \
+		flatset_j += flatset_c >= 0; \
+	} \
+	while (flatset_i < (a).sorted) { \
+		(dest).data[flatset_n++] = (a).data[flatset_i++]; \
+	} \
+	(dest).size = (dest).sorted = flatset_n; \
+} while (0)
+
+#define flatset_build_int(s, key_type, success) flatset_build((s), key_type, (success), flatmap_int_cmp)
+#define flatset_get_int(s, key, result) flatset_get((s), (key), (result), flatmap_int_cmp)
+#define flatset_put_int(s, key_type, key, index, absent) \
+	flatset_put((s), key_type, (key), (index), (absent), flatmap_int_cmp)
+#define flatset_range_int(s, lo, hi, begin, end) flatset_range((s), (lo), (hi), (begin), (end), flatmap_int_cmp)
+#define flatset_union_int(dest, a, b, key_type, success) \
+	flatset_union((dest), (a), (b), key_type, (success), flatmap_int_cmp)
+#define flatset_intersection_int(dest, a, b, key_type, success) \
+	flatset_intersection((dest), (a), (b), key_type, (success), flatmap_int_cmp)
+#define flatset_difference_int(dest, a, b, key_type, success) \
+	flatset_difference((dest), (a), (b), key_type, (success), flatmap_int_cmp)
+
+#define flatset_build_str(s, key_type, success) flatset_build((s), key_type, (success), flatmap_str_cmp)
+#define flatset_get_str(s, key, result) flatset_get((s), (key), (result), flatmap_str_cmp)
+#define flatset_put_str(s, key_type, key, index, absent) \
+	flatset_put((s), key_type, (key), (index), (absent), flatmap_str_cmp)
+#define flatset_range_str(s, lo, hi, begin, end) flatset_range((s), (lo), (hi), (begin), (end), flatmap_str_cmp)
+#define flatset_union_str(dest, a, b, key_type, success) \
+	flatset_union((dest), (a), (b), key_type, (success), flatmap_str_cmp)
+#define flatset_intersection_str(dest, a, b, key_type, success) \
+	flatset_intersection((dest), (a), (b), key_type, (success), flatmap_str_cmp)
+#define flatset_difference_str(dest, a, b, key_type, success) \
+	flatset_difference((dest), (a), (b), key_type, (success), flatmap_str_cmp)
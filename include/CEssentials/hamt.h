@@ -0,0 +1,172 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+/**
+ * @file
+ * @brief Persistent hash map (hash array mapped trie) with O(1) snapshots.
+ * @details
+ * The map is a trie of nodes indexed by 5-bit fragments of key hashes. Each node stores bitmaps of present
+ * entries and child nodes and a compact array of them, so an update touches O(log32 n) small nodes.
+ *
+ * Nodes are reference counted and shared between a map and its snapshots. hamt_snapshot() just shares the root node,
+ * updates copy nodes on the path from the root to the modified entry if they are shared (and modify them in place
+ * otherwise), so a snapshot never changes until it is destroyed.
+ *
+ * Keys and values are opaque pointers which are neither copied nor freed by the map. If a key or a value is removed
+ * from a map, it can still be referenced by snapshots.
+ *
+ * Nodes can be allocated from a hamt_pool_t which keeps free lists of nodes by their size. All maps and snapshots
+ * using a pool must be destroyed before the pool itself.
+ *
+ * Snapshots can be read from other threads while the map is modified, but creation and destruction of maps
+ * and snapshots sharing nodes (as well as any modification) must be serialized.
+ *
+ * Example of usage:
+ * \code
+ * hamt_pool_t pool;
+ * hamt_pool_init(&pool);
+ *
+ * hamt_t map;
+ * hamt_init(&map, hamt_str_hash, hamt_str_eq, &pool);
+ * hamt_put(&map, "a", value_a);
+ *
+ * hamt_t snapshot;
+ * hamt_snapshot(&map, &snapshot);
+ * hamt_put(&map, "b", value_b); // snapshot still contains only "a"
+ *
+ * void *value;
+ * if (hamt_get(&snapshot, "a", &value)) {
+ *     ...
+ * }
+ *
+ * hamt_destroy(&snapshot);
+ * hamt_destroy(&map);
+ * hamt_pool_destroy(&pool);
+ * \endcode
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+
+/** Number of hash bits used by each trie level */
+#define HAMT_BITS 5
+
+/** Number of hash bits (the deepest nodes hold keys with equal hashes) */
+#define HAMT_HASH_BITS (sizeof(size_t) * CHAR_BIT)
+
+/** Maximal depth of the trie */
+#define HAMT_MAX_DEPTH (HAMT_HASH_BITS / HAMT_BITS + 2)
+
+/** Number of node size classes handled by the pool (larger nodes are allocated by `malloc`) */
+#define HAMT_POOL_CLASSES (2 * (1 << HAMT_BITS) + 1)
+
+/** Size of memory chunks allocated by the pool */
+#ifndef HAMT_POOL_CHUNK_SIZE
+#define HAMT_POOL_CHUNK_SIZE 65536
+#endif
+
+/** Hash function of keys */
+typedef size_t (*hamt_hash_func_t)(const void *key);
+
+/** Equality function of keys */
+typedef bool (*hamt_eq_func_t)(const void *a, const void *b);
+
+/** Trie node. Its structure is private. */
+typedef struct hamt_node hamt_node_t;
+
+/** Node allocator. Normally its fields shouldn't be accessed directly from user code. */
+typedef struct hamt_pool {
+	void *free_lists[HAMT_POOL_CLASSES]; //!< Free nodes by number of slots.
+	void *chunks; //!< Allocated memory chunks.
+	char *chunk_ptr; //!< Free space of the current chunk.
+	size_t chunk_left; //!< Free space size of the current chunk.
+} hamt_pool_t;
+
+/** Persistent hash map. Normally its fields shouldn't be accessed directly from user code. */
+typedef struct hamt {
+	hamt_node_t *root; //!< Root node (NULL if the map is empty).
+	size_t size; //!< Number of entries.
+	hamt_hash_func_t hash; //!< Hash function.
+	hamt_eq_func_t eq; //!< Equality function.
+	hamt_pool_t *pool; //!< Node allocator (NULL to use `malloc` directly).
+} hamt_t;
+
+/** Iterator over map entries (in unspecified order). */
+typedef struct hamt_iter {
+	const hamt_node_t *nodes[HAMT_MAX_DEPTH]; //!< Nodes on the path to the current entry.
+	uint32_t positions[HAMT_MAX_DEPTH]; //!< Next positions inside nodes.
+	int depth; //!< Index of the current node (-1 if the iteration is over).
+	const void *key; //!< Current key.
+	void *value; //!< Current value.
+} hamt_iter_t;
+
+/** Initialize a node pool (no memory allocation performed). */
+void hamt_pool_init(hamt_pool_t *pool);
+
+/** Free all memory of a node pool. All maps using it must be destroyed first. */
+void hamt_pool_destroy(hamt_pool_t *pool);
+
+/** Initialize an empty map (no memory allocation performed). \p pool can be NULL. */
+void hamt_init(hamt_t *map, hamt_hash_func_t hash, hamt_eq_func_t eq, hamt_pool_t *pool);
+
+/** Destroy a map or a snapshot (nodes shared with other snapshots are kept alive). */
+void hamt_destroy(hamt_t *map);
+
+/** Get number of entries of the map. */
+#define hamt_size(map) ((map)->size)
+
+/** Create a snapshot of the map in constant time. It must be destroyed with hamt_destroy(). */
+void hamt_snapshot(const hamt_t *map, hamt_t *snapshot);
+
+/** Look up a key. Returns true and stores the value into \p value (if not NULL) if the key is found. */
+bool hamt_get(const hamt_t *map, const void *key, void **value);
+
+/**
+ * Insert an entry or replace the value of an existing one.
+ *
+ * Returns 1 if the entry was inserted, 0 if the value of existing entry was replaced,
+ * -1 in case of memory allocation failure (the map remains untouched).
+ */
+int hamt_put(hamt_t *map, const void *key, void *value);
+
+/**
+ * Delete an entry.
+ *
+ * Returns 1 if the entry was deleted, 0 if there is no such key,
+ * -1 in case of memory allocation failure (the map remains untouched).
+ */
+int hamt_delete(hamt_t *map, const void *key);
+
+/** Start iteration over map entries. The map must not be modified during iteration. */
+void hamt_iter_init(hamt_iter_t *it, const hamt_t *map);
+
+/** Move to the next entry (the first one after hamt_iter_init()). Returns false if there are no more entries. */
+bool hamt_iter_next(hamt_iter_t *it);
+
+/** Default hash implementation for strings */
+size_t hamt_str_hash(const void *key);
+
+/** Default equality implementation for strings */
+bool hamt_str_eq(const void *a, const void *b);
+
+/** Hash implementation for keys compared by their addresses (e.g. interned strings) */
+size_t hamt_ptr_hash(const void *key);
+
+/** Equality implementation for keys compared by their addresses */
+bool hamt_ptr_eq(const void *a, const void *b);
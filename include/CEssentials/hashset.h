@@ -47,21 +47,137 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include "roundup.h"
+#include "bitops.h"
+
+/** Default maximum load factor of a hash set */
+#define HS_DEFAULT_MAX_LOAD 0.75f
+
+/** Default minimum load factor of a hash set (0 disables automatic shrinking) */
+#define HS_DEFAULT_MIN_LOAD 0.0f
+
+#ifdef HS_STATS
+#include <stdio.h>
+#include <time.h>
+
+#ifndef HS_STATS_PROBE_BUCKETS
+/** Number of probe length histogram buckets (the last one counts all longer probe sequences). */
+#define HS_STATS_PROBE_BUCKETS 16
+#endif
+
+/**
+ * Hash table statistics (collected only if HS_STATS is defined).
+ *
+ * HS_STATS changes the hash set struct layout, so it must be defined for all code sharing hash sets
+ * (including the library itself).
+ */
+typedef struct hs_stats {
+	size_t gets; //!< Number of lookups.
+	size_t puts; //!< Number of insertions (including ones which found an existing key).
+	size_t probes[HS_STATS_PROBE_BUCKETS]; //!< Histogram of lookup and insertion probe lengths.
+	size_t max_probe; //!< Maximal probe length.
+	size_t rehashes; //!< Number of rehashes.
+	double rehash_seconds; //!< Total duration of rehashes.
+	size_t bytes_allocated; //!< Total number of bytes allocated by rehashes.
+} hs_stats_t;
+
+/** Get current time in seconds for rehash duration statistics. */
+static inline double hs_stats_now(void) {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+/** Add a probe length to the histogram. */
+static inline void hs_stats_record_probe(hs_stats_t *stats, size_t probe) {
+	stats->probes[probe < HS_STATS_PROBE_BUCKETS - 1 ? probe : HS_STATS_PROBE_BUCKETS - 1]++;
+	if (probe > stats->max_probe) {
+		stats->max_probe = probe;
+	}
+}
+
+/** Print hash set statistics and the probe length histogram. */
+static inline void hs_stats_print(const hs_stats_t *stats, size_t size, size_t used, size_t capacity, FILE *out) {
+	fprintf(out, "size %zu, capacity %zu, load %.3f, tombstones %.3f\n", size, capacity,
+			capacity ? (double) size / (double) capacity : 0.0,
+			capacity ? (double) (used - size) / (double) capacity : 0.0);
+	fprintf(out, "lookups %zu, insertions %zu, max probe length %zu\n", stats->gets, stats->puts, stats->max_probe);
+	fprintf(out, "rehashes %zu, %.6f s, %zu bytes allocated\n", stats->rehashes, stats->rehash_seconds,
+			stats->bytes_allocated);
+	size_t max_count = 0;
+	for (size_t i = 0; i < HS_STATS_PROBE_BUCKETS; i++) {
+		if (stats->probes[i] > max_count) {
+			max_count = stats->probes[i];
+		}
+	}
+	fprintf(out, "probe length histogram:\n");
+	for (size_t i = 0; i < HS_STATS_PROBE_BUCKETS; i++) {
+		if (!stats->probes[i]) continue;
+		fprintf(out, "%4zu%s |", i, i == HS_STATS_PROBE_BUCKETS - 1 ? "+" : " ");
+		size_t width = (size_t) ((double) stats->probes[i] * 40.0 / (double) max_count);
+		for (size_t j = 0; j < (width ? width : 1); j++) {
+			fputc('#', out);
+		}
+		fprintf(out, " %zu\n", stats->probes[i]);
+	}
+}
+
+/** Hash table struct statistics field. Normally shouldn't be used directly from user code. */
+#define HS_STATS_FIELD hs_stats_t stats;
+
+/** Reset hash set statistics. */
+#define hs_stats_reset(h) memset(&(h).stats, 0, sizeof((h).stats))
+
+/** Access hash set statistics (hs_stats_t). */
+#define hs_stats(h) ((h).stats)
+
+/** Print hash set statistics and the probe length histogram to \p out (does nothing if HS_STATS isn't defined). */
+#define hs_stats_dump(h, out) hs_stats_print(&(h).stats, (h).size, (h).used, (h).capacity, (out))
+
+/** Record a lookup. Normally shouldn't be used directly from user code. */
+#define HS_STATS_GET(h, probe) do { (h).stats.gets++; hs_stats_record_probe(&(h).stats, (probe)); } while (0)
+
+/** Record an insertion. Normally shouldn't be used directly from user code. */
+#define HS_STATS_PUT(h, probe) do { (h).stats.puts++; hs_stats_record_probe(&(h).stats, (probe)); } while (0)
+
+/** Start measuring a rehash. Normally shouldn't be used directly from user code. */
+#define HS_STATS_REHASH_BEGIN() double hs_stats_start = hs_stats_now()
+
+/** Record a rehash. Normally shouldn't be used directly from user code. */
+#define HS_STATS_REHASH_END(h, bytes) do { \
+	(h).stats.rehashes++; \
+	(h).stats.rehash_seconds += hs_stats_now() - hs_stats_start; \
+	(h).stats.bytes_allocated += (bytes); \
+} while (0)
+#else
+#define HS_STATS_FIELD
+#define hs_stats_reset(h) ((void) 0)
+#define hs_stats_dump(h, out) ((void) (out))
+#define HS_STATS_GET(h, probe) ((void) 0)
+#define HS_STATS_PUT(h, probe) ((void) 0)
+#define HS_STATS_REHASH_BEGIN() ((void) 0)
+#define HS_STATS_REHASH_END(h, bytes) ((void) 0)
+#endif
 
 /** A hash set struct definition */
 #define HS(key_type) struct { \
-	size_t size, used, max_used, capacity; \
+	size_t size, used, max_used, min_used, capacity; \
+	float max_load, min_load; \
 	char *flags; \
 	key_type *keys; \
+	HS_STATS_FIELD \
 }
 
 /** Initialize a empty hash set (no memory allocation performed). */
 #define hs_init(h) do { \
-	(h).size = (h).used = (h).max_used = (h).capacity = 0; \
+	(h).size = (h).used = (h).max_used = (h).min_used = (h).capacity = 0; \
+	(h).max_load = HS_DEFAULT_MAX_LOAD; \
+	(h).min_load = HS_DEFAULT_MIN_LOAD; \
 	(h).flags = NULL; \
 	(h).keys = NULL; \
+	hs_stats_reset((h)); \
 } while (0)
 
 /**
@@ -80,85 +196,350 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 /** Get maximum number of elements that can be stored in the hash set before rehashing. */
 #define hs_max_used(h) ((h).max_used)
 
+/** Get number of elements below which the hash set is shrunk automatically. */
+#define hs_min_used(h) ((h).min_used)
+
 /** Get total hash set size. */
 #define hs_capacity(h) ((h).capacity)
 
+/** Get maximum load factor of the hash set. */
+#define hs_max_load(h) ((h).max_load)
+
+/** Get minimum load factor of the hash set. */
+#define hs_min_load(h) ((h).min_load)
+
+/** Compute how many slots of a hash set with \p capacity can be occupied with given \p max_load. */
+static inline size_t hs_max_used_for(size_t capacity, float max_load) {
+	size_t limit = (size_t) ((double) capacity * max_load);
+	if (limit >= capacity) {
+		limit = capacity - 1; // At least one slot must be empty to stop probing
+	}
+	if (!limit && capacity > 1) {
+		limit = 1;
+	}
+	return limit;
+}
+
+/** Compute how many elements a hash set with \p capacity can hold before it is shrunk with given \p min_load. */
+static inline size_t hs_min_used_for(size_t capacity, float min_load) {
+	return min_load > 0.0f ? (size_t) ((double) capacity * min_load) : 0;
+}
+
+/**
+ * Compute minimal hash set capacity (a power of 2) able to hold \p count elements with given \p max_load.
+ * Returns 0 in case of integer overflow.
+ */
+static inline size_t hs_capacity_for(size_t count, float max_load) {
+	size_t capacity = count;
+	roundupsize(capacity);
+	if (capacity < count) { // Integer overflow
+		return 0;
+	}
+	while (hs_max_used_for(capacity, max_load) < count) {
+		if (capacity > SIZE_MAX / 2) { // Integer overflow
+			return 0;
+		}
+		capacity <<= 1;
+	}
+	return capacity;
+}
+
+/**
+ * Set maximum and minimum load factors of the hash set.
+ *
+ * \p max_load must be in (0, 1) range. The hash set is grown when the number of occupied slots
+ * (including deleted ones) exceeds `max_load * capacity`. \p min_load must be in [0, max_load / 4] range,
+ * if it isn't zero, the hash set is shrunk when the number of elements falls below `min_load * capacity`.
+ * New values take effect immediately without rehashing.
+ */
+#define hs_set_load_factor(h, new_max_load, new_min_load) do { \
+	(h).max_load = (new_max_load); \
+	(h).min_load = (new_min_load); \
+	(h).max_used = (h).capacity ? hs_max_used_for((h).capacity, (h).max_load) : 0; \
+	(h).min_used = hs_min_used_for((h).capacity, (h).min_load); \
+} while (0)
+
+#if defined(_OPENMP) && !defined(HS_NO_PARALLEL_REHASH)
+/** Nonzero if large hash sets are rehashed by multiple threads (requires OpenMP, define HS_NO_PARALLEL_REHASH to disable). */
+#define HS_PARALLEL_REHASH 1
+/** Emit a pragma from a macro body (only when OpenMP is enabled). */
+#define HS_OMP_PRAGMA(x) _Pragma(#x)
+#else
+/** Nonzero if large hash sets are rehashed by multiple threads (requires OpenMP, define HS_NO_PARALLEL_REHASH to disable). */
+#define HS_PARALLEL_REHASH 0
+/** Emit a pragma from a macro body (only when OpenMP is enabled). */
+#define HS_OMP_PRAGMA(x)
+#endif
+
+#ifndef HS_PARALLEL_REHASH_MIN
+/** Minimal capacity of a hash set which is rehashed by multiple threads. */
+#define HS_PARALLEL_REHASH_MIN 65536
+#endif
+
+/**
+ * Mark an empty slot as occupied (atomically if parallel rehash is enabled). Returns false if the slot has been occupied already.
+ * Used for parallel rehash. Normally shouldn't be used directly from user code.
+ */
+static inline bool hs_claim_slot(char *flags, size_t index) {
+#if !HS_PARALLEL_REHASH
+	if (flags[index]) {
+		return false;
+	}
+	flags[index] = 1;
+	return true;
+#elif defined(_MSC_VER) && !defined(__clang__)
+	return _InterlockedCompareExchange8(&flags[index], 1, 0) == 0;
+#else
+	char expected = 0;
+	return __atomic_compare_exchange_n(&flags[index], &expected, 1, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+#endif
+}
+
 /** Clear hash set */
 #define hs_clear(h) do { (h).size = 0; (h).used = 0; if ((h).flags) { memset((h).flags, 0, (h).capacity); } } while (0)
 
+#if defined(__GNUC__)
+/** Hide the origin of a freshly allocated array from the optimizer (see HT_LAUNDER() in hashtable.h). */
+#define HS_LAUNDER(ptr) __asm__("" : "+r"(ptr) : : "memory")
+#else
+#define HS_LAUNDER(ptr) ((void) 0)
+#endif
+
 /**
- * Resize hash set to be able to hold at least new_capacity elements.
+ * Rebuild hash set with exactly \p new_capacity slots (must be a power of 2 able to hold all elements).
  * Success will be assigned to false in case of memory allocation failure.
+ *
+ * If OpenMP is enabled, hash sets with at least HS_PARALLEL_REHASH_MIN slots are rehashed by multiple threads
+ * (\p hash_func must be safe to call concurrently). Element positions might differ from a single-threaded rehash.
  */
-#define hs_reserve(h, key_type, new_capacity, success, hash_func) do { \
-	if (new_capacity <= (h).max_used) { \
-		(success) = true; \
-		break; \
-	} \
-	size_t hs_new_capacity = (new_capacity); \
-	roundupsize(hs_new_capacity); \
-	if (hs_new_capacity < (new_capacity)) { /* Integer overflow */ \
-		(success) = false; \
-		break; \
-	} \
-	size_t hs_new_max_used = (hs_new_capacity >> 1) + (hs_new_capacity >> 2); \
-	if (hs_new_max_used < (new_capacity)) { \
-    	hs_new_capacity <<= 1; \
-		if (hs_new_capacity < (new_capacity)) { /* Integer overflow */ \
-			(success) = false; \
-			break; \
-		} \
-		hs_new_max_used = (hs_new_capacity >> 1) + (hs_new_capacity >> 2); \
-    } \
-	char *hs_new_flags = malloc(hs_new_capacity); \
+#define hs_rehash(h, key_type, new_capacity, success, hash_func) do { \
+	size_t hs_rehash_capacity = (new_capacity); \
+	HS_STATS_REHASH_BEGIN(); \
+	char *hs_new_flags = malloc(hs_rehash_capacity); \
 	if (!hs_new_flags) { \
 		(success) = false; \
 		break; \
 	} \
-	key_type *hs_new_keys = malloc(hs_new_capacity * sizeof(key_type)); \
+	key_type *hs_new_keys = malloc(hs_rehash_capacity * sizeof(key_type)); \
 	if (!hs_new_keys) { \
 		free(hs_new_flags); \
 		(success) = false; \
 		break; \
 	} \
-	memset(hs_new_flags, 0, hs_new_capacity); \
-	size_t hs_mask = hs_new_capacity - 1; \
-	for (size_t hs_i = 0; hs_i < (h).capacity; hs_i++) { \
-		if ((h).flags[hs_i] != 1) continue; \
-		size_t hs_j = hash_func((h).keys[hs_i]) & hs_mask; \
-		size_t hs_step = 0; \
-		while (hs_new_flags[hs_j]) { \
-			hs_j = (hs_j + ++hs_step) & hs_mask; \
+	memset(hs_new_flags, 0, hs_rehash_capacity); \
+	size_t hs_mask = hs_rehash_capacity - 1; \
+	if (HS_PARALLEL_REHASH && (h).capacity >= HS_PARALLEL_REHASH_MIN) { \
+		ptrdiff_t hs_old_capacity = (ptrdiff_t) (h).capacity; \
+		HS_OMP_PRAGMA(omp parallel for schedule(static)) \
+		for (ptrdiff_t hs_i = 0; hs_i < hs_old_capacity; hs_i++) { \
+			if ((h).flags[hs_i] != 1) continue; \
+			size_t hs_j = hash_func((h).keys[hs_i]) & hs_mask; \
+			size_t hs_step = 0; \
+			while (!hs_claim_slot(hs_new_flags, hs_j)) { \
+				hs_j = (hs_j + ++hs_step) & hs_mask; \
+			} \
+			hs_new_keys[hs_j] = (h).keys[hs_i]; \
+		} \
+	} else { \
+		for (size_t hs_i = 0; hs_i < (h).capacity; hs_i++) { \
+			if ((h).flags[hs_i] != 1) continue; \
+			size_t hs_j = hash_func((h).keys[hs_i]) & hs_mask; \
+			size_t hs_step = 0; \
+			while (hs_new_flags[hs_j]) { \
+				hs_j = (hs_j + ++hs_step) & hs_mask; \
+			} \
+			hs_new_flags[hs_j] = 1; \
+			hs_new_keys[hs_j] = (h).keys[hs_i]; \
 		} \
-		hs_new_flags[hs_j] = 1; \
-		hs_new_keys[hs_j] = (h).keys[hs_i]; \
 	} \
 	free((h).keys); \
 	free((h).flags); \
+	HS_LAUNDER(hs_new_flags); \
+	HS_LAUNDER(hs_new_keys); \
 	(h).flags = hs_new_flags; \
 	(h).keys = hs_new_keys; \
-	(h).capacity = hs_new_capacity; \
+	(h).capacity = hs_rehash_capacity; \
 	(h).used = (h).size; \
-	(h).max_used = hs_new_max_used; \
+	(h).max_used = hs_max_used_for(hs_rehash_capacity, (h).max_load); \
+	(h).min_used = hs_min_used_for(hs_rehash_capacity, (h).min_load); \
+	HS_STATS_REHASH_END((h), hs_rehash_capacity * (1 + sizeof(key_type))); \
 	(success) = true; \
 } while (0)
 
 /**
- * Perform hash set lookup and return in \p result index of matched element if any.
+ * Resize hash set to be able to hold at least new_capacity elements.
+ * Success will be assigned to false in case of memory allocation failure.
+ */
+#define hs_reserve(h, key_type, new_capacity, success, hash_func) do { \
+	if ((new_capacity) <= (h).max_used) { \
+		(success) = true; \
+		break; \
+	} \
+	size_t hs_reserve_capacity = hs_capacity_for((new_capacity), (h).max_load); \
+	if (!hs_reserve_capacity) { /* Integer overflow */ \
+		(success) = false; \
+		break; \
+	} \
+	hs_rehash((h), key_type, hs_reserve_capacity, (success), hash_func); \
+} while (0)
+
+/** Release all memory of an empty hash set keeping its load factors. */
+#define hs_release(h) do { \
+	free((h).keys); \
+	free((h).flags); \
+	(h).flags = NULL; \
+	(h).keys = NULL; \
+	(h).used = (h).max_used = (h).min_used = (h).capacity = 0; \
+} while (0)
+
+/**
+ * Shrink hash set to the minimal capacity able to hold its elements (frees all memory if it is empty).
+ * Success will be assigned to false in case of memory allocation failure (the hash set remains untouched).
+ */
+#define hs_shrink_to_fit(h, key_type, success, hash_func) do { \
+	if (!(h).size) { \
+		hs_release(h); \
+		(success) = true; \
+		break; \
+	} \
+	size_t hs_shrink_capacity = hs_capacity_for((h).size, (h).max_load); \
+	if (!hs_shrink_capacity || hs_shrink_capacity >= (h).capacity) { \
+		(success) = true; \
+		break; \
+	} \
+	hs_rehash((h), key_type, hs_shrink_capacity, (success), hash_func); \
+} while (0)
+
+/**
+ * Shrink hash set if the number of its elements fell below the minimum load factor.
  *
- * You have to check returned value with hs_valid() to determine if the element has been found.
- * Then you can use hs_key() to access it.
+ * The new capacity leaves room for the hash set to double before the next growth.
+ * Success will be assigned to false in case of memory allocation failure (the hash set remains untouched).
+ */
+#define hs_maybe_shrink(h, key_type, success, hash_func) do { \
+	if ((h).size >= (h).min_used) { \
+		(success) = true; \
+		break; \
+	} \
+	if (!(h).size) { \
+		hs_release(h); \
+		(success) = true; \
+		break; \
+	} \
+	size_t hs_shrink_capacity = hs_capacity_for((h).size * 2, (h).max_load); \
+	if (!hs_shrink_capacity || hs_shrink_capacity >= (h).capacity) { \
+		(success) = true; \
+		break; \
+	} \
+	hs_rehash((h), key_type, hs_shrink_capacity, (success), hash_func); \
+} while (0)
+
+/**
+ * Probe the hash set for \p key with precomputed \p hash, storing the matched index in \p result and the probe
+ * length in \p step. Normally shouldn't be used directly from user code.
  */
-#define hs_get(h, key, result, hash_func, eq_func) do { \
+#define hs_probe_hashed(h, key, hash, result, step, eq_func) do { \
 	if (!(h).size) { \
 		(result) = 0; \
 		break; \
 	} \
 	size_t hs_mask = (h).capacity - 1; \
-	(result) = hash_func(key) & hs_mask; \
-	size_t hs_step = 0; \
+	(result) = (hash) & hs_mask; \
 	while ((h).flags[(result)] == 2 || ((h).flags[(result)] == 1 && !eq_func((h).keys[(result)], (key)))) { \
-		(result) = ((result) + ++hs_step) & hs_mask; \
+		(result) = ((result) + ++(step)) & hs_mask; \
+	} \
+} while (0)
+
+/**
+ * Perform hash set lookup using precomputed \p hash of \p key and return in \p result index of matched element if any.
+ *
+ * \p key doesn't need to have the key type as long as `eq_func(stored_key, key)` can compare them and \p hash
+ * is computed the same way as for stored keys.
+ */
+#define hs_get_hashed(h, key, hash, result, eq_func) do { \
+	size_t hs_step = 0; \
+	hs_probe_hashed((h), (key), (hash), (result), hs_step, eq_func); \
+	if ((h).size) { \
+		HS_STATS_GET((h), hs_step); \
+	} \
+} while (0)
+
+/**
+ * Same as hs_get_hashed() but never records statistics, so it doesn't write to the hash set and may be used
+ * on a const hash set (e.g. for concurrent read-only lookups).
+ */
+#define hs_get_hashed_nostats(h, key, hash, result, eq_func) do { \
+	size_t hs_step = 0; \
+	hs_probe_hashed((h), (key), (hash), (result), hs_step, eq_func); \
+	(void) hs_step; \
+} while (0)
+
+/**
+ * Perform hash set lookup and return in \p result index of matched element if any.
+ *
+ * You have to check returned value with hs_valid() to determine if the element has been found.
+ * Then you can use hs_key() to access it.
+ */
+#define hs_get(h, key, result, hash_func, eq_func) \
+hs_get_hashed((h), (key), hash_func(key), (result), eq_func)
+
+/**
+ * Insert an element with precomputed \p hash inside the hash set and return its index.
+ *
+ * Unlike hs_put() this macro doesn't grow the hash set, so the caller must ensure that there is a room for
+ * one more element (e.g. using hs_reserve()). \p absent has the same meaning as for hs_put() except that -1
+ * is never returned.
+ */
+#define hs_put_hashed(h, key, hash, index, absent, eq_func) do { \
+	size_t hs_mask = (h).capacity - 1; \
+	(index) = (hash) & hs_mask; \
+	size_t hs_step = 0; \
+	size_t hs_deleted = (h).capacity; \
+	while ((h).flags[(index)] == 2 || ((h).flags[(index)] == 1 && !eq_func((h).keys[(index)], (key)))) { \
+		if ((h).flags[(index)] == 2 && hs_deleted == (h).capacity) { \
+			hs_deleted = (index); \
+		} \
+		(index) = ((index) + ++hs_step) & hs_mask; \
+	} \
+	HS_STATS_PUT((h), hs_step); \
+	if ((h).flags[(index)] == 1) { \
+		(absent) = 0; \
+	} else { \
+		if (hs_deleted != (h).capacity) { \
+			(index) = hs_deleted; \
+		} else { \
+			(h).used++; \
+		} \
+		(h).flags[(index)] = 1; \
+		(h).keys[(index)] = (key); \
+		(h).size++; \
+		(absent) = 1; \
+	} \
+} while (0)
+
+/**
+ * Make sure that one more element can be inserted into the hash set with hs_put_hashed(),
+ * growing it or dropping deleted elements if needed (and shrinking it if it is below the minimum load factor).
+ * Success will be assigned to false in case of memory allocation failure.
+ */
+#define hs_ensure_room(h, key_type, success, hash_func) do { \
+	if ((h).size < (h).min_used) { \
+		hs_maybe_shrink((h), key_type, (success), hash_func); /* Failure isn't fatal here */ \
+	} \
+	(success) = true; \
+	if ((h).used >= (h).max_used) { \
+		size_t hs_new_capacity = (h).capacity; \
+		if ((h).size >= (h).max_used / 2) { /* Otherwise just drop deleted elements */ \
+			hs_new_capacity = hs_capacity_for((h).size ? (h).size + 1 : 2, (h).max_load); \
+			if (hs_new_capacity <= (h).capacity) { \
+				hs_new_capacity = (h).capacity <= SIZE_MAX / 2 ? (h).capacity << 1 : 0; \
+			} \
+			if (!hs_new_capacity) { /* Integer overflow */ \
+				(success) = false; \
+				break; \
+			} \
+		} \
+		hs_rehash((h), key_type, hs_new_capacity, (success), hash_func); \
 	} \
 } while (0)
 
@@ -172,33 +553,97 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 #define hs_put(h, key_type, key, index, absent, hash_func, eq_func) do { \
 	bool hs_success; \
-	size_t hs_new_size = (h).used ? (h).used + 1 : 2; \
-	if (hs_new_size < (h).used) { /* Integer overflow */ \
+	hs_ensure_room((h), key_type, hs_success, hash_func); \
+	if (!hs_success) { \
 		(absent) = -1; \
 		break; \
 	} \
-	hs_reserve((h), key_type, hs_new_size, hs_success, hash_func); \
-	if (!hs_success) { \
-		(absent) = -1; \
+	hs_put_hashed((h), (key), hash_func(key), (index), (absent), eq_func); \
+} while (0)
+
+#ifndef HS_BUILD_PARTITION_BITS
+/** Number of hash bits used to partition keys during hs_build_from_array() (up to 2^N partitions). */
+#define HS_BUILD_PARTITION_BITS 8
+#endif
+
+#ifndef HS_BUILD_PARTITION_MIN
+/** Minimal number of elements for hs_build_from_array() to partition keys before insertion. */
+#define HS_BUILD_PARTITION_MIN 4096
+#endif
+
+/**
+ * Fill \p order with indices of \p hashes sorted by the high bits of their slot in a set of size \p capacity
+ * (one pass of a radix sort). Normally shouldn't be used directly from user code.
+ */
+static inline void hs_partition_by_hash(const size_t *hashes, size_t count, size_t capacity, size_t *order) {
+	size_t counts[1 << HS_BUILD_PARTITION_BITS];
+	size_t mask = capacity - 1;
+	unsigned int shift = 0;
+	while ((capacity >> shift) > ((size_t) 1 << HS_BUILD_PARTITION_BITS)) {
+		shift++;
+	}
+	size_t partitions = capacity >> shift;
+	memset(counts, 0, partitions * sizeof(size_t));
+	for (size_t i = 0; i < count; i++) {
+		counts[(hashes[i] & mask) >> shift]++;
+	}
+	size_t offset = 0;
+	for (size_t i = 0; i < partitions; i++) {
+		size_t partition_size = counts[i];
+		counts[i] = offset;
+		offset += partition_size;
+	}
+	for (size_t i = 0; i < count; i++) {
+		order[counts[(hashes[i] & mask) >> shift]++] = i;
+	}
+}
+
+/**
+ * Insert \p count elements from \p key_array into the hash set.
+ *
+ * The hash set is resized at most once, hashes are computed in a separate pass and large inputs are inserted
+ * in the order of their slots, so the insertion touches the memory almost sequentially.
+ * Success will be assigned to false in case of memory allocation failure
+ * (the elements inserted so far remain in the hash set).
+ */
+#define hs_build_from_array(h, key_type, key_array, count, success, hash_func, eq_func) do { \
+	size_t hs_count = (count); \
+	if (!hs_count) { \
+		(success) = true; \
 		break; \
 	} \
-	size_t hs_mask = (h).capacity - 1; \
-	(index) = hash_func(key) & hs_mask; \
-	size_t hs_step = 0; \
-	while ((h).flags[(index)] == 1 && !eq_func((h).keys[(index)], (key))) { \
-		(index) = ((index) + ++hs_step) & hs_mask; \
+	size_t hs_new_size = (h).used + hs_count; \
+	if (hs_new_size < hs_count || hs_count > SIZE_MAX / (2 * sizeof(size_t))) { /* Integer overflow */ \
+		(success) = false; \
+		break; \
 	} \
-	if ((h).flags[(index)] == 1) { \
-		(absent) = 0; \
+	hs_reserve((h), key_type, hs_new_size < 2 ? 2 : hs_new_size, (success), hash_func); \
+	if (!(success)) { \
+		break; \
+	} \
+	size_t *hs_hashes = malloc(hs_count * 2 * sizeof(size_t)); \
+	if (!hs_hashes) { \
+		(success) = false; \
+		break; \
+	} \
+	for (size_t hs_i = 0; hs_i < hs_count; hs_i++) { \
+		hs_hashes[hs_i] = hash_func((key_array)[hs_i]); \
+	} \
+	size_t *hs_order = hs_hashes + hs_count; \
+	if (hs_count >= HS_BUILD_PARTITION_MIN) { \
+		hs_partition_by_hash(hs_hashes, hs_count, (h).capacity, hs_order); \
 	} else { \
-        if ((h).flags[(index)] == 0) { \
-        	(h).used++; \
+		for (size_t hs_i = 0; hs_i < hs_count; hs_i++) { \
+			hs_order[hs_i] = hs_i; \
 		} \
-		(h).flags[(index)] = 1; \
-		(h).keys[(index)] = (key); \
-		(h).size++; \
-		(absent) = 1; \
 	} \
+	for (size_t hs_i = 0; hs_i < hs_count; hs_i++) { \
+		size_t hs_src = hs_order[hs_i], hs_index; \
+		int hs_absent; \
+		hs_put_hashed((h), (key_array)[hs_src], hs_hashes[hs_src], hs_index, hs_absent, eq_func); \
+		(void) hs_absent; \
+	} \
+	free(hs_hashes); \
 } while (0)
 
 /** Delete an element from the hash set by its index. */
@@ -207,6 +652,17 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 	(h).size--; \
 } while (0)
 
+/**
+ * Delete an element from the hash set by its index and shrink the hash set if the number of its elements
+ * fell below the minimum load factor (see hs_maybe_shrink()).
+ *
+ * Unlike hs_delete() this macro can invalidate indices, so it must not be used during iteration.
+ */
+#define hs_delete_shrink(h, key_type, index, success, hash_func) do { \
+	hs_delete((h), (index)); \
+	hs_maybe_shrink((h), key_type, (success), hash_func); \
+} while (0)
+
 /** Return first index for iteration over hash set. */
 #define hs_begin(h) (0)
 
@@ -219,11 +675,9 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 /** Access key by hash set element index */
 #define hs_key(h, index) ((h).keys[(index)])
 
+/** Find the first valid element index not less than \p index (skips empty and deleted slots in bulk). */
 static inline size_t hs_next_valid_index(const char *flags, size_t capacity, size_t index) {
-	while (index < capacity && flags[index] != 1) {
-		index++;
-	}
-	return index;
+	return bitops_find_byte(flags, capacity, index, 1);
 }
 
 /** For each loop over the hash set using provided \p index variable.
@@ -236,6 +690,137 @@ static inline size_t hs_next_valid_index(const char *flags, size_t capacity, siz
 	index++, index = hs_next_valid_index((h).flags, (h).capacity, index) \
 )
 
+/**
+ * A hash set struct definition with inline storage for up to \p n elements.
+ *
+ * The first \p n elements are stored inside the struct itself and looked up using linear search, so small hash
+ * tables don't allocate any memory. Insertion of more elements moves them into a regular hash set (`table` field),
+ * which is used from then on.
+ */
+#define HS_SMALL(key_type, n) struct { \
+	HS(key_type) table; \
+	size_t small_size; \
+	key_type small_keys[(n)]; \
+}
+
+/** Small hash set initialization. No heap allocation will be performed. */
+#define hs_small_init(h) do { hs_init((h).table); (h).small_size = 0; } while (0)
+
+/** Destroy small hash set. */
+#define hs_small_destroy(h) hs_destroy((h).table)
+
+/** Get number of elements that can be stored inline. */
+#define hs_small_inline_capacity(h) (sizeof((h).small_keys) / sizeof((h).small_keys[0]))
+
+/** Check if elements are stored inline (the hash set is not moved to the heap yet). */
+#define hs_small_is_inline(h) (!(h).table.capacity)
+
+/** Get number of elements stored in the small hash set. */
+#define hs_small_size(h) (hs_small_is_inline(h) ? (h).small_size : hs_size((h).table))
+
+/** Clear small hash set (the heap memory is kept if the hash set was moved to the heap). */
+#define hs_small_clear(h) do { (h).small_size = 0; hs_clear((h).table); } while (0)
+
+/** Verify small hash set element index for validity (needed for hs_small_get() and for iteration) */
+#define hs_small_valid(h, index) (hs_small_is_inline(h) ? (index) < (h).small_size : hs_valid((h).table, (index)))
+
+/** Access key by small hash set element index */
+#define hs_small_key(h, index) (*(hs_small_is_inline(h) ? &(h).small_keys[(index)] : &hs_key((h).table, (index))))
+
+/**
+ * Perform small hash set lookup and return in \p result index of matched element if any.
+ *
+ * You have to check returned value with hs_small_valid() to determine if the element has been found.
+ */
+#define hs_small_get(h, key, result, hash_func, eq_func) do { \
+	if (hs_small_is_inline(h)) { \
+		for ((result) = 0; (result) < (h).small_size && !eq_func((h).small_keys[(result)], (key)); (result)++); \
+		break; \
+	} \
+	hs_get((h).table, (key), (result), hash_func, eq_func); \
+} while (0)
+
+/**
+ * Insert an element inside the small hash set and return its index (\p absent has the same meaning as for hs_put()).
+ *
+ * When inline storage is full, all elements are moved into the heap hash set. Indices obtained before are invalidated.
+ * In case of memory allocation failure the small hash set remains untouched.
+ */
+#define hs_small_put(h, key_type, key, index, absent, hash_func, eq_func) do { \
+	if (hs_small_is_inline(h)) { \
+		for ((index) = 0; (index) < (h).small_size && !eq_func((h).small_keys[(index)], (key)); (index)++); \
+		if ((index) < (h).small_size) { \
+			(absent) = 0; \
+			break; \
+		} \
+		if ((h).small_size < hs_small_inline_capacity(h)) { \
+			(h).small_keys[(index)] = (key); \
+			(h).small_size++; \
+			(absent) = 1; \
+			break; \
+		} \
+		bool hs_small_success; \
+		hs_reserve((h).table, key_type, 2 * hs_small_inline_capacity(h), hs_small_success, hash_func); \
+		if (!hs_small_success) { \
+			(absent) = -1; \
+			break; \
+		} \
+		for (size_t hs_small_i = 0; hs_small_i < (h).small_size; hs_small_i++) { \
+			size_t hs_small_index; \
+			int hs_small_absent; \
+			hs_put_hashed((h).table, (h).small_keys[hs_small_i], hash_func((h).small_keys[hs_small_i]), hs_small_index, hs_small_absent, eq_func); \
+			(void) hs_small_absent; \
+		} \
+		(h).small_size = 0; \
+	} \
+	hs_put((h).table, key_type, (key), (index), (absent), hash_func, eq_func); \
+} while (0)
+
+/**
+ * Delete an element from the small hash set by its index.
+ *
+ * Inline storage is kept dense: the last element is moved into the freed index, so when deleting during
+ * hs_small_for_each() iteration that element is skipped unless the same index is visited again.
+ */
+#define hs_small_delete(h, index) do { \
+	if (hs_small_is_inline(h)) { \
+		(h).small_size--; \
+		(h).small_keys[(index)] = (h).small_keys[(h).small_size]; \
+	} else { \
+		hs_delete((h).table, (index)); \
+	} \
+} while (0)
+
+/** Return last index for iteration over small hash set. */
+#define hs_small_end(h) (hs_small_is_inline(h) ? (h).small_size : hs_end((h).table))
+
+/** Find the first valid small hash set element index not less than \p index. */
+#define hs_small_next_valid_index(h, index) \
+(hs_small_is_inline(h) ? (index) : hs_next_valid_index((h).table.flags, (h).table.capacity, (index)))
+
+/** For each loop for the small hash set. */
+#define hs_small_for_each(h, index) for ( \
+	size_t index = hs_small_next_valid_index((h), 0); \
+	index < hs_small_end((h)); \
+	index++, index = hs_small_next_valid_index((h), index) \
+)
+
+/** Lookup implementation for the small hash set with integer keys */
+#define hs_small_get_int(h, key, result) \
+hs_small_get((h), (key), (result), hs_int_hash, hs_int_eq)
+
+/** Insertion implementation for the small hash set with integer keys */
+#define hs_small_put_int(h, key, index, absent) \
+hs_small_put((h), int, (key), (index), (absent), hs_int_hash, hs_int_eq)
+
+/** Lookup implementation for the small hash set with string keys */
+#define hs_small_get_str(h, key, result) \
+hs_small_get((h), (key), (result), hs_str_hash, hs_str_eq)
+
+/** Insertion implementation for the small hash set with string keys */
+#define hs_small_put_str(h, key, index, absent) \
+hs_small_put((h), const char*, (key), (index), (absent), hs_str_hash, hs_str_eq)
+
 /** Default hash implementation for integers */
 #define hs_int_hash(x) ((size_t) (x))
 
@@ -244,7 +829,7 @@ static inline size_t hs_next_valid_index(const char *flags, size_t capacity, siz
 
 /** Reserve implementation for the hash set with integer keys */
 #define hs_reserve_int(h, new_capacity, success) \
-hs_reserve((h), int, (new_capacity), (success), hs_int_hash, hs_int_eq)
+hs_reserve((h), int, (new_capacity), (success), hs_int_hash)
 
 /** Lookup implementation for the hash set with integer keys */
 #define hs_get_int(h, key, result) \
@@ -254,6 +839,100 @@ hs_get((h), (key), (result), hs_int_hash, hs_int_eq)
 #define hs_put_int(h, key, index, absent) \
 hs_put((h), int, (key), (index), (absent), hs_int_hash, hs_int_eq)
 
+/** Bulk insertion implementation for the hash set with integer keys */
+#define hs_build_from_array_int(h, key_array, count, success) \
+hs_build_from_array((h), int, (key_array), (count), (success), hs_int_hash, hs_int_eq)
+
+/** Hash implementation for 32-bit integers (MurmurHash3 finalizer, all bits affect the lower ones) */
+static inline size_t hs_u32_hash(uint32_t x) {
+	x ^= x >> 16;
+	x *= 0x85EBCA6Bu;
+	x ^= x >> 13;
+	x *= 0xC2B2AE35u;
+	x ^= x >> 16;
+	return (size_t) x;
+}
+
+/** Hash implementation for 64-bit integers (SplitMix64 finalizer, all bits affect the lower ones) */
+static inline size_t hs_u64_hash(uint64_t x) {
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ull;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBull;
+	x ^= x >> 31;
+	return (size_t) x;
+}
+
+/** Hash implementation for signed 64-bit integers */
+#define hs_i64_hash(x) hs_u64_hash((uint64_t) (x))
+
+/** Hash implementation for pointers */
+#define hs_ptr_hash(x) hs_u64_hash((uint64_t) (uintptr_t) (x))
+
+/** Reserve implementation for the hash set with 32-bit unsigned integer keys */
+#define hs_reserve_u32(h, new_capacity, success) \
+hs_reserve((h), uint32_t, (new_capacity), (success), hs_u32_hash)
+
+/** Lookup implementation for the hash set with 32-bit unsigned integer keys */
+#define hs_get_u32(h, key, result) \
+hs_get((h), (key), (result), hs_u32_hash, hs_int_eq)
+
+/** Insertion implementation for the hash set with 32-bit unsigned integer keys */
+#define hs_put_u32(h, key, index, absent) \
+hs_put((h), uint32_t, (key), (index), (absent), hs_u32_hash, hs_int_eq)
+
+/** Bulk insertion implementation for the hash set with 32-bit unsigned integer keys */
+#define hs_build_from_array_u32(h, key_array, count, success) \
+hs_build_from_array((h), uint32_t, (key_array), (count), (success), hs_u32_hash, hs_int_eq)
+
+/** Reserve implementation for the hash set with 64-bit unsigned integer keys */
+#define hs_reserve_u64(h, new_capacity, success) \
+hs_reserve((h), uint64_t, (new_capacity), (success), hs_u64_hash)
+
+/** Lookup implementation for the hash set with 64-bit unsigned integer keys */
+#define hs_get_u64(h, key, result) \
+hs_get((h), (key), (result), hs_u64_hash, hs_int_eq)
+
+/** Insertion implementation for the hash set with 64-bit unsigned integer keys */
+#define hs_put_u64(h, key, index, absent) \
+hs_put((h), uint64_t, (key), (index), (absent), hs_u64_hash, hs_int_eq)
+
+/** Bulk insertion implementation for the hash set with 64-bit unsigned integer keys */
+#define hs_build_from_array_u64(h, key_array, count, success) \
+hs_build_from_array((h), uint64_t, (key_array), (count), (success), hs_u64_hash, hs_int_eq)
+
+/** Reserve implementation for the hash set with 64-bit signed integer keys */
+#define hs_reserve_i64(h, new_capacity, success) \
+hs_reserve((h), int64_t, (new_capacity), (success), hs_i64_hash)
+
+/** Lookup implementation for the hash set with 64-bit signed integer keys */
+#define hs_get_i64(h, key, result) \
+hs_get((h), (key), (result), hs_i64_hash, hs_int_eq)
+
+/** Insertion implementation for the hash set with 64-bit signed integer keys */
+#define hs_put_i64(h, key, index, absent) \
+hs_put((h), int64_t, (key), (index), (absent), hs_i64_hash, hs_int_eq)
+
+/** Bulk insertion implementation for the hash set with 64-bit signed integer keys */
+#define hs_build_from_array_i64(h, key_array, count, success) \
+hs_build_from_array((h), int64_t, (key_array), (count), (success), hs_i64_hash, hs_int_eq)
+
+/** Reserve implementation for the hash set with pointer keys (`HS(const void*)`) */
+#define hs_reserve_ptr(h, new_capacity, success) \
+hs_reserve((h), const void*, (new_capacity), (success), hs_ptr_hash)
+
+/** Lookup implementation for the hash set with pointer keys (`HS(const void*)`) */
+#define hs_get_ptr(h, key, result) \
+hs_get((h), (key), (result), hs_ptr_hash, hs_int_eq)
+
+/** Insertion implementation for the hash set with pointer keys (`HS(const void*)`) */
+#define hs_put_ptr(h, key, index, absent) \
+hs_put((h), const void*, (key), (index), (absent), hs_ptr_hash, hs_int_eq)
+
+/** Bulk insertion implementation for the hash set with pointer keys (`HS(const void*)`) */
+#define hs_build_from_array_ptr(h, key_array, count, success) \
+hs_build_from_array((h), const void*, (key_array), (count), (success), hs_ptr_hash, hs_int_eq)
+
 /** Default hash implementation for strings */
 static inline size_t hs_str_hash(const char *s) {
 	size_t h = (size_t) *s;
@@ -268,18 +947,63 @@ static inline size_t hs_str_hash(const char *s) {
 /** Default equality implementation for strings */
 #define hs_str_eq(a, b) (strcmp((a), (b)) == 0)
 
+/** Character array key for hs_get_strn(). Normally shouldn't be used directly from user code. */
+typedef struct hs_strn {
+	const char *ptr;
+	size_t len;
+} hs_strn_t;
+
+/**
+ * Hash implementation for character arrays.
+ *
+ * Gives the same result as hs_str_hash() for strings without NULL characters inside.
+ */
+static inline size_t hs_strn_hash(const char *s, size_t len) {
+	size_t h = 0;
+	for (size_t i = 0; i < len; i++) {
+		h = (h << 5) - h + (size_t) s[i];
+	}
+	return h;
+}
+
+/** Equality implementation for a NULL-terminated string \p a and a character array \p b of \p len characters */
+static inline bool hs_strn_eq(const char *a, const char *b, size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		if (a[i] != b[i] || !a[i]) {
+			return false;
+		}
+	}
+	return a[len] == '\0';
+}
+
+/** Equality implementation for a stored string key and hs_strn_t */
+#define hs_strn_key_eq(a, b) hs_strn_eq((a), (b).ptr, (b).len)
+
 /** Reserve implementation for the hash set with string keys */
 #define hs_reserve_str(h, new_capacity, success) \
-hs_reserve((h), const char*, (new_capacity), (success), hs_str_hash, hs_str_eq)
+hs_reserve((h), const char*, (new_capacity), (success), hs_str_hash)
 
 /** Lookup implementation for the hash set with string keys */
 #define hs_get_str(h, key, result) \
 hs_get((h), (key), (result), hs_str_hash, hs_str_eq)
 
+/**
+ * Lookup implementation for the hash set with string keys using a character array \p chars of \p chars_size characters
+ * (it doesn't have to be NULL-terminated, e.g. it can be a part of a larger buffer).
+ */
+#define hs_get_strn(h, chars, chars_size, result) do { \
+	hs_strn_t hs_strn_key = { (chars), (chars_size) }; \
+	hs_get_hashed((h), hs_strn_key, hs_strn_hash(hs_strn_key.ptr, hs_strn_key.len), (result), hs_strn_key_eq); \
+} while (0)
+
 /** Insertion implementation for the hash set with string keys */
 #define hs_put_str(h, key, index, absent) \
 hs_put((h), const char*, (key), (index), (absent), hs_str_hash, hs_str_eq)
 
+/** Bulk insertion implementation for the hash set with string keys */
+#define hs_build_from_array_str(h, key_array, count, success) \
+hs_build_from_array((h), const char*, (key_array), (count), (success), hs_str_hash, hs_str_eq)
+
 /** Combine two hash values to get a new one. Useful for writing composite key hash functions */
 static inline size_t hs_hash_combine(size_t a, size_t b) {
 	return a ^ (b + 0x9E3779B9 + (a << 6) + (a >> 2));
@@ -49,23 +49,139 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include "roundup.h"
+#include "bitops.h"
+
+/** Default maximum load factor of a hash table */
+#define HT_DEFAULT_MAX_LOAD 0.75f
+
+/** Default minimum load factor of a hash table (0 disables automatic shrinking) */
+#define HT_DEFAULT_MIN_LOAD 0.0f
+
+#ifdef HT_STATS
+#include <stdio.h>
+#include <time.h>
+
+#ifndef HT_STATS_PROBE_BUCKETS
+/** Number of probe length histogram buckets (the last one counts all longer probe sequences). */
+#define HT_STATS_PROBE_BUCKETS 16
+#endif
+
+/**
+ * Hash table statistics (collected only if HT_STATS is defined).
+ *
+ * HT_STATS changes the hash table struct layout, so it must be defined for all code sharing hash tables
+ * (including the library itself).
+ */
+typedef struct ht_stats {
+	size_t gets; //!< Number of lookups.
+	size_t puts; //!< Number of insertions (including ones which found an existing key).
+	size_t probes[HT_STATS_PROBE_BUCKETS]; //!< Histogram of lookup and insertion probe lengths.
+	size_t max_probe; //!< Maximal probe length.
+	size_t rehashes; //!< Number of rehashes.
+	double rehash_seconds; //!< Total duration of rehashes.
+	size_t bytes_allocated; //!< Total number of bytes allocated by rehashes.
+} ht_stats_t;
+
+/** Get current time in seconds for rehash duration statistics. */
+static inline double ht_stats_now(void) {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+/** Add a probe length to the histogram. */
+static inline void ht_stats_record_probe(ht_stats_t *stats, size_t probe) {
+	stats->probes[probe < HT_STATS_PROBE_BUCKETS - 1 ? probe : HT_STATS_PROBE_BUCKETS - 1]++;
+	if (probe > stats->max_probe) {
+		stats->max_probe = probe;
+	}
+}
+
+/** Print hash table statistics and the probe length histogram. */
+static inline void ht_stats_print(const ht_stats_t *stats, size_t size, size_t used, size_t capacity, FILE *out) {
+	fprintf(out, "size %zu, capacity %zu, load %.3f, tombstones %.3f\n", size, capacity,
+			capacity ? (double) size / (double) capacity : 0.0,
+			capacity ? (double) (used - size) / (double) capacity : 0.0);
+	fprintf(out, "lookups %zu, insertions %zu, max probe length %zu\n", stats->gets, stats->puts, stats->max_probe);
+	fprintf(out, "rehashes %zu, %.6f s, %zu bytes allocated\n", stats->rehashes, stats->rehash_seconds,
+			stats->bytes_allocated);
+	size_t max_count = 0;
+	for (size_t i = 0; i < HT_STATS_PROBE_BUCKETS; i++) {
+		if (stats->probes[i] > max_count) {
+			max_count = stats->probes[i];
+		}
+	}
+	fprintf(out, "probe length histogram:\n");
+	for (size_t i = 0; i < HT_STATS_PROBE_BUCKETS; i++) {
+		if (!stats->probes[i]) continue;
+		fprintf(out, "%4zu%s |", i, i == HT_STATS_PROBE_BUCKETS - 1 ? "+" : " ");
+		size_t width = (size_t) ((double) stats->probes[i] * 40.0 / (double) max_count);
+		for (size_t j = 0; j < (width ? width : 1); j++) {
+			fputc('#', out);
+		}
+		fprintf(out, " %zu\n", stats->probes[i]);
+	}
+}
+
+/** Hash table struct statistics field. Normally shouldn't be used directly from user code. */
+#define HT_STATS_FIELD ht_stats_t stats;
+
+/** Reset hash table statistics. */
+#define ht_stats_reset(h) memset(&(h).stats, 0, sizeof((h).stats))
+
+/** Access hash table statistics (ht_stats_t). */
+#define ht_stats(h) ((h).stats)
+
+/** Print hash table statistics and the probe length histogram to \p out (does nothing if HT_STATS isn't defined). */
+#define ht_stats_dump(h, out) ht_stats_print(&(h).stats, (h).size, (h).used, (h).capacity, (out))
+
+/** Record a lookup. Normally shouldn't be used directly from user code. */
+#define HT_STATS_GET(h, probe) do { (h).stats.gets++; ht_stats_record_probe(&(h).stats, (probe)); } while (0)
+
+/** Record an insertion. Normally shouldn't be used directly from user code. */
+#define HT_STATS_PUT(h, probe) do { (h).stats.puts++; ht_stats_record_probe(&(h).stats, (probe)); } while (0)
+
+/** Start measuring a rehash. Normally shouldn't be used directly from user code. */
+#define HT_STATS_REHASH_BEGIN() double ht_stats_start = ht_stats_now()
+
+/** Record a rehash. Normally shouldn't be used directly from user code. */
+#define HT_STATS_REHASH_END(h, bytes) do { \
+	(h).stats.rehashes++; \
+	(h).stats.rehash_seconds += ht_stats_now() - ht_stats_start; \
+	(h).stats.bytes_allocated += (bytes); \
+} while (0)
+#else
+#define HT_STATS_FIELD
+#define ht_stats_reset(h) ((void) 0)
+#define ht_stats_dump(h, out) ((void) (out))
+#define HT_STATS_GET(h, probe) ((void) 0)
+#define HT_STATS_PUT(h, probe) ((void) 0)
+#define HT_STATS_REHASH_BEGIN() ((void) 0)
+#define HT_STATS_REHASH_END(h, bytes) ((void) 0)
+#endif
 
 /** A hash table struct definition */
 #define HT(key_type, value_type) struct { \
-	size_t size, used, max_used, capacity; \
+	size_t size, used, max_used, min_used, capacity; \
+	float max_load, min_load; \
 	char *flags; \
 	key_type *keys; \
 	value_type *values; \
+	HT_STATS_FIELD \
 }
 
 /** Initialize a empty hash table (no memory allocation performed). */
 #define ht_init(h) do { \
-	(h).size = (h).used = (h).max_used = (h).capacity = 0; \
+	(h).size = (h).used = (h).max_used = (h).min_used = (h).capacity = 0; \
+	(h).max_load = HT_DEFAULT_MAX_LOAD; \
+	(h).min_load = HT_DEFAULT_MIN_LOAD; \
 	(h).flags = NULL; \
 	(h).keys = NULL; \
 	(h).values = NULL; \
+	ht_stats_reset((h)); \
 } while (0)
 
 /**
@@ -84,95 +200,368 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 /** Get maximum number of elements that can be stored in the hash table before rehashing. */
 #define ht_max_used(h) ((h).max_used)
 
+/** Get number of elements below which the hash table is shrunk automatically. */
+#define ht_min_used(h) ((h).min_used)
+
 /** Get total hash table size. */
 #define ht_capacity(h) ((h).capacity)
 
+/** Get maximum load factor of the hash table. */
+#define ht_max_load(h) ((h).max_load)
+
+/** Get minimum load factor of the hash table. */
+#define ht_min_load(h) ((h).min_load)
+
+/** Compute how many slots of a hash table with \p capacity can be occupied with given \p max_load. */
+static inline size_t ht_max_used_for(size_t capacity, float max_load) {
+	size_t limit = (size_t) ((double) capacity * max_load);
+	if (limit >= capacity) {
+		limit = capacity - 1; // At least one slot must be empty to stop probing
+	}
+	if (!limit && capacity > 1) {
+		limit = 1;
+	}
+	return limit;
+}
+
+/** Compute how many elements a hash table with \p capacity can hold before it is shrunk with given \p min_load. */
+static inline size_t ht_min_used_for(size_t capacity, float min_load) {
+	return min_load > 0.0f ? (size_t) ((double) capacity * min_load) : 0;
+}
+
+/**
+ * Compute minimal hash table capacity (a power of 2) able to hold \p count elements with given \p max_load.
+ * Returns 0 in case of integer overflow.
+ */
+static inline size_t ht_capacity_for(size_t count, float max_load) {
+	size_t capacity = count;
+	roundupsize(capacity);
+	if (capacity < count) { // Integer overflow
+		return 0;
+	}
+	while (ht_max_used_for(capacity, max_load) < count) {
+		if (capacity > SIZE_MAX / 2) { // Integer overflow
+			return 0;
+		}
+		capacity <<= 1;
+	}
+	return capacity;
+}
+
+/**
+ * Set maximum and minimum load factors of the hash table.
+ *
+ * \p max_load must be in (0, 1) range. The hash table is grown when the number of occupied slots
+ * (including deleted ones) exceeds `max_load * capacity`. \p min_load must be in [0, max_load / 4] range,
+ * if it isn't zero, the hash table is shrunk when the number of elements falls below `min_load * capacity`.
+ * New values take effect immediately without rehashing.
+ */
+#define ht_set_load_factor(h, new_max_load, new_min_load) do { \
+	(h).max_load = (new_max_load); \
+	(h).min_load = (new_min_load); \
+	(h).max_used = (h).capacity ? ht_max_used_for((h).capacity, (h).max_load) : 0; \
+	(h).min_used = ht_min_used_for((h).capacity, (h).min_load); \
+} while (0)
+
+#if defined(_OPENMP) && !defined(HT_NO_PARALLEL_REHASH)
+/** Nonzero if large hash tables are rehashed by multiple threads (requires OpenMP, define HT_NO_PARALLEL_REHASH to disable). */
+#define HT_PARALLEL_REHASH 1
+/** Emit a pragma from a macro body (only when OpenMP is enabled). */
+#define HT_OMP_PRAGMA(x) _Pragma(#x)
+#else
+/** Nonzero if large hash tables are rehashed by multiple threads (requires OpenMP, define HT_NO_PARALLEL_REHASH to disable). */
+#define HT_PARALLEL_REHASH 0
+/** Emit a pragma from a macro body (only when OpenMP is enabled). */
+#define HT_OMP_PRAGMA(x)
+#endif
+
+#ifndef HT_PARALLEL_REHASH_MIN
+/** Minimal capacity of a hash table which is rehashed by multiple threads. */
+#define HT_PARALLEL_REHASH_MIN 65536
+#endif
+
+/**
+ * Mark an empty slot as occupied (atomically if parallel rehash is enabled). Returns false if the slot has been occupied already.
+ * Used for parallel rehash. Normally shouldn't be used directly from user code.
+ */
+static inline bool ht_claim_slot(char *flags, size_t index) {
+#if !HT_PARALLEL_REHASH
+	if (flags[index]) {
+		return false;
+	}
+	flags[index] = 1;
+	return true;
+#elif defined(_MSC_VER) && !defined(__clang__)
+	return _InterlockedCompareExchange8(&flags[index], 1, 0) == 0;
+#else
+	char expected = 0;
+	return __atomic_compare_exchange_n(&flags[index], &expected, 1, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+#endif
+}
+
 /** Clear hash table */
 #define ht_clear(h) do { (h).size = 0; (h).used = 0; if ((h).flags) { memset((h).flags, 0, (h).capacity); } } while (0)
 
+#if defined(__GNUC__)
 /**
- * Resize hash table to be able to hold at least new_capacity elements.
+ * Hide the origin of a freshly allocated array from the optimizer (no code is emitted). After inlining
+ * ht_rehash() GCC otherwise warns that slots of the new arrays may be read uninitialized: it can't see
+ * that a slot is only read after its flag says that it was written.
+ */
+#define HT_LAUNDER(ptr) __asm__("" : "+r"(ptr) : : "memory")
+#else
+#define HT_LAUNDER(ptr) ((void) 0)
+#endif
+
+/**
+ * Rebuild hash table with exactly \p new_capacity slots (must be a power of 2 able to hold all elements).
  * Success will be assigned to false in case of memory allocation failure.
+ *
+ * If OpenMP is enabled, hash tables with at least HT_PARALLEL_REHASH_MIN slots are rehashed by multiple threads
+ * (\p hash_func must be safe to call concurrently). Element positions might differ from a single-threaded rehash.
  */
-#define ht_reserve(h, key_type, value_type, new_capacity, success, hash_func) do { \
-	if (new_capacity <= (h).max_used) { \
-		(success) = true; \
-		break; \
-	} \
-	size_t ht_new_capacity = (new_capacity); \
-	roundupsize(ht_new_capacity); \
-	if (ht_new_capacity < (new_capacity)) { /* Integer overflow */ \
-		(success) = false; \
-		break; \
-	} \
-	size_t ht_new_max_used = (ht_new_capacity >> 1) + (ht_new_capacity >> 2); \
-	if (ht_new_max_used < (new_capacity)) { \
-    	ht_new_capacity <<= 1; \
-		if (ht_new_capacity < (new_capacity)) { /* Integer overflow */ \
-			(success) = false; \
-			break; \
-		} \
-		ht_new_max_used = (ht_new_capacity >> 1) + (ht_new_capacity >> 2); \
-    } \
-	char *ht_new_flags = malloc(ht_new_capacity); \
+#define ht_rehash(h, key_type, value_type, new_capacity, success, hash_func) do { \
+	size_t ht_rehash_capacity = (new_capacity); \
+	HT_STATS_REHASH_BEGIN(); \
+	char *ht_new_flags = malloc(ht_rehash_capacity); \
 	if (!ht_new_flags) { \
 		(success) = false; \
 		break; \
 	} \
-	key_type *ht_new_keys = malloc(ht_new_capacity * sizeof(key_type)); \
+	key_type *ht_new_keys = malloc(ht_rehash_capacity * sizeof(key_type)); \
 	if (!ht_new_keys) { \
 		free(ht_new_flags); \
 		(success) = false; \
 		break; \
 	} \
-	value_type *ht_new_values = malloc(ht_new_capacity * sizeof(value_type)); \
+	value_type *ht_new_values = malloc(ht_rehash_capacity * sizeof(value_type)); \
 	if (!ht_new_values) { \
 		free(ht_new_keys); \
 		free(ht_new_flags); \
 		(success) = false; \
 		break; \
 	} \
-	memset(ht_new_flags, 0, ht_new_capacity); \
-	size_t ht_mask = ht_new_capacity - 1; \
-	for (size_t ht_i = 0; ht_i < (h).capacity; ht_i++) { \
-		if ((h).flags[ht_i] != 1) continue; \
-		size_t ht_j = hash_func((h).keys[ht_i]) & ht_mask; \
-		size_t ht_step = 0; \
-		while (ht_new_flags[ht_j]) { \
-			ht_j = (ht_j + ++ht_step) & ht_mask; \
+	memset(ht_new_flags, 0, ht_rehash_capacity); \
+	size_t ht_mask = ht_rehash_capacity - 1; \
+	if (HT_PARALLEL_REHASH && (h).capacity >= HT_PARALLEL_REHASH_MIN) { \
+		ptrdiff_t ht_old_capacity = (ptrdiff_t) (h).capacity; \
+		HT_OMP_PRAGMA(omp parallel for schedule(static)) \
+		for (ptrdiff_t ht_i = 0; ht_i < ht_old_capacity; ht_i++) { \
+			if ((h).flags[ht_i] != 1) continue; \
+			size_t ht_j = hash_func((h).keys[ht_i]) & ht_mask; \
+			size_t ht_step = 0; \
+			while (!ht_claim_slot(ht_new_flags, ht_j)) { \
+				ht_j = (ht_j + ++ht_step) & ht_mask; \
+			} \
+			ht_new_keys[ht_j] = (h).keys[ht_i]; \
+			ht_new_values[ht_j] = (h).values[ht_i]; \
+		} \
+	} else { \
+		for (size_t ht_i = 0; ht_i < (h).capacity; ht_i++) { \
+			if ((h).flags[ht_i] != 1) continue; \
+			size_t ht_j = hash_func((h).keys[ht_i]) & ht_mask; \
+			size_t ht_step = 0; \
+			while (ht_new_flags[ht_j]) { \
+				ht_j = (ht_j + ++ht_step) & ht_mask; \
+			} \
+			ht_new_flags[ht_j] = 1; \
+			ht_new_keys[ht_j] = (h).keys[ht_i]; \
+			ht_new_values[ht_j] = (h).values[ht_i]; \
 		} \
-		ht_new_flags[ht_j] = 1; \
-		ht_new_keys[ht_j] = (h).keys[ht_i]; \
-		ht_new_values[ht_j] = (h).values[ht_i]; \
 	} \
 	free((h).values); \
 	free((h).keys); \
 	free((h).flags); \
+	HT_LAUNDER(ht_new_flags); \
+	HT_LAUNDER(ht_new_keys); \
+	HT_LAUNDER(ht_new_values); \
 	(h).flags = ht_new_flags; \
 	(h).keys = ht_new_keys; \
 	(h).values = ht_new_values; \
-	(h).capacity = ht_new_capacity; \
+	(h).capacity = ht_rehash_capacity; \
 	(h).used = (h).size; \
-	(h).max_used = ht_new_max_used; \
+	(h).max_used = ht_max_used_for(ht_rehash_capacity, (h).max_load); \
+	(h).min_used = ht_min_used_for(ht_rehash_capacity, (h).min_load); \
+	HT_STATS_REHASH_END((h), ht_rehash_capacity * (1 + sizeof(key_type) + sizeof(value_type))); \
 	(success) = true; \
 } while (0)
 
 /**
- * Perform hash table lookup and return in \p result index of matched element if any.
+ * Resize hash table to be able to hold at least new_capacity elements.
+ * Success will be assigned to false in case of memory allocation failure.
+ */
+#define ht_reserve(h, key_type, value_type, new_capacity, success, hash_func) do { \
+	if ((new_capacity) <= (h).max_used) { \
+		(success) = true; \
+		break; \
+	} \
+	size_t ht_reserve_capacity = ht_capacity_for((new_capacity), (h).max_load); \
+	if (!ht_reserve_capacity) { /* Integer overflow */ \
+		(success) = false; \
+		break; \
+	} \
+	ht_rehash((h), key_type, value_type, ht_reserve_capacity, (success), hash_func); \
+} while (0)
+
+/** Release all memory of an empty hash table keeping its load factors. */
+#define ht_release(h) do { \
+	free((h).values); \
+	free((h).keys); \
+	free((h).flags); \
+	(h).flags = NULL; \
+	(h).keys = NULL; \
+	(h).values = NULL; \
+	(h).used = (h).max_used = (h).min_used = (h).capacity = 0; \
+} while (0)
+
+/**
+ * Shrink hash table to the minimal capacity able to hold its elements (frees all memory if it is empty).
+ * Success will be assigned to false in case of memory allocation failure (the hash table remains untouched).
+ */
+#define ht_shrink_to_fit(h, key_type, value_type, success, hash_func) do { \
+	if (!(h).size) { \
+		ht_release(h); \
+		(success) = true; \
+		break; \
+	} \
+	size_t ht_shrink_capacity = ht_capacity_for((h).size, (h).max_load); \
+	if (!ht_shrink_capacity || ht_shrink_capacity >= (h).capacity) { \
+		(success) = true; \
+		break; \
+	} \
+	ht_rehash((h), key_type, value_type, ht_shrink_capacity, (success), hash_func); \
+} while (0)
+
+/**
+ * Shrink hash table if the number of its elements fell below the minimum load factor.
  *
- * You have to check returned value with ht_valid() to determine if the element has been found.
- * Then you can use ht_key() and ht_value() to access it.
+ * The new capacity leaves room for the hash table to double before the next growth.
+ * Success will be assigned to false in case of memory allocation failure (the hash table remains untouched).
  */
-#define ht_get(h, key, result, hash_func, eq_func) do { \
+#define ht_maybe_shrink(h, key_type, value_type, success, hash_func) do { \
+	if ((h).size >= (h).min_used) { \
+		(success) = true; \
+		break; \
+	} \
+	if (!(h).size) { \
+		ht_release(h); \
+		(success) = true; \
+		break; \
+	} \
+	size_t ht_shrink_capacity = ht_capacity_for((h).size * 2, (h).max_load); \
+	if (!ht_shrink_capacity || ht_shrink_capacity >= (h).capacity) { \
+		(success) = true; \
+		break; \
+	} \
+	ht_rehash((h), key_type, value_type, ht_shrink_capacity, (success), hash_func); \
+} while (0)
+
+/**
+ * Probe the hash table for \p key with precomputed \p hash, storing the matched index in \p result and the probe
+ * length in \p step. Normally shouldn't be used directly from user code.
+ */
+#define ht_probe_hashed(h, key, hash, result, step, eq_func) do { \
 	if (!(h).size) { \
 		(result) = 0; \
 		break; \
 	} \
 	size_t ht_mask = (h).capacity - 1; \
-	(result) = hash_func(key) & ht_mask; \
-	size_t ht_step = 0; \
+	(result) = (hash) & ht_mask; \
 	while ((h).flags[(result)] == 2 || ((h).flags[(result)] == 1 && !eq_func((h).keys[(result)], (key)))) { \
-		(result) = ((result) + ++ht_step) & ht_mask; \
+		(result) = ((result) + ++(step)) & ht_mask; \
+	} \
+} while (0)
+
+/**
+ * Perform hash table lookup using precomputed \p hash of \p key and return in \p result index of matched element if any.
+ *
+ * \p key doesn't need to have the key type as long as `eq_func(stored_key, key)` can compare them and \p hash
+ * is computed the same way as for stored keys.
+ */
+#define ht_get_hashed(h, key, hash, result, eq_func) do { \
+	size_t ht_step = 0; \
+	ht_probe_hashed((h), (key), (hash), (result), ht_step, eq_func); \
+	if ((h).size) { \
+		HT_STATS_GET((h), ht_step); \
+	} \
+} while (0)
+
+/**
+ * Same as ht_get_hashed() but never records statistics, so the hash table isn't written to and may be const
+ * (e.g. shared by concurrent readers).
+ */
+#define ht_get_hashed_nostats(h, key, hash, result, eq_func) do { \
+	size_t ht_step = 0; \
+	ht_probe_hashed((h), (key), (hash), (result), ht_step, eq_func); \
+	(void) ht_step; \
+} while (0)
+
+/**
+ * Perform hash table lookup and return in \p result index of matched element if any.
+ *
+ * You have to check returned value with ht_valid() to determine if the element has been found.
+ * Then you can use ht_key() and ht_value() to access it.
+ */
+#define ht_get(h, key, result, hash_func, eq_func) \
+ht_get_hashed((h), (key), hash_func(key), (result), eq_func)
+
+/**
+ * Insert an element with precomputed \p hash inside the hash table and return its index.
+ *
+ * Unlike ht_put() this macro doesn't grow the hash table, so the caller must ensure that there is a room for
+ * one more element (e.g. using ht_reserve()). \p absent has the same meaning as for ht_put() except that -1
+ * is never returned.
+ */
+#define ht_put_hashed(h, key, hash, index, absent, eq_func) do { \
+	size_t ht_mask = (h).capacity - 1; \
+	(index) = (hash) & ht_mask; \
+	size_t ht_step = 0; \
+	size_t ht_deleted = (h).capacity; \
+	while ((h).flags[(index)] == 2 || ((h).flags[(index)] == 1 && !eq_func((h).keys[(index)], (key)))) { \
+		if ((h).flags[(index)] == 2 && ht_deleted == (h).capacity) { \
+			ht_deleted = (index); \
+		} \
+		(index) = ((index) + ++ht_step) & ht_mask; \
+	} \
+	HT_STATS_PUT((h), ht_step); \
+	if ((h).flags[(index)] == 1) { \
+		(absent) = 0; \
+	} else { \
+		if (ht_deleted != (h).capacity) { \
+			(index) = ht_deleted; \
+		} else { \
+			(h).used++; \
+		} \
+		(h).flags[(index)] = 1; \
+		(h).keys[(index)] = (key); \
+		(h).size++; \
+		(absent) = 1; \
+	} \
+} while (0)
+
+/**
+ * Make sure that one more element can be inserted into the hash table with ht_put_hashed(),
+ * growing it or dropping deleted elements if needed (and shrinking it if it is below the minimum load factor).
+ * Success will be assigned to false in case of memory allocation failure.
+ */
+#define ht_ensure_room(h, key_type, value_type, success, hash_func) do { \
+	if ((h).size < (h).min_used) { \
+		ht_maybe_shrink((h), key_type, value_type, (success), hash_func); /* Failure isn't fatal here */ \
+	} \
+	(success) = true; \
+	if ((h).used >= (h).max_used) { \
+		size_t ht_new_capacity = (h).capacity; \
+		if ((h).size >= (h).max_used / 2) { /* Otherwise just drop deleted elements */ \
+			ht_new_capacity = ht_capacity_for((h).size ? (h).size + 1 : 2, (h).max_load); \
+			if (ht_new_capacity <= (h).capacity) { \
+				ht_new_capacity = (h).capacity <= SIZE_MAX / 2 ? (h).capacity << 1 : 0; \
+			} \
+			if (!ht_new_capacity) { /* Integer overflow */ \
+				(success) = false; \
+				break; \
+			} \
+		} \
+		ht_rehash((h), key_type, value_type, ht_new_capacity, (success), hash_func); \
 	} \
 } while (0)
 
@@ -186,41 +575,224 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 #define ht_put(h, key_type, value_type, key, index, absent, hash_func, eq_func) do { \
 	bool ht_success; \
-	size_t ht_new_size = (h).used ? (h).used + 1 : 2; \
-	if (ht_new_size < (h).used) { /* Integer overflow */ \
+	ht_ensure_room((h), key_type, value_type, ht_success, hash_func); \
+	if (!ht_success) { \
 		(absent) = -1; \
 		break; \
 	} \
-	ht_reserve((h), key_type, value_type, ht_new_size, ht_success, hash_func); \
-	if (!ht_success) { \
-		(absent) = -1; \
+	ht_put_hashed((h), (key), hash_func(key), (index), (absent), eq_func); \
+} while (0)
+
+#ifndef HT_BUILD_PARTITION_BITS
+/** Number of hash bits used to partition keys during ht_build_from_arrays() (up to 2^N partitions). */
+#define HT_BUILD_PARTITION_BITS 8
+#endif
+
+#ifndef HT_BUILD_PARTITION_MIN
+/** Minimal number of elements for ht_build_from_arrays() to partition keys before insertion. */
+#define HT_BUILD_PARTITION_MIN 4096
+#endif
+
+/**
+ * Fill \p order with indices of \p hashes sorted by the high bits of their slot in a table of size \p capacity
+ * (one pass of a radix sort). Normally shouldn't be used directly from user code.
+ */
+static inline void ht_partition_by_hash(const size_t *hashes, size_t count, size_t capacity, size_t *order) {
+	size_t counts[1 << HT_BUILD_PARTITION_BITS];
+	size_t mask = capacity - 1;
+	unsigned int shift = 0;
+	while ((capacity >> shift) > ((size_t) 1 << HT_BUILD_PARTITION_BITS)) {
+		shift++;
+	}
+	size_t partitions = capacity >> shift;
+	memset(counts, 0, partitions * sizeof(size_t));
+	for (size_t i = 0; i < count; i++) {
+		counts[(hashes[i] & mask) >> shift]++;
+	}
+	size_t offset = 0;
+	for (size_t i = 0; i < partitions; i++) {
+		size_t partition_size = counts[i];
+		counts[i] = offset;
+		offset += partition_size;
+	}
+	for (size_t i = 0; i < count; i++) {
+		order[counts[(hashes[i] & mask) >> shift]++] = i;
+	}
+}
+
+/**
+ * Insert \p count elements from \p key_array and \p value_array into the hash table.
+ *
+ * The hash table is resized at most once, hashes are computed in a separate pass and large inputs are inserted
+ * in the order of their slots, so the insertion touches the memory almost sequentially.
+ * If a key is repeated, the last value wins. Success will be assigned to false in case of memory allocation failure
+ * (the elements inserted so far remain in the hash table).
+ */
+#define ht_build_from_arrays(h, key_type, value_type, key_array, value_array, count, success, hash_func, eq_func) do { \
+	size_t ht_count = (count); \
+	if (!ht_count) { \
+		(success) = true; \
 		break; \
 	} \
-	size_t ht_mask = (h).capacity - 1; \
-	(index) = hash_func(key) & ht_mask; \
-	size_t ht_step = 0; \
-	while ((h).flags[(index)] == 1 && !eq_func((h).keys[(index)], (key))) { \
-		(index) = ((index) + ++ht_step) & ht_mask; \
+	size_t ht_new_size = (h).used + ht_count; \
+	if (ht_new_size < ht_count || ht_count > SIZE_MAX / (2 * sizeof(size_t))) { /* Integer overflow */ \
+		(success) = false; \
+		break; \
 	} \
-	if ((h).flags[(index)] == 1) { \
-		(absent) = 0; \
+	ht_reserve((h), key_type, value_type, ht_new_size < 2 ? 2 : ht_new_size, (success), hash_func); \
+	if (!(success)) { \
+		break; \
+	} \
+	size_t *ht_hashes = malloc(ht_count * 2 * sizeof(size_t)); \
+	if (!ht_hashes) { \
+		(success) = false; \
+		break; \
+	} \
+	for (size_t ht_i = 0; ht_i < ht_count; ht_i++) { \
+		ht_hashes[ht_i] = hash_func((key_array)[ht_i]); \
+	} \
+	size_t *ht_order = ht_hashes + ht_count; \
+	if (ht_count >= HT_BUILD_PARTITION_MIN) { \
+		ht_partition_by_hash(ht_hashes, ht_count, (h).capacity, ht_order); \
 	} else { \
-        if ((h).flags[(index)] == 0) { \
-        	(h).used++; \
+		for (size_t ht_i = 0; ht_i < ht_count; ht_i++) { \
+			ht_order[ht_i] = ht_i; \
+		} \
+	} \
+	for (size_t ht_i = 0; ht_i < ht_count; ht_i++) { \
+		size_t ht_src = ht_order[ht_i], ht_index; \
+		int ht_absent; \
+		ht_put_hashed((h), (key_array)[ht_src], ht_hashes[ht_src], ht_index, ht_absent, eq_func); \
+		(void) ht_absent; \
+		(h).values[ht_index] = (value_array)[ht_src]; \
+	} \
+	free(ht_hashes); \
+} while (0)
+
+#if defined(__GNUC__) || defined(__clang__)
+/** Hint CPU to fetch memory at \p addr into the cache */
+#define HT_PREFETCH(addr) __builtin_prefetch((addr))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+/** Hint CPU to fetch memory at \p addr into the cache */
+#define HT_PREFETCH(addr) _mm_prefetch((const char*) (addr), _MM_HINT_T0)
+#else
+/** Hint CPU to fetch memory at \p addr into the cache */
+#define HT_PREFETCH(addr) ((void) (addr))
+#endif
+
+/** Combine function for ht_upsert_combine() and ht_aggregate_combine() which sums values */
+#define ht_combine_add(a, b) ((a) + (b))
+
+/** Combine function for ht_upsert_combine() and ht_aggregate_combine() which keeps minimal value */
+#define ht_combine_min(a, b) ((b) < (a) ? (b) : (a))
+
+/** Combine function for ht_upsert_combine() and ht_aggregate_combine() which keeps maximal value */
+#define ht_combine_max(a, b) ((b) > (a) ? (b) : (a))
+
+/**
+ * Insert an element with \p init_value if its key is absent and return its index.
+ * Existing element's value is left untouched. \p absent has the same meaning as for ht_put().
+ */
+#define ht_upsert(h, key_type, value_type, key, init_value, index, absent, hash_func, eq_func) do { \
+	ht_put((h), key_type, value_type, (key), (index), (absent), hash_func, eq_func); \
+	if ((absent) == 1) { \
+		(h).values[(index)] = (init_value); \
+	} \
+} while (0)
+
+/**
+ * Insert an element with \p value if its key is absent, otherwise replace existing value with
+ * `combine_func(existing_value, value)`. Returns the element index. \p absent has the same meaning as for ht_put().
+ */
+#define ht_upsert_combine(h, key_type, value_type, key, value, index, absent, hash_func, eq_func, combine_func) do { \
+	ht_put((h), key_type, value_type, (key), (index), (absent), hash_func, eq_func); \
+	if ((absent) == 1) { \
+		(h).values[(index)] = (value); \
+	} else if ((absent) == 0) { \
+		(h).values[(index)] = combine_func((h).values[(index)], (value)); \
+	} \
+} while (0)
+
+/** Add \p delta to the value of an element inserting it with \p delta value if absent (see ht_upsert_combine()). */
+#define ht_increment(h, key_type, value_type, key, delta, index, absent, hash_func, eq_func) \
+ht_upsert_combine((h), key_type, value_type, (key), (delta), (index), (absent), hash_func, eq_func, ht_combine_add)
+
+/** Keep minimum of an element value and \p value inserting the element if absent (see ht_upsert_combine()). */
+#define ht_upsert_min(h, key_type, value_type, key, value, index, absent, hash_func, eq_func) \
+ht_upsert_combine((h), key_type, value_type, (key), (value), (index), (absent), hash_func, eq_func, ht_combine_min)
+
+/** Keep maximum of an element value and \p value inserting the element if absent (see ht_upsert_combine()). */
+#define ht_upsert_max(h, key_type, value_type, key, value, index, absent, hash_func, eq_func) \
+ht_upsert_combine((h), key_type, value_type, (key), (value), (index), (absent), hash_func, eq_func, ht_combine_max)
+
+#ifndef HT_AGGREGATE_BATCH
+/** Number of keys hashed and prefetched ahead by ht_aggregate_combine() */
+#define HT_AGGREGATE_BATCH 16
+#endif
+
+/**
+ * Perform ht_upsert_combine() for \p count keys from \p key_array with values from \p value_array.
+ *
+ * Keys are processed in batches: hashes of a batch are computed first and the slots they point to are prefetched,
+ * so memory accesses of different keys overlap instead of waiting for each other.
+ * Success will be assigned to false in case of memory allocation failure (the elements processed so far remain
+ * in the hash table).
+ */
+#define ht_aggregate_combine(h, key_type, value_type, key_array, value_array, count, success, hash_func, eq_func, \
+		combine_func) do { \
+	size_t ht_count = (count); \
+	size_t ht_hashes[HT_AGGREGATE_BATCH]; \
+	(success) = true; \
+	for (size_t ht_base = 0; ht_base < ht_count && (success); ht_base += HT_AGGREGATE_BATCH) { \
+		size_t ht_batch = ht_count - ht_base < HT_AGGREGATE_BATCH ? ht_count - ht_base : HT_AGGREGATE_BATCH; \
+		for (size_t ht_i = 0; ht_i < ht_batch; ht_i++) { \
+			ht_hashes[ht_i] = hash_func((key_array)[ht_base + ht_i]); \
+			if ((h).capacity) { \
+				size_t ht_slot = ht_hashes[ht_i] & ((h).capacity - 1); \
+				HT_PREFETCH(&(h).flags[ht_slot]); \
+				HT_PREFETCH(&(h).keys[ht_slot]); \
+				HT_PREFETCH(&(h).values[ht_slot]); \
+			} \
+		} \
+		for (size_t ht_i = 0; ht_i < ht_batch; ht_i++) { \
+			ht_ensure_room((h), key_type, value_type, (success), hash_func); \
+			if (!(success)) { \
+				break; \
+			} \
+			size_t ht_index; \
+			int ht_absent; \
+			ht_put_hashed((h), (key_array)[ht_base + ht_i], ht_hashes[ht_i], ht_index, ht_absent, eq_func); \
+			if (ht_absent) { \
+				(h).values[ht_index] = (value_array)[ht_base + ht_i]; \
+			} else { \
+				(h).values[ht_index] = combine_func((h).values[ht_index], (value_array)[ht_base + ht_i]); \
+			} \
 		} \
-		(h).flags[(index)] = 1; \
-		(h).keys[(index)] = (key); \
-		(h).size++; \
-		(absent) = 1; \
 	} \
 } while (0)
 
+/** Add values from \p delta_array to the elements with keys from \p key_array (see ht_aggregate_combine()). */
+#define ht_aggregate(h, key_type, value_type, key_array, delta_array, count, success, hash_func, eq_func) \
+ht_aggregate_combine((h), key_type, value_type, (key_array), (delta_array), (count), (success), hash_func, eq_func, \
+		ht_combine_add)
+
 /** Delete an element from the hash table by its index. */
 #define ht_delete(h, index) do { \
 	(h).flags[(index)] = 2; \
 	(h).size--; \
 } while (0)
 
+/**
+ * Delete an element from the hash table by its index and shrink the hash table if the number of its elements
+ * fell below the minimum load factor (see ht_maybe_shrink()).
+ *
+ * Unlike ht_delete() this macro can invalidate indices, so it must not be used during iteration.
+ */
+#define ht_delete_shrink(h, key_type, value_type, index, success, hash_func) do { \
+	ht_delete((h), (index)); \
+	ht_maybe_shrink((h), key_type, value_type, (success), hash_func); \
+} while (0)
+
 /** Return first index for iteration over hash table. */
 #define ht_begin(h) (0)
 
@@ -236,11 +808,9 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 /** Access value by hash table element index */
 #define ht_value(h, index) ((h).values[(index)])
 
+/** Find the first valid element index not less than \p index (skips empty and deleted slots in bulk). */
 static inline size_t ht_next_valid_index(const char *flags, size_t capacity, size_t index) {
-	while (index < capacity && flags[index] != 1) {
-		index++;
-	}
-	return index;
+	return bitops_find_byte(flags, capacity, index, 1);
 }
 
 /** For each loop over the hash table using provided \p index variable.
@@ -253,6 +823,143 @@ static inline size_t ht_next_valid_index(const char *flags, size_t capacity, siz
 	index++, index = ht_next_valid_index((h).flags, (h).capacity, index) \
 )
 
+/**
+ * A hash table struct definition with inline storage for up to \p n elements.
+ *
+ * The first \p n elements are stored inside the struct itself and looked up using linear search, so small hash
+ * tables don't allocate any memory. Insertion of more elements moves them into a regular hash table (`table` field),
+ * which is used from then on.
+ */
+#define HT_SMALL(key_type, value_type, n) struct { \
+	HT(key_type, value_type) table; \
+	size_t small_size; \
+	key_type small_keys[(n)]; \
+	value_type small_values[(n)]; \
+}
+
+/** Small hash table initialization. No heap allocation will be performed. */
+#define ht_small_init(h) do { ht_init((h).table); (h).small_size = 0; } while (0)
+
+/** Destroy small hash table. */
+#define ht_small_destroy(h) ht_destroy((h).table)
+
+/** Get number of elements that can be stored inline. */
+#define ht_small_inline_capacity(h) (sizeof((h).small_keys) / sizeof((h).small_keys[0]))
+
+/** Check if elements are stored inline (the hash table is not moved to the heap yet). */
+#define ht_small_is_inline(h) (!(h).table.capacity)
+
+/** Get number of elements stored in the small hash table. */
+#define ht_small_size(h) (ht_small_is_inline(h) ? (h).small_size : ht_size((h).table))
+
+/** Clear small hash table (the heap memory is kept if the hash table was moved to the heap). */
+#define ht_small_clear(h) do { (h).small_size = 0; ht_clear((h).table); } while (0)
+
+/** Verify small hash table element index for validity (needed for ht_small_get() and for iteration) */
+#define ht_small_valid(h, index) (ht_small_is_inline(h) ? (index) < (h).small_size : ht_valid((h).table, (index)))
+
+/** Access key by small hash table element index */
+#define ht_small_key(h, index) (*(ht_small_is_inline(h) ? &(h).small_keys[(index)] : &ht_key((h).table, (index))))
+
+/** Access value by small hash table element index */
+#define ht_small_value(h, index) (*(ht_small_is_inline(h) ? &(h).small_values[(index)] : &ht_value((h).table, (index))))
+
+/**
+ * Perform small hash table lookup and return in \p result index of matched element if any.
+ *
+ * You have to check returned value with ht_small_valid() to determine if the element has been found.
+ */
+#define ht_small_get(h, key, result, hash_func, eq_func) do { \
+	if (ht_small_is_inline(h)) { \
+		for ((result) = 0; (result) < (h).small_size && !eq_func((h).small_keys[(result)], (key)); (result)++); \
+		break; \
+	} \
+	ht_get((h).table, (key), (result), hash_func, eq_func); \
+} while (0)
+
+/**
+ * Insert an element inside the small hash table and return its index (\p absent has the same meaning as for ht_put()).
+ *
+ * When inline storage is full, all elements are moved into the heap hash table. Indices obtained before are invalidated.
+ * In case of memory allocation failure the small hash table remains untouched.
+ */
+#define ht_small_put(h, key_type, value_type, key, index, absent, hash_func, eq_func) do { \
+	if (ht_small_is_inline(h)) { \
+		for ((index) = 0; (index) < (h).small_size && !eq_func((h).small_keys[(index)], (key)); (index)++); \
+		if ((index) < (h).small_size) { \
+			(absent) = 0; \
+			break; \
+		} \
+		if ((h).small_size < ht_small_inline_capacity(h)) { \
+			(h).small_keys[(index)] = (key); \
+			(h).small_size++; \
+			(absent) = 1; \
+			break; \
+		} \
+		bool ht_small_success; \
+		ht_reserve((h).table, key_type, value_type, 2 * ht_small_inline_capacity(h), ht_small_success, hash_func); \
+		if (!ht_small_success) { \
+			(absent) = -1; \
+			break; \
+		} \
+		for (size_t ht_small_i = 0; ht_small_i < (h).small_size; ht_small_i++) { \
+			size_t ht_small_index; \
+			int ht_small_absent; \
+			ht_put_hashed((h).table, (h).small_keys[ht_small_i], hash_func((h).small_keys[ht_small_i]), ht_small_index, ht_small_absent, eq_func); \
+			ht_value((h).table, ht_small_index) = (h).small_values[ht_small_i]; \
+			(void) ht_small_absent; \
+		} \
+		(h).small_size = 0; \
+	} \
+	ht_put((h).table, key_type, value_type, (key), (index), (absent), hash_func, eq_func); \
+} while (0)
+
+/**
+ * Delete an element from the small hash table by its index.
+ *
+ * Inline storage is kept dense: the last element is moved into the freed index, so when deleting during
+ * ht_small_for_each() iteration that element is skipped unless the same index is visited again.
+ */
+#define ht_small_delete(h, index) do { \
+	if (ht_small_is_inline(h)) { \
+		(h).small_size--; \
+		(h).small_keys[(index)] = (h).small_keys[(h).small_size]; \
+		(h).small_values[(index)] = (h).small_values[(h).small_size]; \
+	} else { \
+		ht_delete((h).table, (index)); \
+	} \
+} while (0)
+
+/** Return last index for iteration over small hash table. */
+#define ht_small_end(h) (ht_small_is_inline(h) ? (h).small_size : ht_end((h).table))
+
+/** Find the first valid small hash table element index not less than \p index. */
+#define ht_small_next_valid_index(h, index) \
+(ht_small_is_inline(h) ? (index) : ht_next_valid_index((h).table.flags, (h).table.capacity, (index)))
+
+/** For each loop for the small hash table. */
+#define ht_small_for_each(h, index) for ( \
+	size_t index = ht_small_next_valid_index((h), 0); \
+	index < ht_small_end((h)); \
+	index++, index = ht_small_next_valid_index((h), index) \
+)
+
+/** Lookup implementation for the small hash table with integer keys */
+#define ht_small_get_int(h, key, result) \
+ht_small_get((h), (key), (result), ht_int_hash, ht_int_eq)
+
+/** Insertion implementation for the small hash table with integer keys */
+#define ht_small_put_int(h, value_type, key, index, absent) \
+ht_small_put((h), int, value_type, (key), (index), (absent), ht_int_hash, ht_int_eq)
+
+/** Lookup implementation for the small hash table with string keys */
+#define ht_small_get_str(h, key, result) \
+ht_small_get((h), (key), (result), ht_str_hash, ht_str_eq)
+
+/** Insertion implementation for the small hash table with string keys */
+#define ht_small_put_str(h, value_type, key, index, absent) \
+ht_small_put((h), const char*, value_type, (key), (index), (absent), ht_str_hash, ht_str_eq)
+
 /** Default hash implementation for integers */
 #define ht_int_hash(x) ((size_t) (x))
 
@@ -261,7 +968,7 @@ static inline size_t ht_next_valid_index(const char *flags, size_t capacity, siz
 
 /** Reserve implementation for the hash table with integer keys */
 #define ht_reserve_int(h, value_type, new_capacity, success) \
-ht_reserve((h), int, value_type, (new_capacity), (success), ht_int_hash, ht_int_eq)
+ht_reserve((h), int, value_type, (new_capacity), (success), ht_int_hash)
 
 /** Lookup implementation for the hash table with integer keys */
 #define ht_get_int(h, key, result) \
@@ -271,6 +978,116 @@ ht_get((h), (key), (result), ht_int_hash, ht_int_eq)
 #define ht_put_int(h, value_type, key, index, absent) \
 ht_put((h), int, value_type, (key), (index), (absent), ht_int_hash, ht_int_eq)
 
+/** Bulk insertion implementation for the hash table with integer keys */
+#define ht_build_from_arrays_int(h, value_type, key_array, value_array, count, success) \
+ht_build_from_arrays((h), int, value_type, (key_array), (value_array), (count), (success), ht_int_hash, ht_int_eq)
+
+/** Increment implementation for the hash table with integer keys */
+#define ht_increment_int(h, value_type, key, delta, index, absent) \
+ht_increment((h), int, value_type, (key), (delta), (index), (absent), ht_int_hash, ht_int_eq)
+
+/** Batch aggregation implementation for the hash table with integer keys */
+#define ht_aggregate_int(h, value_type, key_array, delta_array, count, success) \
+ht_aggregate((h), int, value_type, (key_array), (delta_array), (count), (success), ht_int_hash, ht_int_eq)
+
+/** Hash implementation for 32-bit integers (MurmurHash3 finalizer, all bits affect the lower ones) */
+static inline size_t ht_u32_hash(uint32_t x) {
+	x ^= x >> 16;
+	x *= 0x85EBCA6Bu;
+	x ^= x >> 13;
+	x *= 0xC2B2AE35u;
+	x ^= x >> 16;
+	return (size_t) x;
+}
+
+/** Hash implementation for 64-bit integers (SplitMix64 finalizer, all bits affect the lower ones) */
+static inline size_t ht_u64_hash(uint64_t x) {
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ull;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBull;
+	x ^= x >> 31;
+	return (size_t) x;
+}
+
+/** Hash implementation for signed 64-bit integers */
+#define ht_i64_hash(x) ht_u64_hash((uint64_t) (x))
+
+/** Hash implementation for pointers */
+#define ht_ptr_hash(x) ht_u64_hash((uint64_t) (uintptr_t) (x))
+
+/** Reserve implementation for the hash table with 32-bit unsigned integer keys */
+#define ht_reserve_u32(h, value_type, new_capacity, success) \
+ht_reserve((h), uint32_t, value_type, (new_capacity), (success), ht_u32_hash)
+
+/** Lookup implementation for the hash table with 32-bit unsigned integer keys */
+#define ht_get_u32(h, key, result) \
+ht_get((h), (key), (result), ht_u32_hash, ht_int_eq)
+
+/** Insertion implementation for the hash table with 32-bit unsigned integer keys */
+#define ht_put_u32(h, value_type, key, index, absent) \
+ht_put((h), uint32_t, value_type, (key), (index), (absent), ht_u32_hash, ht_int_eq)
+
+/** Bulk insertion implementation for the hash table with 32-bit unsigned integer keys */
+#define ht_build_from_arrays_u32(h, value_type, key_array, value_array, count, success) \
+ht_build_from_arrays((h), uint32_t, value_type, (key_array), (value_array), (count), (success), ht_u32_hash, ht_int_eq)
+
+/** Reserve implementation for the hash table with 64-bit unsigned integer keys */
+#define ht_reserve_u64(h, value_type, new_capacity, success) \
+ht_reserve((h), uint64_t, value_type, (new_capacity), (success), ht_u64_hash)
+
+/** Lookup implementation for the hash table with 64-bit unsigned integer keys */
+#define ht_get_u64(h, key, result) \
+ht_get((h), (key), (result), ht_u64_hash, ht_int_eq)
+
+/** Insertion implementation for the hash table with 64-bit unsigned integer keys */
+#define ht_put_u64(h, value_type, key, index, absent) \
+ht_put((h), uint64_t, value_type, (key), (index), (absent), ht_u64_hash, ht_int_eq)
+
+/** Bulk insertion implementation for the hash table with 64-bit unsigned integer keys */
+#define ht_build_from_arrays_u64(h, value_type, key_array, value_array, count, success) \
+ht_build_from_arrays((h), uint64_t, value_type, (key_array), (value_array), (count), (success), ht_u64_hash, ht_int_eq)
+
+/** Increment implementation for the hash table with 64-bit unsigned integer keys */
+#define ht_increment_u64(h, value_type, key, delta, index, absent) \
+ht_increment((h), uint64_t, value_type, (key), (delta), (index), (absent), ht_u64_hash, ht_int_eq)
+
+/** Batch aggregation implementation for the hash table with 64-bit unsigned integer keys */
+#define ht_aggregate_u64(h, value_type, key_array, delta_array, count, success) \
+ht_aggregate((h), uint64_t, value_type, (key_array), (delta_array), (count), (success), ht_u64_hash, ht_int_eq)
+
+/** Reserve implementation for the hash table with 64-bit signed integer keys */
+#define ht_reserve_i64(h, value_type, new_capacity, success) \
+ht_reserve((h), int64_t, value_type, (new_capacity), (success), ht_i64_hash)
+
+/** Lookup implementation for the hash table with 64-bit signed integer keys */
+#define ht_get_i64(h, key, result) \
+ht_get((h), (key), (result), ht_i64_hash, ht_int_eq)
+
+/** Insertion implementation for the hash table with 64-bit signed integer keys */
+#define ht_put_i64(h, value_type, key, index, absent) \
+ht_put((h), int64_t, value_type, (key), (index), (absent), ht_i64_hash, ht_int_eq)
+
+/** Bulk insertion implementation for the hash table with 64-bit signed integer keys */
+#define ht_build_from_arrays_i64(h, value_type, key_array, value_array, count, success) \
+ht_build_from_arrays((h), int64_t, value_type, (key_array), (value_array), (count), (success), ht_i64_hash, ht_int_eq)
+
+/** Reserve implementation for the hash table with pointer keys (`HT(const void*, value_type)`) */
+#define ht_reserve_ptr(h, value_type, new_capacity, success) \
+ht_reserve((h), const void*, value_type, (new_capacity), (success), ht_ptr_hash)
+
+/** Lookup implementation for the hash table with pointer keys (`HT(const void*, value_type)`) */
+#define ht_get_ptr(h, key, result) \
+ht_get((h), (key), (result), ht_ptr_hash, ht_int_eq)
+
+/** Insertion implementation for the hash table with pointer keys (`HT(const void*, value_type)`) */
+#define ht_put_ptr(h, value_type, key, index, absent) \
+ht_put((h), const void*, value_type, (key), (index), (absent), ht_ptr_hash, ht_int_eq)
+
+/** Bulk insertion implementation for the hash table with pointer keys (`HT(const void*, value_type)`) */
+#define ht_build_from_arrays_ptr(h, value_type, key_array, value_array, count, success) \
+ht_build_from_arrays((h), const void*, value_type, (key_array), (value_array), (count), (success), ht_ptr_hash, ht_int_eq)
+
 /** Default hash implementation for strings */
 static inline size_t ht_str_hash(const char *s) {
 	size_t h = (size_t) *s;
@@ -285,18 +1102,71 @@ static inline size_t ht_str_hash(const char *s) {
 /** Default equality implementation for strings */
 #define ht_str_eq(a, b) (strcmp((a), (b)) == 0)
 
+/** Character array key for ht_get_strn(). Normally shouldn't be used directly from user code. */
+typedef struct ht_strn {
+	const char *ptr;
+	size_t len;
+} ht_strn_t;
+
+/**
+ * Hash implementation for character arrays.
+ *
+ * Gives the same result as ht_str_hash() for strings without NULL characters inside.
+ */
+static inline size_t ht_strn_hash(const char *s, size_t len) {
+	size_t h = 0;
+	for (size_t i = 0; i < len; i++) {
+		h = (h << 5) - h + (size_t) s[i];
+	}
+	return h;
+}
+
+/** Equality implementation for a NULL-terminated string \p a and a character array \p b of \p len characters */
+static inline bool ht_strn_eq(const char *a, const char *b, size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		if (a[i] != b[i] || !a[i]) {
+			return false;
+		}
+	}
+	return a[len] == '\0';
+}
+
+/** Equality implementation for a stored string key and ht_strn_t */
+#define ht_strn_key_eq(a, b) ht_strn_eq((a), (b).ptr, (b).len)
+
 /** Reserve implementation for the hash table with string keys */
 #define ht_reserve_str(h, value_type, new_capacity, success) \
-ht_reserve((h), const char*, value_type, (new_capacity), (success), ht_str_hash, ht_str_eq)
+ht_reserve((h), const char*, value_type, (new_capacity), (success), ht_str_hash)
 
 /** Lookup implementation for the hash table with string keys */
 #define ht_get_str(h, key, result) \
 ht_get((h), (key), (result), ht_str_hash, ht_str_eq)
 
+/**
+ * Lookup implementation for the hash table with string keys using a character array \p chars of \p chars_size characters
+ * (it doesn't have to be NULL-terminated, e.g. it can be a part of a larger buffer).
+ */
+#define ht_get_strn(h, chars, chars_size, result) do { \
+	ht_strn_t ht_strn_key = { (chars), (chars_size) }; \
+	ht_get_hashed((h), ht_strn_key, ht_strn_hash(ht_strn_key.ptr, ht_strn_key.len), (result), ht_strn_key_eq); \
+} while (0)
+
 /** Insertion implementation for the hash table with string keys */
 #define ht_put_str(h, value_type, key, index, absent) \
 ht_put((h), const char*, value_type, (key), (index), (absent), ht_str_hash, ht_str_eq)
 
+/** Bulk insertion implementation for the hash table with string keys */
+#define ht_build_from_arrays_str(h, value_type, key_array, value_array, count, success) \
+ht_build_from_arrays((h), const char*, value_type, (key_array), (value_array), (count), (success), ht_str_hash, ht_str_eq)
+
+/** Increment implementation for the hash table with string keys */
+#define ht_increment_str(h, value_type, key, delta, index, absent) \
+ht_increment((h), const char*, value_type, (key), (delta), (index), (absent), ht_str_hash, ht_str_eq)
+
+/** Batch aggregation implementation for the hash table with string keys */
+#define ht_aggregate_str(h, value_type, key_array, delta_array, count, success) \
+ht_aggregate((h), const char*, value_type, (key_array), (delta_array), (count), (success), ht_str_hash, ht_str_eq)
+
 /** Combine two hash values to get a new one. Useful for writing composite key hash functions */
 static inline size_t ht_hash_combine(size_t a, size_t b) {
 	return a ^ (b + 0x9E3779B9 + (a << 6) + (a >> 2));
@@ -0,0 +1,332 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+/**
+ * @file
+ * @brief Generic hash set of integers (or pointers) with linear probing and a reserved empty key.
+ * @details
+ * One key value (passed to intset_init()) is reserved to mark empty slots, so unlike HS the set doesn't
+ * need a separate flags array and every probe touches a single memory location. Deletion shifts following elements
+ * back instead of leaving tombstones, so the set never needs rehashing because of deleted elements.
+ * The reserved key itself can't be stored in the set.
+ *
+ * Example of usage:
+ * \code
+ * INTSET(uint64_t) s; size_t index; int absent;
+ * intset_init(s, UINT64_MAX);
+ *
+ * intset_put_u64(s, 10, index, absent);
+ * intset_put_u64(s, 20, index, absent);
+ *
+ * intset_for_each(s, i) {
+ *     printf("%llu\n", (unsigned long long) intset_key(s, i));
+ * }
+ *
+ * intset_get_u64(s, 20, index);
+ * if (intset_valid(s, index)) {
+ *     intset_delete_u64(s, index);
+ * }
+ *
+ * intset_destroy(s);
+ * \endcode
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "roundup.h"
+
+/** An integer hash set struct definition */
+#define INTSET(key_type) struct { \
+	size_t size, max_used, capacity; \
+	key_type empty_key; \
+	key_type *keys; \
+}
+
+/** Initialize a empty integer hash set using \p empty as the reserved key (no memory allocation performed). */
+#define intset_init(s, empty) do { \
+	(s).size = (s).max_used = (s).capacity = 0; \
+	(s).empty_key = (empty); \
+	(s).keys = NULL; \
+} while (0)
+
+/** Destroy an integer hash set. */
+#define intset_destroy(s) do { free((s).keys); } while (0)
+
+/** Get number of elements stored in the integer hash set. */
+#define intset_size(s) ((s).size)
+
+/** Get maximum number of elements that can be stored in the integer hash set before rehashing. */
+#define intset_max_used(s) ((s).max_used)
+
+/** Get total integer hash set size. */
+#define intset_capacity(s) ((s).capacity)
+
+/** Get the reserved key of the integer hash set. */
+#define intset_empty_key(s) ((s).empty_key)
+
+/** Clear integer hash set */
+#define intset_clear(s) do { \
+	for (size_t intset_i = 0; intset_i < (s).capacity; intset_i++) { \
+		(s).keys[intset_i] = (s).empty_key; \
+	} \
+	(s).size = 0; \
+} while (0)
+
+/**
+ * Rebuild integer hash set with exactly \p new_capacity slots (must be a power of 2 able to hold all elements).
+ * Success will be assigned to false in case of memory allocation failure.
+ */
+#define intset_rehash(s, key_type, new_capacity, success, hash_func) do { \
+	size_t intset_rehash_capacity = (new_capacity); \
+	key_type *intset_new_keys = malloc(intset_rehash_capacity * sizeof(key_type)); \
+	if (!intset_new_keys) { \
+		(success) = false; \
+		break; \
+	} \
+	for (size_t intset_i = 0; intset_i < intset_rehash_capacity; intset_i++) { \
+		intset_new_keys[intset_i] = (s).empty_key; \
+	} \
+	size_t intset_mask = intset_rehash_capacity - 1; \
+	for (size_t intset_i = 0; intset_i < (s).capacity; intset_i++) { \
+		if ((s).keys[intset_i] == (s).empty_key) continue; \
+		size_t intset_j = hash_func((s).keys[intset_i]) & intset_mask; \
+		while (intset_new_keys[intset_j] != (s).empty_key) { \
+			intset_j = (intset_j + 1) & intset_mask; \
+		} \
+		intset_new_keys[intset_j] = (s).keys[intset_i]; \
+	} \
+	free((s).keys); \
+	(s).keys = intset_new_keys; \
+	(s).capacity = intset_rehash_capacity; \
+	(s).max_used = (intset_rehash_capacity >> 1) + (intset_rehash_capacity >> 2); \
+	(success) = true; \
+} while (0)
+
+/**
+ * Resize integer hash set to be able to hold at least new_capacity elements.
+ * Success will be assigned to false in case of memory allocation failure.
+ */
+#define intset_reserve(s, key_type, new_capacity, success, hash_func) do { \
+	if ((new_capacity) <= (s).max_used) { \
+		(success) = true; \
+		break; \
+	} \
+	size_t intset_reserve_capacity = (new_capacity); \
+	roundupsize(intset_reserve_capacity); \
+	if (intset_reserve_capacity < (new_capacity)) { /* Integer overflow */ \
+		(success) = false; \
+		break; \
+	} \
+	if ((intset_reserve_capacity >> 1) + (intset_reserve_capacity >> 2) < (new_capacity)) { \
+		if (intset_reserve_capacity > SIZE_MAX / 2 / sizeof(key_type)) { /* Integer overflow */ \
+			(success) = false; \
+			break; \
+		} \
+		intset_reserve_capacity <<= 1; \
+	} \
+	intset_rehash((s), key_type, intset_reserve_capacity, (success), hash_func); \
+} while (0)
+
+/**
+ * Perform integer hash set lookup and return in \p result index of matched element if any.
+ *
+ * You have to check returned value with intset_valid() to determine if the element has been found.
+ */
+#define intset_get(s, key, result, hash_func) do { \
+	if (!(s).size) { \
+		(result) = 0; \
+		break; \
+	} \
+	size_t intset_mask = (s).capacity - 1; \
+	(result) = hash_func(key) & intset_mask; \
+	while ((s).keys[(result)] != (key) && (s).keys[(result)] != (s).empty_key) { \
+		(result) = ((result) + 1) & intset_mask; \
+	} \
+} while (0)
+
+/**
+ * Insert an element inside the integer hash set and return its index.
+ *
+ * \p absent specifies the operation result. 1 means that the element was successfully inserted.
+ * 0 means that the element was already existed in the integer hash set (and its index was returned),
+ * -1 means that memory allocation failure happened or \p key is the reserved key
+ * (\p index won't be assigned and shouldn't be used even with intset_valid()).
+ */
+#define intset_put(s, key_type, key, index, absent, hash_func) do { \
+	if ((key) == (s).empty_key) { \
+		(absent) = -1; \
+		break; \
+	} \
+	if ((s).size >= (s).max_used) { \
+		bool intset_success; \
+		intset_reserve((s), key_type, (s).size ? (s).size + 1 : 2, intset_success, hash_func); \
+		if (!intset_success) { \
+			(absent) = -1; \
+			break; \
+		} \
+	} \
+	size_t intset_mask = (s).capacity - 1; \
+	(index) = hash_func(key) & intset_mask; \
+	while ((s).keys[(index)] != (key) && (s).keys[(index)] != (s).empty_key) { \
+		(index) = ((index) + 1) & intset_mask; \
+	} \
+	if ((s).keys[(index)] == (key)) { \
+		(absent) = 0; \
+	} else { \
+		(s).keys[(index)] = (key); \
+		(s).size++; \
+		(absent) = 1; \
+	} \
+} while (0)
+
+/**
+ * Delete an element from the integer hash set by its index.
+ *
+ * Following elements of the probe sequence are moved back to fill the hole, so unlike hs_delete()
+ * this macro can't be used during iteration.
+ */
+#define intset_delete(s, index, hash_func) do { \
+	size_t intset_mask = (s).capacity - 1; \
+	size_t intset_hole = (index); \
+	size_t intset_j = intset_hole; \
+	for (;;) { \
+		intset_j = (intset_j + 1) & intset_mask; \
+		if ((s).keys[intset_j] == (s).empty_key) break; \
+		size_t intset_home = hash_func((s).keys[intset_j]) & intset_mask; \
+		/* Leave the element if its home slot lies cyclically in (hole, j] */ \
+		if (intset_hole <= intset_j ? \
+				(intset_hole < intset_home && intset_home <= intset_j) : \
+				(intset_hole < intset_home || intset_home <= intset_j)) { \
+			continue; \
+		} \
+		(s).keys[intset_hole] = (s).keys[intset_j]; \
+		intset_hole = intset_j; \
+	} \
+	(s).keys[intset_hole] = (s).empty_key; \
+	(s).size--; \
+} while (0)
+
+/** Return first index for iteration over integer hash set. */
+#define intset_begin(s) (0)
+
+/** Return last index for iteration over integer hash set. */
+#define intset_end(s) ((s).capacity)
+
+/** Verify integer hash set element index for validity (needed for intset_get() and for iteration) */
+#define intset_valid(s, index) ((s).keys && (s).keys[(index)] != (s).empty_key)
+
+/** Access key by integer hash set element index */
+#define intset_key(s, index) ((s).keys[(index)])
+
+/** For each loop over the integer hash set using provided \p index variable.
+ *
+ * You don't need to check index validity before access keys when using this macro. */
+#define intset_for_each(s, index) \
+	for (size_t index = intset_begin((s)); index < intset_end((s)); index++) \
+		if (!intset_valid((s), index)) {} else
+
+/** Hash implementation for 32-bit integers (MurmurHash3 finalizer, all bits affect the lower ones) */
+static inline size_t intset_u32_hash(uint32_t x) {
+	x ^= x >> 16;
+	x *= 0x85EBCA6Bu;
+	x ^= x >> 13;
+	x *= 0xC2B2AE35u;
+	x ^= x >> 16;
+	return (size_t) x;
+}
+
+/** Hash implementation for 64-bit integers (SplitMix64 finalizer, all bits affect the lower ones) */
+static inline size_t intset_u64_hash(uint64_t x) {
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ull;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBull;
+	x ^= x >> 31;
+	return (size_t) x;
+}
+
+/** Hash implementation for signed 64-bit integers */
+#define intset_i64_hash(x) intset_u64_hash((uint64_t) (x))
+
+/** Hash implementation for pointers */
+#define intset_ptr_hash(x) intset_u64_hash((uint64_t) (uintptr_t) (x))
+
+/** Reserve implementation for the integer hash set with 32-bit unsigned integer keys */
+#define intset_reserve_u32(s, new_capacity, success) \
+intset_reserve((s), uint32_t, (new_capacity), (success), intset_u32_hash)
+
+/** Lookup implementation for the integer hash set with 32-bit unsigned integer keys */
+#define intset_get_u32(s, key, result) \
+intset_get((s), (key), (result), intset_u32_hash)
+
+/** Insertion implementation for the integer hash set with 32-bit unsigned integer keys */
+#define intset_put_u32(s, key, index, absent) \
+intset_put((s), uint32_t, (key), (index), (absent), intset_u32_hash)
+
+/** Deletion implementation for the integer hash set with 32-bit unsigned integer keys */
+#define intset_delete_u32(s, index) \
+intset_delete((s), (index), intset_u32_hash)
+
+/** Reserve implementation for the integer hash set with 64-bit unsigned integer keys */
+#define intset_reserve_u64(s, new_capacity, success) \
+intset_reserve((s), uint64_t, (new_capacity), (success), intset_u64_hash)
+
+/** Lookup implementation for the integer hash set with 64-bit unsigned integer keys */
+#define intset_get_u64(s, key, result) \
+intset_get((s), (key), (result), intset_u64_hash)
+
+/** Insertion implementation for the integer hash set with 64-bit unsigned integer keys */
+#define intset_put_u64(s, key, index, absent) \
+intset_put((s), uint64_t, (key), (index), (absent), intset_u64_hash)
+
+/** Deletion implementation for the integer hash set with 64-bit unsigned integer keys */
+#define intset_delete_u64(s, index) \
+intset_delete((s), (index), intset_u64_hash)
+
+/** Reserve implementation for the integer hash set with 64-bit signed integer keys */
+#define intset_reserve_i64(s, new_capacity, success) \
+intset_reserve((s), int64_t, (new_capacity), (success), intset_i64_hash)
+
+/** Lookup implementation for the integer hash set with 64-bit signed integer keys */
+#define intset_get_i64(s, key, result) \
+intset_get((s), (key), (result), intset_i64_hash)
+
+/** Insertion implementation for the integer hash set with 64-bit signed integer keys */
+#define intset_put_i64(s, key, index, absent) \
+intset_put((s), int64_t, (key), (index), (absent), intset_i64_hash)
+
+/** Deletion implementation for the integer hash set with 64-bit signed integer keys */
+#define intset_delete_i64(s, index) \
+intset_delete((s), (index), intset_i64_hash)
+
+/** Reserve implementation for the integer hash set with pointer keys (`INTSET(const void*)`) */
+#define intset_reserve_ptr(s, new_capacity, success) \
+intset_reserve((s), const void*, (new_capacity), (success), intset_ptr_hash)
+
+/** Lookup implementation for the integer hash set with pointer keys (`INTSET(const void*)`) */
+#define intset_get_ptr(s, key, result) \
+intset_get((s), (key), (result), intset_ptr_hash)
+
+/** Insertion implementation for the integer hash set with pointer keys (`INTSET(const void*)`) */
+#define intset_put_ptr(s, key, index, absent) \
+intset_put((s), const void*, (key), (index), (absent), intset_ptr_hash)
+
+/** Deletion implementation for the integer hash set with pointer keys (`INTSET(const void*)`) */
+#define intset_delete_ptr(s, index) \
+intset_delete((s), (index), intset_ptr_hash)
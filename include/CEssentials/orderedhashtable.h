@@ -0,0 +1,488 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+/**
+ * @file
+ * @brief Generic insertion-ordered hash table with quadratic probing.
+ * @details
+ * Elements are stored densely in insertion order in separate key and value arrays,
+ * the open addressing slots only hold small integer indices of elements
+ * (1, 2, 4 or 8 bytes wide depending on the hash table size). So iteration visits elements in insertion order
+ * touching memory sequentially and its cost depends on number of inserted elements rather than the hash table
+ * capacity. Keys and values arrays hold only as many elements as the hash table can have before rehashing.
+ *
+ * Deleted elements leave holes in the arrays until the next rehash, when the arrays are compacted
+ * (the insertion order is preserved).
+ *
+ * Example of usage:
+ * \code
+ * OHT(const char*, int) ht; size_t index; int absent;
+ * oht_init(ht);
+ *
+ * oht_put_str(ht, int, "20", index, absent);
+ * oht_value(ht, index) = 20;
+ *
+ * oht_put_str(ht, int, "10", index, absent);
+ * oht_value(ht, index) = 10;
+ *
+ * oht_for_each(ht, i) { // Prints 20=20 and then 10=10
+ *     printf("%s=%i\n", oht_key(ht, i), oht_value(ht, i));
+ * }
+ *
+ * oht_get_str(ht, "20", index);
+ * if (oht_valid(ht, index)) {
+ *     printf("%i\n", oht_value(ht, index));
+ *     oht_delete(ht, index);
+ * } else {
+ *     printf("Not found\n");
+ * }
+ *
+ * oht_destroy(ht);
+ * \endcode
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "roundup.h"
+#include "bitops.h"
+
+/** Default maximum load factor of an ordered hash table */
+#define OHT_DEFAULT_MAX_LOAD 0.75f
+
+/** An ordered hash table struct definition */
+#define OHT(key_type, value_type) struct { \
+	size_t size, count, used, max_used, capacity; \
+	float max_load; \
+	unsigned int index_width; \
+	void *indices; \
+	char *flags; \
+	key_type *keys; \
+	value_type *values; \
+}
+
+/** Initialize a empty ordered hash table (no memory allocation performed). */
+#define oht_init(h) do { \
+	(h).size = (h).count = (h).used = (h).max_used = (h).capacity = 0; \
+	(h).max_load = OHT_DEFAULT_MAX_LOAD; \
+	(h).index_width = 1; \
+	(h).indices = NULL; \
+	(h).flags = NULL; \
+	(h).keys = NULL; \
+	(h).values = NULL; \
+} while (0)
+
+/**
+ * Destroy an ordered hash table.
+ *
+ * You might need manually destroy keys and values if they are complex (e.g. nested heap allocated pointers).
+ */
+#define oht_destroy(h) do { free((h).values); free((h).keys); free((h).flags); free((h).indices); } while (0)
+
+/** Get number of elements stored in the ordered hash table. */
+#define oht_size(h) ((h).size)
+
+/** Get number of elements appended to the ordered hash table since last rehash (inserted + deleted). */
+#define oht_count(h) ((h).count)
+
+/** Get number of slots that are occupied in the ordered hash table. */
+#define oht_used(h) ((h).used)
+
+/** Get maximum number of elements that can be appended to the ordered hash table before rehashing. */
+#define oht_max_used(h) ((h).max_used)
+
+/** Get total number of slots of the ordered hash table. */
+#define oht_capacity(h) ((h).capacity)
+
+/**
+ * Set load factors of the ordered hash table (same signature as ht_set_load_factor() and hs_set_load_factor()).
+ *
+ * \p max_load must be in (0, 1) range and takes effect on the next rehash. Ordered hash tables are never shrunk
+ * automatically (deleted elements keep their slots until the next rehash), so \p min_load is ignored.
+ */
+#define oht_set_load_factor(h, new_max_load, new_min_load) do { \
+	(h).max_load = (new_max_load); \
+	(void) (new_min_load); \
+} while (0)
+
+/** Compute how many slots of an ordered hash table with \p capacity can be occupied with given \p max_load. */
+static inline size_t oht_max_used_for(size_t capacity, float max_load) {
+	size_t limit = (size_t) ((double) capacity * max_load);
+	if (limit >= capacity) {
+		limit = capacity - 1; // At least one slot must be empty to stop probing
+	}
+	if (!limit && capacity > 1) {
+		limit = 1;
+	}
+	return limit;
+}
+
+/**
+ * Compute minimal ordered hash table capacity (a power of 2) able to hold \p count elements with given \p max_load.
+ * Returns 0 in case of integer overflow.
+ */
+static inline size_t oht_capacity_for(size_t count, float max_load) {
+	size_t capacity = count;
+	roundupsize(capacity);
+	if (capacity < count) { // Integer overflow
+		return 0;
+	}
+	while (oht_max_used_for(capacity, max_load) < count) {
+		if (capacity > SIZE_MAX / 2) { // Integer overflow
+			return 0;
+		}
+		capacity <<= 1;
+	}
+	return capacity;
+}
+
+/** Get width of a slot (in bytes) enough to store indices of \p max_used elements. */
+static inline unsigned int oht_index_width(size_t max_used) {
+	if (max_used < UINT8_MAX) {
+		return 1;
+	} else if (max_used < UINT16_MAX) {
+		return 2;
+	} else if (max_used < UINT32_MAX) {
+		return 4;
+	} else {
+		return 8;
+	}
+}
+
+/**
+ * Read a slot of an ordered hash table. Returns 0 for an empty slot or an element index plus 1.
+ * Normally shouldn't be used directly from user code.
+ */
+static inline size_t oht_index_get(const void *indices, unsigned int width, size_t slot) {
+	switch (width) {
+		case 1:
+			return ((const uint8_t*) indices)[slot];
+		case 2:
+			return ((const uint16_t*) indices)[slot];
+		case 4:
+			return ((const uint32_t*) indices)[slot];
+		default:
+			return (size_t) ((const uint64_t*) indices)[slot];
+	}
+}
+
+/** Write a slot of an ordered hash table. Normally shouldn't be used directly from user code. */
+static inline void oht_index_set(void *indices, unsigned int width, size_t slot, size_t value) {
+	switch (width) {
+		case 1:
+			((uint8_t*) indices)[slot] = (uint8_t) value;
+			break;
+		case 2:
+			((uint16_t*) indices)[slot] = (uint16_t) value;
+			break;
+		case 4:
+			((uint32_t*) indices)[slot] = (uint32_t) value;
+			break;
+		default:
+			((uint64_t*) indices)[slot] = (uint64_t) value;
+			break;
+	}
+}
+
+/** Clear ordered hash table */
+#define oht_clear(h) do { \
+	(h).size = (h).count = (h).used = 0; \
+	if ((h).indices) { \
+		memset((h).indices, 0, (h).capacity * (h).index_width); \
+	} \
+} while (0)
+
+#if defined(__GNUC__)
+/**
+ * Hide the origin of a freshly allocated array from the optimizer (no code is emitted), so GCC doesn't report
+ * entries read right after an inlined oht_rehash() as maybe uninitialized.
+ */
+#define OHT_LAUNDER(ptr) __asm__("" : "+r"(ptr) : : "memory")
+#else
+#define OHT_LAUNDER(ptr) ((void) 0)
+#endif
+
+/**
+ * Rebuild ordered hash table with exactly \p new_capacity slots (must be a power of 2 able to hold all elements).
+ * Deleted elements are dropped, the order of remaining ones is preserved.
+ * Success will be assigned to false in case of memory allocation failure.
+ */
+#define oht_rehash(h, key_type, value_type, new_capacity, success, hash_func) do { \
+	size_t oht_rehash_capacity = (new_capacity); \
+	size_t oht_new_max_used = oht_max_used_for(oht_rehash_capacity, (h).max_load); \
+	unsigned int oht_new_width = oht_index_width(oht_new_max_used); \
+	void *oht_new_indices = calloc(oht_rehash_capacity, oht_new_width); \
+	if (!oht_new_indices) { \
+		(success) = false; \
+		break; \
+	} \
+	char *oht_new_flags = malloc(oht_new_max_used); \
+	if (!oht_new_flags) { \
+		free(oht_new_indices); \
+		(success) = false; \
+		break; \
+	} \
+	key_type *oht_new_keys = malloc(oht_new_max_used * sizeof(key_type)); \
+	if (!oht_new_keys) { \
+		free(oht_new_flags); \
+		free(oht_new_indices); \
+		(success) = false; \
+		break; \
+	} \
+	value_type *oht_new_values = malloc(oht_new_max_used * sizeof(value_type)); \
+	if (!oht_new_values) { \
+		free(oht_new_keys); \
+		free(oht_new_flags); \
+		free(oht_new_indices); \
+		(success) = false; \
+		break; \
+	} \
+	size_t oht_mask = oht_rehash_capacity - 1; \
+	size_t oht_new_count = 0; \
+	for (size_t oht_i = 0; oht_i < (h).count; oht_i++) { \
+		if ((h).flags[oht_i] != 1) continue; \
+		size_t oht_j = hash_func((h).keys[oht_i]) & oht_mask; \
+		size_t oht_step = 0; \
+		while (oht_index_get(oht_new_indices, oht_new_width, oht_j)) { \
+			oht_j = (oht_j + ++oht_step) & oht_mask; \
+		} \
+		oht_index_set(oht_new_indices, oht_new_width, oht_j, oht_new_count + 1); \
+		oht_new_flags[oht_new_count] = 1; \
+		oht_new_keys[oht_new_count] = (h).keys[oht_i]; \
+		oht_new_values[oht_new_count] = (h).values[oht_i]; \
+		oht_new_count++; \
+	} \
+	free((h).values); \
+	free((h).keys); \
+	free((h).flags); \
+	free((h).indices); \
+	OHT_LAUNDER(oht_new_indices); \
+	OHT_LAUNDER(oht_new_flags); \
+	OHT_LAUNDER(oht_new_keys); \
+	OHT_LAUNDER(oht_new_values); \
+	(h).indices = oht_new_indices; \
+	(h).flags = oht_new_flags; \
+	(h).keys = oht_new_keys; \
+	(h).values = oht_new_values; \
+	(h).index_width = oht_new_width; \
+	(h).capacity = oht_rehash_capacity; \
+	(h).size = (h).count = (h).used = oht_new_count; \
+	(h).max_used = oht_new_max_used; \
+	(success) = true; \
+} while (0)
+
+/**
+ * Resize ordered hash table to be able to hold at least new_capacity elements.
+ * Success will be assigned to false in case of memory allocation failure.
+ */
+#define oht_reserve(h, key_type, value_type, new_capacity, success, hash_func) do { \
+	if ((new_capacity) <= (h).max_used) { \
+		(success) = true; \
+		break; \
+	} \
+	size_t oht_reserve_capacity = oht_capacity_for((new_capacity), (h).max_load); \
+	if (!oht_reserve_capacity) { /* Integer overflow */ \
+		(success) = false; \
+		break; \
+	} \
+	oht_rehash((h), key_type, value_type, oht_reserve_capacity, (success), hash_func); \
+} while (0)
+
+/**
+ * Perform ordered hash table lookup and return in \p result index of matched element if any.
+ *
+ * You have to check returned value with oht_valid() to determine if the element has been found.
+ * Then you can use oht_key() and oht_value() to access it.
+ */
+#define oht_get(h, key, result, hash_func, eq_func) do { \
+	(result) = (h).count; \
+	if (!(h).size) { \
+		break; \
+	} \
+	size_t oht_mask = (h).capacity - 1; \
+	size_t oht_slot = hash_func(key) & oht_mask; \
+	size_t oht_step = 0; \
+	size_t oht_entry; \
+	while ((oht_entry = oht_index_get((h).indices, (h).index_width, oht_slot)) != 0) { \
+		oht_entry--; \
+		if ((h).flags[oht_entry] == 1 && eq_func((h).keys[oht_entry], (key))) { \
+			(result) = oht_entry; \
+			break; \
+		} \
+		oht_slot = (oht_slot + ++oht_step) & oht_mask; \
+	} \
+} while (0)
+
+/**
+ * Insert an element with precomputed \p hash at the end of the ordered hash table and return its index.
+ *
+ * Unlike oht_put() this macro doesn't grow the ordered hash table, so the caller must ensure that there is a room
+ * for one more element (`oht_count(h) < oht_max_used(h)`). \p absent has the same meaning as for oht_put()
+ * except that -1 is never returned.
+ */
+#define oht_put_hashed(h, key, hash, index, absent, eq_func) do { \
+	size_t oht_mask = (h).capacity - 1; \
+	size_t oht_slot = (hash) & oht_mask; \
+	size_t oht_step = 0; \
+	size_t oht_deleted = (h).capacity; \
+	size_t oht_entry; \
+	(absent) = 1; \
+	while ((oht_entry = oht_index_get((h).indices, (h).index_width, oht_slot)) != 0) { \
+		oht_entry--; \
+		if ((h).flags[oht_entry] == 1) { \
+			if (eq_func((h).keys[oht_entry], (key))) { \
+				(index) = oht_entry; \
+				(absent) = 0; \
+				break; \
+			} \
+		} else if (oht_deleted == (h).capacity) { \
+			oht_deleted = oht_slot; \
+		} \
+		oht_slot = (oht_slot + ++oht_step) & oht_mask; \
+	} \
+	if (absent) { \
+		if (oht_deleted != (h).capacity) { \
+			oht_slot = oht_deleted; \
+		} else { \
+			(h).used++; \
+		} \
+		(index) = (h).count++; \
+		oht_index_set((h).indices, (h).index_width, oht_slot, (index) + 1); \
+		(h).flags[(index)] = 1; \
+		(h).keys[(index)] = (key); \
+		(h).size++; \
+	} \
+} while (0)
+
+/**
+ * Insert an element at the end of the ordered hash table and return its index.
+ *
+ * \p absent specifies the operation result. 1 means that the element was successfully inserted.
+ * 0 means that the element with given key was already existed in the ordered hash table (and its index was returned,
+ * the element keeps its position), -1 means that memory allocation failure happened (\p index won't be assigned
+ * and shouldn't be used even with oht_valid()).
+ *
+ * Insertion can trigger rehash, which invalidates indices of all elements.
+ */
+#define oht_put(h, key_type, value_type, key, index, absent, hash_func, eq_func) do { \
+	if ((h).count >= (h).max_used) { \
+		bool oht_success; \
+		size_t oht_new_capacity = (h).capacity; \
+		if ((h).size >= (h).max_used / 2) { /* Otherwise just drop deleted elements */ \
+			oht_new_capacity = oht_capacity_for((h).size ? (h).size + 1 : 2, (h).max_load); \
+			if (oht_new_capacity <= (h).capacity) { \
+				oht_new_capacity = (h).capacity <= SIZE_MAX / 2 ? (h).capacity << 1 : 0; \
+			} \
+			if (!oht_new_capacity) { /* Integer overflow */ \
+				(absent) = -1; \
+				break; \
+			} \
+		} \
+		oht_rehash((h), key_type, value_type, oht_new_capacity, oht_success, hash_func); \
+		if (!oht_success) { \
+			(absent) = -1; \
+			break; \
+		} \
+	} \
+	oht_put_hashed((h), (key), hash_func(key), (index), (absent), eq_func); \
+} while (0)
+
+/**
+ * Delete an element from the ordered hash table by its index.
+ *
+ * Indices of other elements remain valid, the memory is reclaimed on the next rehash.
+ */
+#define oht_delete(h, index) do { \
+	(h).flags[(index)] = 2; \
+	(h).size--; \
+} while (0)
+
+/** Return first index for iteration over ordered hash table. */
+#define oht_begin(h) (0)
+
+/** Return last index for iteration over ordered hash table. */
+#define oht_end(h) ((h).count)
+
+/** Verify ordered hash table element index for validity (needed for oht_get() and for iteration) */
+#define oht_valid(h, index) ((index) < (h).count && (h).flags[(index)] == 1)
+
+/** Access key by ordered hash table element index */
+#define oht_key(h, index) ((h).keys[(index)])
+
+/** Access value by ordered hash table element index */
+#define oht_value(h, index) ((h).values[(index)])
+
+/** Find the first valid element index not less than \p index (skips empty and deleted slots in bulk). */
+static inline size_t oht_next_valid_index(const char *flags, size_t count, size_t index) {
+	return bitops_find_byte(flags, count, index, 1);
+}
+
+/** For each loop over the ordered hash table in insertion order using provided \p index variable.
+ *
+ * You don't need to check index validity before access keys and values when using this macro.
+ * You can safely call oht_delete() on provided index and either continue or break iteration. */
+#define oht_for_each(h, index) for ( \
+	size_t index = oht_next_valid_index((h).flags, (h).count, oht_begin((h))); \
+	index < oht_end((h)); \
+	index = oht_next_valid_index((h).flags, (h).count, index + 1) \
+)
+
+/** Default hash implementation for integers */
+#define oht_int_hash(x) ((size_t) (x))
+
+/** Default equality implementation for integers */
+#define oht_int_eq(a, b) ((a) == (b))
+
+/** Reserve implementation for the ordered hash table with integer keys */
+#define oht_reserve_int(h, value_type, new_capacity, success) \
+oht_reserve((h), int, value_type, (new_capacity), (success), oht_int_hash)
+
+/** Lookup implementation for the ordered hash table with integer keys */
+#define oht_get_int(h, key, result) \
+oht_get((h), (key), (result), oht_int_hash, oht_int_eq)
+
+/** Insertion implementation for the ordered hash table with integer keys */
+#define oht_put_int(h, value_type, key, index, absent) \
+oht_put((h), int, value_type, (key), (index), (absent), oht_int_hash, oht_int_eq)
+
+/** Default hash implementation for strings */
+static inline size_t oht_str_hash(const char *s) {
+	size_t h = (size_t) *s;
+	if (h) {
+		for(++s; *s; ++s) {
+			h = (h << 5) - h + (size_t) *s;
+		}
+	}
+	return h;
+}
+
+/** Default equality implementation for strings */
+#define oht_str_eq(a, b) (strcmp((a), (b)) == 0)
+
+/** Reserve implementation for the ordered hash table with string keys */
+#define oht_reserve_str(h, value_type, new_capacity, success) \
+oht_reserve((h), const char*, value_type, (new_capacity), (success), oht_str_hash)
+
+/** Lookup implementation for the ordered hash table with string keys */
+#define oht_get_str(h, key, result) \
+oht_get((h), (key), (result), oht_str_hash, oht_str_eq)
+
+/** Insertion implementation for the ordered hash table with string keys */
+#define oht_put_str(h, value_type, key, index, absent) \
+oht_put((h), const char*, value_type, (key), (index), (absent), oht_str_hash, oht_str_eq)
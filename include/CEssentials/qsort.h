@@ -47,7 +47,15 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define qsort_swap(a, b, type) \
 	do { type tmp = (a); (a) = (b); (b) = tmp; } while (0)
 
-#define qsort_iterative(arr, l, h, type, cmp) \
+#define qsort_ref(x) (&(x))
+
+#define qsort_iterative(arr, l, h, type, cmp) qsort_iterative_by(arr, l, h, type, qsort_ref, cmp)
+
+/*
+ * Three-way partitioning around the middle element: elements equal to the pivot are gathered in the middle
+ * and never sorted again, so input with many duplicate keys is sorted in O(n log d) for d distinct keys.
+ */
+#define qsort_iterative_by(arr, l, h, type, project, cmp) \
 	do { \
 		size_t qsort_stackSize = (h) - (l) + 1; \
 		size_t *qsort_stack = qsort_stackSize > QSORT_MAX_STACK ? malloc(qsort_stackSize * sizeof(size_t)) : alloca(qsort_stackSize * sizeof(size_t)); \
@@ -55,26 +63,32 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 		qsort_stack[++qsort_top] = (l); \
 		qsort_stack[++qsort_top] = (h); \
 		while (qsort_top >= 0) { \
-        	size_t qsort_h = qsort_stack[qsort_top--]; \
+			size_t qsort_h = qsort_stack[qsort_top--]; \
 			size_t qsort_l = qsort_stack[qsort_top--]; \
-			type qsort_x = (arr)[qsort_h]; \
-			ptrdiff_t qsort_i = ((ptrdiff_t) qsort_l - 1); \
-			for (size_t qsort_j = (qsort_l); qsort_j <= (qsort_h) - 1; qsort_j++) { \
-				if (cmp(&(arr)[qsort_j], &qsort_x) < 0) { \
+			type qsort_x = (arr)[qsort_l + (qsort_h - qsort_l) / 2]; /* Middle pivot handles (almost) sorted input well */ \
+			size_t qsort_lt = qsort_l, qsort_i = qsort_l, qsort_gt = qsort_h + 1; \
+			while (qsort_i < qsort_gt) { \
+				int qsort_c = cmp(project((arr)[qsort_i]), project(qsort_x)); \
+				if (qsort_c < 0) { \
+					qsort_swap((arr)[qsort_lt], (arr)[qsort_i], type); \
+					qsort_lt++; \
+					qsort_i++; \
+				} else if (qsort_c > 0) { \
+					qsort_gt--; \
+					qsort_swap((arr)[qsort_i], (arr)[qsort_gt], type); \
+				} else { \
 					qsort_i++; \
-					qsort_swap((arr)[qsort_i], (arr)[qsort_j], type); \
 				} \
 			} \
-			qsort_swap((arr)[qsort_i + 1], (arr)[(qsort_h)], type); \
-			ptrdiff_t qsort_p = qsort_i + 1; \
-			if (qsort_p - 1 > (ptrdiff_t) qsort_l) { \
-            	qsort_stack[++qsort_top] = qsort_l; \
-				qsort_stack[++qsort_top] = qsort_p - 1; \
-            } \
-			if (qsort_p + 1 < (ptrdiff_t) qsort_h) { \
-            	qsort_stack[++qsort_top] = qsort_p + 1; \
+			/* Now [l, lt) < pivot, [lt, gt) == pivot, [gt, h] > pivot */ \
+			if (qsort_lt > qsort_l + 1) { \
+				qsort_stack[++qsort_top] = qsort_l; \
+				qsort_stack[++qsort_top] = qsort_lt - 1; \
+			} \
+			if (qsort_gt < qsort_h) { \
+				qsort_stack[++qsort_top] = qsort_gt; \
 				qsort_stack[++qsort_top] = qsort_h; \
-            } \
+			} \
 		} \
 		if (qsort_stackSize > QSORT_MAX_STACK) { \
 			free(qsort_stack); \
@@ -88,6 +102,18 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
         } \
     } while (0)
 
+/**
+ * Sort provided array of given type comparing `cmp(project(a), project(b))` for its elements.
+ *
+ * \p project is a macro which extracts the sort key from an element (e.g. `#define entry_key(e) (e).key`),
+ * so \p cmp receives whatever \p project returns instead of pointers to the elements.
+ */
+#define qsort_by(arr, count, type, project, cmp) do { \
+        if ((count) > 1) { \
+            qsort_iterative_by((arr), 0, (count) - 1, type, project, cmp); \
+        } \
+    } while (0)
+
 /** Comparator for numeric values (works for char, short, int, long, long long, float, double, long double) */
 #define qsort_int_cmp(a, b) (*(a) > *(b) ? 1 : (*(a) < *(b) ? -1 : 0))
 
@@ -0,0 +1,149 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+/**
+ * @file
+ * @brief Chunked string builder for large concatenations without reallocation copies.
+ * @details
+ * A builder appends characters into a list of blocks which never move, so growth never copies already written
+ * characters (unlike a dynstr which is reallocated and copied every time its capacity doubles). Blocks grow
+ * geometrically (from the initial block size up to STRBUILDER_MAX_BLOCK_SIZE), so the number of blocks stays small.
+ *
+ * strbuilder_reserve() returns a pointer to a slot of characters that can be filled later (e.g. a length prefix
+ * which is known only after the body is built). The result is either copied once into a dynstr with
+ * strbuilder_to_dynstr() or passed to `writev` without copying using strbuilder_iovec().
+ *
+ * Example of usage:
+ * \code
+ * strbuilder_t b;
+ * strbuilder_init(&b, 0);
+ * char *length = strbuilder_reserve(&b, 8);
+ * size_t body_start = strbuilder_size(&b);
+ * for (int i = 0; i < 1000; i++) {
+ *     strbuilder_printf(&b, "line %d\n", i);
+ * }
+ * char buffer[9];
+ * snprintf(buffer, sizeof(buffer), "%08zx", strbuilder_size(&b) - body_start);
+ * memcpy(length, buffer, 8);
+ * strbuilder_iovec_t iov[64];
+ * size_t count = strbuilder_iovec(&b, iov, 64);
+ * writev(fd, iov, (int) count); // count <= 64 is not checked here for brevity
+ * strbuilder_destroy(&b);
+ * \endcode
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include "dynstr.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/uio.h>
+/** A chunk of output (the same as `struct iovec` on POSIX systems, so an array can be passed to `writev`). */
+typedef struct iovec strbuilder_iovec_t;
+#else
+/** A chunk of output (the same layout as `struct iovec` on POSIX systems). */
+typedef struct strbuilder_iovec {
+	void *iov_base; //!< First character of the chunk.
+	size_t iov_len; //!< Number of characters in the chunk.
+} strbuilder_iovec_t;
+#endif
+
+/** Default size of the first block. */
+#define STRBUILDER_DEFAULT_BLOCK_SIZE 4096
+
+/** Blocks don't grow beyond this size (unless a single append or reservation is larger). */
+#define STRBUILDER_MAX_BLOCK_SIZE (1024 * 1024)
+
+/** A block of characters (allocated with an extra character so that `vsnprintf` can write its NULL character). */
+typedef struct strbuilder_block {
+	struct strbuilder_block *next; //!< Next block or NULL.
+	size_t size; //!< Number of used characters.
+	size_t capacity; //!< Number of allocated characters.
+	char data[]; //!< Characters.
+} strbuilder_block_t;
+
+/** A chunked string builder. */
+typedef struct strbuilder {
+	strbuilder_block_t *head; //!< First block or NULL.
+	strbuilder_block_t *tail; //!< Last block (characters are appended to it) or NULL.
+	size_t size; //!< Total number of characters.
+	size_t block_count; //!< Number of blocks.
+	size_t block_size; //!< Size of the first block.
+} strbuilder_t;
+
+/** Initialize an empty builder (\p block_size is the size of the first block, 0 means the default). */
+void strbuilder_init(strbuilder_t *b, size_t block_size);
+
+/** Free all memory of a builder. */
+void strbuilder_destroy(strbuilder_t *b);
+
+/** Remove all characters keeping the first block for reuse (slots returned by strbuilder_reserve() become invalid). */
+void strbuilder_clear(strbuilder_t *b);
+
+/** Get total number of characters in a builder. */
+static inline size_t strbuilder_size(const strbuilder_t *b) {
+	return b->size;
+}
+
+/** Append \p count characters. Returns false on memory allocation failure. */
+bool strbuilder_push_chars(strbuilder_t *b, const char *data, size_t count);
+
+/** Append a single character. Returns false on memory allocation failure. */
+static inline bool strbuilder_push(strbuilder_t *b, char c) {
+	if (b->tail && b->tail->size < b->tail->capacity) {
+		b->tail->data[b->tail->size++] = c;
+		b->size++;
+		return true;
+	}
+	return strbuilder_push_chars(b, &c, 1);
+}
+
+/** Append a NULL-terminated string. Returns false on memory allocation failure. */
+bool strbuilder_append(strbuilder_t *b, const char *s);
+
+/** Append a dynamic string. Returns false on memory allocation failure. */
+bool strbuilder_cat(strbuilder_t *b, const char *s);
+
+/** Append printf-formatted contents. Returns false on memory allocation failure or a formatting error. */
+bool strbuilder_printf(strbuilder_t *b, DYNSTR_FMT_ARG const char *fmt, ...) DYNSTR_FMT_FUNC(2, 3);
+
+/** Append printf-formatted contents using `va_list` arguments. Returns false on failure. */
+bool strbuilder_vprintf(strbuilder_t *b, const char *fmt, va_list args);
+
+/**
+ * Append \p count uninitialized contiguous characters and return a pointer to them, so they can be filled later.
+ *
+ * The pointer stays valid until the builder is cleared or destroyed. Returns NULL on memory allocation failure.
+ */
+char *strbuilder_reserve(strbuilder_t *b, size_t count);
+
+/**
+ * Copy contents of a builder into a new dynamic string (allocated once with the exact size).
+ *
+ * If \p dest is not NULL, contents are appended to it instead. Returns NULL on memory allocation failure.
+ */
+dynstr strbuilder_to_dynstr(const strbuilder_t *b, dynstr dest) DYNSTR_WARN_UNUSED;
+
+/**
+ * Describe contents of a builder by an array of chunks pointing into its blocks (without copying).
+ *
+ * Fills at most \p max_count elements of \p iov and returns the number of chunks needed for the whole contents
+ * (at most the block count), so a result greater than \p max_count means that the array was too small.
+ * The chunks are valid until the builder is modified.
+ */
+size_t strbuilder_iovec(const strbuilder_t *b, strbuilder_iovec_t *iov, size_t max_count);
@@ -0,0 +1,138 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+/**
+ * @file
+ * @brief String interning pool.
+ * @details
+ * The pool stores a single copy of each distinct string, so equal strings share memory and can be compared
+ * by pointer or by a 32-bit ID. Strings are allocated from large chunks using a bump allocator and never move,
+ * so returned pointers stay valid until strpool_destroy() is called (individual strings cannot be freed).
+ *
+ * Interned strings are NULL-terminated and have a dynstr header, so dynstr_size() can be used with them.
+ * They are read-only: don't pass them to dynstr functions that modify or free a string.
+ *
+ * Interned strings can be used as hash table keys with strpool_hash() and strpool_eq() (the hash is stored
+ * in the pool, equality is a pointer comparison).
+ *
+ * Example of usage:
+ * \code
+ * strpool_t pool;
+ * strpool_init(&pool);
+ *
+ * const char *a = strpool_intern(&pool, "hello");
+ * const char *b = strpool_intern_chars(&pool, "hello world", 5);
+ * assert(a == b);
+ * assert(strpool_at(&pool, strpool_id(a)) == a);
+ *
+ * HT(const char*, int) ht;
+ * ht_init(ht);
+ * ht_put(ht, const char*, int, a, index, absent, strpool_hash, strpool_eq);
+ * ...
+ * ht_destroy(ht);
+ * strpool_destroy(&pool);
+ * \endcode
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dynstr.h"
+#include "dynvec.h"
+#include "hashset.h"
+
+/** Size of arena chunks used by the string pool (larger strings are allocated in dedicated chunks). */
+#ifndef STRPOOL_CHUNK_SIZE
+#define STRPOOL_CHUNK_SIZE 65536
+#endif
+
+/** Invalid string ID */
+#define STRPOOL_INVALID_ID UINT32_MAX
+
+/**
+ * A header that prepended to all interned strings (followed by a dynstr header).
+ * Normally shouldn't be accessed directly from user code.
+ */
+typedef struct strpool_entry {
+	uint32_t id; //!< String ID.
+	uint32_t hash; //!< String hash.
+} strpool_entry_t;
+
+/** An arena chunk of the string pool. Normally shouldn't be accessed directly from user code. */
+typedef union strpool_chunk {
+	union strpool_chunk *next; //!< Next (previously allocated) chunk.
+	strpool_entry_t align; //!< Unused, makes chunk data properly aligned.
+} strpool_chunk_t;
+
+/** String pool struct definition. */
+typedef struct strpool {
+	HS(const char*) index; //!< Interned strings.
+	dynvec(const char*) strings; //!< Interned strings by their ID.
+	strpool_chunk_t *chunks; //!< Allocated chunks.
+	char *chunk_ptr; //!< Free space of the current chunk.
+	size_t chunk_left; //!< Free space size of the current chunk.
+	size_t memory; //!< Total size of allocated chunks.
+} strpool_t;
+
+/** Obtain a pointer to an interned string header. Normally shouldn't be accessed directly from user code. */
+#define strpool_entry(s) ((strpool_entry_t*) ((char*) (s) - dynstr_header_size(s) - sizeof(strpool_entry_t)))
+
+/** Get the ID of an interned string. */
+#define strpool_id(s) (strpool_entry(s)->id)
+
+/** Hash implementation for interned strings (uses a precomputed hash). */
+#define strpool_hash(s) ((size_t) strpool_entry(s)->hash)
+
+/** Equality implementation for interned strings (pointer comparison). */
+#define strpool_eq(a, b) ((a) == (b))
+
+/** Get number of strings stored in the pool. */
+#define strpool_count(pool) dynvec_size((pool)->strings)
+
+/** Get an interned string by its ID. */
+#define strpool_at(pool, id) ((const char*) dynvec_at((pool)->strings, (id)))
+
+/** Get total size of memory chunks allocated for string data. */
+#define strpool_memory(pool) ((pool)->memory)
+
+/** Empty string pool initialization. No heap allocation will be performed. */
+void strpool_init(strpool_t *pool);
+
+/** Free all memory used by the string pool. All interned strings become invalid. */
+void strpool_destroy(strpool_t *pool);
+
+/**
+ * Intern a character array \p data of \p count characters.
+ *
+ * Returns the interned string (the same pointer for equal strings) or `NULL` on memory allocation failure.
+ */
+const char *strpool_intern_chars(strpool_t *pool, const char *data, size_t count) DYNSTR_WARN_UNUSED;
+
+/** Intern a NULL-terminated string. */
+const char *strpool_intern(strpool_t *pool, const char *s) DYNSTR_WARN_UNUSED;
+
+/** Intern a dynamic string (the source string is left untouched). */
+const char *strpool_intern_dynstr(strpool_t *pool, dynstr s) DYNSTR_WARN_UNUSED;
+
+/**
+ * Find an interned string equal to a character array. Returns `NULL` if there is no such string.
+ *
+ * Lookups never modify the pool (they don't record HS_STATS statistics), so they may run concurrently.
+ */
+const char *strpool_find_chars(const strpool_t *pool, const char *data, size_t count) DYNSTR_WARN_UNUSED;
+
+/** Find an interned string equal to a NULL-terminated string. Returns `NULL` if there is no such string. */
+const char *strpool_find(const strpool_t *pool, const char *s) DYNSTR_WARN_UNUSED;
@@ -0,0 +1,170 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#pragma once
+
+/**
+ * @file
+ * @brief Non-owning string views (a pointer and a length) with substring operations that never allocate.
+ * @details
+ * A view refers to characters owned by someone else (a dynstr, a C-string or any other buffer), so the buffer must
+ * outlive all views of it. Slicing and trimming only adjust the pointer and the length of the view, they never
+ * copy or modify characters, so parsing code can work on spans of the original buffer and allocate
+ * (using strview_to_dynstr()) only for the parts it keeps. Views are not NULL-terminated, print them with
+ * STRVIEW_FMT and STRVIEW_ARG().
+ *
+ * Example of usage:
+ * \code
+ * strview_t rest = strview_from_cstr(" key = value; other = 42 "), item;
+ * while (strview_split_next(&rest, strview_from_cstr(";"), &item)) {
+ *     strview_t key, value;
+ *     if (strview_split_next(&item, strview_from_cstr("="), &key)) {
+ *         value = strview_trim(item, " ");
+ *         printf(STRVIEW_FMT " -> " STRVIEW_FMT "\n", STRVIEW_ARG(strview_trim(key, " ")), STRVIEW_ARG(value));
+ *     }
+ * }
+ * \endcode
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "dynstr.h"
+#include "charset.h"
+
+/** A non-owning view of a character array. */
+typedef struct strview {
+	const char *ptr; //!< First character (doesn't need to be NULL-terminated).
+	size_t len; //!< Number of characters.
+} strview_t;
+
+/** Index returned by search functions when nothing is found. */
+#define STRVIEW_NPOS SIZE_MAX
+
+/** printf format for a view (use with STRVIEW_ARG()). */
+#define STRVIEW_FMT "%.*s"
+
+/** printf arguments for a view (use with STRVIEW_FMT). */
+#define STRVIEW_ARG(v) (int) (v).len, (v).ptr
+
+/** Make a view of \p len characters starting from \p ptr. */
+static inline strview_t strview_make(const char *ptr, size_t len) {
+	strview_t v = { ptr, len };
+	return v;
+}
+
+/** Make a view of a NULL-terminated string. */
+static inline strview_t strview_from_cstr(const char *s) {
+	return strview_make(s, strlen(s));
+}
+
+/** Make a view of a dynamic string (valid until the string is modified or freed). */
+static inline strview_t strview_from_dynstr(const char *s) {
+	return strview_make(s, dynstr_size(s));
+}
+
+/** Check if a view is empty. */
+static inline bool strview_empty(strview_t v) {
+	return v.len == 0;
+}
+
+/** Allocate a dynamic string copying the view characters. */
+dynstr strview_to_dynstr(strview_t v) DYNSTR_WARN_UNUSED;
+
+/** Append the view characters to a dynamic string. */
+dynstr dynstr_push_view(dynstr s, strview_t v) DYNSTR_WARN_UNUSED;
+
+/**
+ * Take a subview.
+ *
+ * Both arguments can be negative (in this case they counted relatively to the view end), the same as in dynstr_range().
+ */
+strview_t strview_slice(strview_t v, ptrdiff_t start, ptrdiff_t count);
+
+/** Skip first characters from a provided character set (NULL-terminated). */
+strview_t strview_trim_start(strview_t v, const char *chars);
+
+/** Skip last characters from a provided character set (NULL-terminated). */
+strview_t strview_trim_end(strview_t v, const char *chars);
+
+/** Skip first and last characters from a provided character set (NULL-terminated). */
+strview_t strview_trim(strview_t v, const char *chars);
+
+/** Skip first characters which belong to a character set. */
+strview_t strview_trim_start_charset(strview_t v, const charset_t *set);
+
+/** Skip last characters which belong to a character set. */
+strview_t strview_trim_end_charset(strview_t v, const charset_t *set);
+
+/** Skip first and last characters which belong to a character set. */
+strview_t strview_trim_charset(strview_t v, const charset_t *set);
+
+/**
+ * Compare two views.
+ * Return value has the same meaning as `strcmp`
+ * (0 - \p a equal to \p b, -1 - \p a less than \p b, 1 - \p a greater than \p b).
+ */
+int strview_cmp(strview_t a, strview_t b);
+
+/** Check two views for equality. */
+static inline bool strview_eq(strview_t a, strview_t b) {
+	return a.len == b.len && (a.len == 0 || memcmp(a.ptr, b.ptr, a.len) == 0);
+}
+
+/** Verify that a view starts with \p prefix. */
+static inline bool strview_has_prefix(strview_t v, strview_t prefix) {
+	return prefix.len <= v.len && (prefix.len == 0 || memcmp(v.ptr, prefix.ptr, prefix.len) == 0);
+}
+
+/** Verify that a view ends with \p suffix. */
+static inline bool strview_has_suffix(strview_t v, strview_t suffix) {
+	return suffix.len <= v.len && (suffix.len == 0 || memcmp(v.ptr + v.len - suffix.len, suffix.ptr, suffix.len) == 0);
+}
+
+/** Find the first occurrence of a character. Returns its index or STRVIEW_NPOS. */
+size_t strview_find_char(strview_t v, int c);
+
+/** Find the last occurrence of a character. Returns its index or STRVIEW_NPOS. */
+size_t strview_rfind_char(strview_t v, int c);
+
+/** Find the first occurrence of \p needle. Returns its index or STRVIEW_NPOS (empty needle is found at 0). */
+size_t strview_find(strview_t v, strview_t needle);
+
+/** Find the last occurrence of \p needle. Returns its index or STRVIEW_NPOS (empty needle is found at the end). */
+size_t strview_rfind(strview_t v, strview_t needle);
+
+/** Find the first character which belongs to a character set. Returns its index or STRVIEW_NPOS. */
+size_t strview_find_any(strview_t v, const charset_t *set);
+
+/** Find the last character which belongs to a character set. Returns its index or STRVIEW_NPOS. */
+size_t strview_rfind_any(strview_t v, const charset_t *set);
+
+/**
+ * Split the next token from the view \p rest by \p separator.
+ *
+ * Stores the characters before the first separator into \p token and advances \p rest past the separator
+ * (if there is no separator or \p separator is empty, the whole \p rest becomes the token). Returns false when \p rest is exhausted,
+ * so it can be used as a loop condition. A string ending with a separator doesn't produce an empty last token.
+ */
+bool strview_split_next(strview_t *rest, strview_t separator, strview_t *token);
+
+/**
+ * Split the next token from the view \p rest by any separator character from \p separators.
+ *
+ * Works like strview_split_next(), every separator character ends a token (so adjacent separators produce
+ * empty tokens, use strview_trim_start_charset() on \p rest to skip them).
+ */
+bool strview_split_next_any(strview_t *rest, const charset_t *separators, strview_t *token);
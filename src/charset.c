@@ -0,0 +1,117 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <CEssentials/bitops.h>
+#include <CEssentials/charset.h>
+
+void charset_invert(charset_t *set) {
+	for (int i = 0; i < 4; i++) {
+		set->bits[i] = ~set->bits[i];
+	}
+	set->size = 256 - set->size;
+	if (set->size <= CHARSET_SMALL_SIZE) {
+		unsigned int size = 0;
+		for (unsigned int c = 0; c < 256; c++) {
+			if (charset_contains(set, (char) c)) {
+				set->members[size++] = (unsigned char) c;
+			}
+		}
+	}
+}
+
+#if defined(BITOPS_SSE2)
+/** Get a bit mask of set members among 16 characters (the set must have from 1 to CHARSET_SMALL_SIZE members) */
+static inline unsigned int charset_block_mask(const __m128i *patterns, unsigned int size, const char *block) {
+	__m128i chunk = _mm_loadu_si128((const __m128i*) block);
+	__m128i matches = _mm_cmpeq_epi8(chunk, patterns[0]);
+	for (unsigned int k = 1; k < size; k++) {
+		matches = _mm_or_si128(matches, _mm_cmpeq_epi8(chunk, patterns[k]));
+	}
+	return (unsigned int) _mm_movemask_epi8(matches);
+}
+
+/** Broadcast each member of a small set to a vector */
+static inline void charset_patterns(const charset_t *set, __m128i *patterns) {
+	for (unsigned int k = 0; k < set->size; k++) {
+		patterns[k] = _mm_set1_epi8((char) set->members[k]);
+	}
+}
+#endif
+
+/** Get index of the first character whose membership in the set is \p member (or \p count if there is none) */
+static size_t charset_scan(const charset_t *set, const char *data, size_t count, bool member) {
+	if (set->size == 0 || set->size == 256) {
+		return (set->size != 0) == member ? 0 : count;
+	}
+	size_t i = 0;
+#if defined(BITOPS_SSE2)
+	if (set->size <= CHARSET_SMALL_SIZE) {
+		__m128i patterns[CHARSET_SMALL_SIZE];
+		charset_patterns(set, patterns);
+		unsigned int flip = member ? 0 : 0xFFFF;
+		for (; i + 16 <= count; i += 16) {
+			unsigned int mask = charset_block_mask(patterns, set->size, data + i) ^ flip;
+			if (mask) {
+				return i + bitops_ctz32(mask);
+			}
+		}
+	}
+#endif
+	while (i < count && charset_contains(set, data[i]) != member) {
+		i++;
+	}
+	return i;
+}
+
+/** Get number of last characters whose membership in the set isn't \p member */
+static size_t charset_rscan(const charset_t *set, const char *data, size_t count, bool member) {
+	if (set->size == 0 || set->size == 256) {
+		return (set->size != 0) == member ? 0 : count;
+	}
+	size_t j = count;
+#if defined(BITOPS_SSE2)
+	if (set->size <= CHARSET_SMALL_SIZE) {
+		__m128i patterns[CHARSET_SMALL_SIZE];
+		charset_patterns(set, patterns);
+		unsigned int flip = member ? 0 : 0xFFFF;
+		for (; j >= 16; j -= 16) {
+			unsigned int mask = charset_block_mask(patterns, set->size, data + j - 16) ^ flip;
+			if (mask) {
+				return 16 - 1 - (63 - bitops_clz64(mask)) + (count - j);
+			}
+		}
+	}
+#endif
+	while (j > 0 && charset_contains(set, data[j - 1]) != member) {
+		j--;
+	}
+	return count - j;
+}
+
+size_t charset_span(const charset_t *set, const char *data, size_t count) {
+	return charset_scan(set, data, count, false);
+}
+
+size_t charset_cspan(const charset_t *set, const char *data, size_t count) {
+	return charset_scan(set, data, count, true);
+}
+
+size_t charset_rspan(const charset_t *set, const char *data, size_t count) {
+	return charset_rscan(set, data, count, false);
+}
+
+size_t charset_rcspan(const charset_t *set, const char *data, size_t count) {
+	return charset_rscan(set, data, count, true);
+}
@@ -19,28 +19,188 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <CEssentials/roundup.h>
 #include <CEssentials/dynstr.h>
 
-#define dynstr_data(header) ((dynstr) ((header) + 1))
+/** Size of the reference counter or the arena pointer stored before the header of a dynamic string (or zero). */
+#define dynstr_extra_size(s) ((dynstr_type_byte(s) & DYNSTR_FLAG_REFCOUNTED) ? sizeof(size_t) : \
+	(dynstr_type_byte(s) & DYNSTR_FLAG_ARENA) ? sizeof(dynstr_arena_t*) : 0)
+
+/** Alignment of memory blocks of strings allocated in arenas. */
+#define DYNSTR_ARENA_ALIGNMENT sizeof(void*)
+
+/** Size of the stack buffer used to format short strings in a single pass. */
+#ifndef DYNSTR_PRINTF_BUFFER_SIZE
+#define DYNSTR_PRINTF_BUFFER_SIZE 256
+#endif
+
+/** Pointer to the beginning of the memory block of a dynamic string. */
+#define dynstr_block(s) ((s) - dynstr_header_size(s) - dynstr_extra_size(s))
+
+static dynstr dynstr_alloc_flags(size_t capacity, unsigned flags) {
+	unsigned type = dynstr_capacity_type(capacity);
+	size_t prefix_size = dynstr_type_header_size(type) + ((flags & DYNSTR_FLAG_REFCOUNTED) ? sizeof(size_t) : 0);
+	if (capacity > SIZE_MAX - prefix_size - 1) { // Integer overflow
+		return NULL;
+	}
+	char *block = malloc(prefix_size + capacity + 1);
+	if (!block) {
+		return NULL;
+	}
+	dynstr s = block + prefix_size;
+	dynstr_init_header(s, type | flags, 0, capacity);
+	if (flags & DYNSTR_FLAG_REFCOUNTED) {
+		*dynstr_refcount_ptr(s) = 1;
+	}
+	s[0] = '\0';
+	return s;
+}
 
 dynstr dynstr_alloc(size_t capacity) {
-	size_t total_size = sizeof(dynstr_header_t) + capacity + 1;
-	if (total_size <= sizeof(dynstr_header_t)) { // Integer overflow
+	return dynstr_alloc_flags(capacity, 0);
+}
+
+void dynstr_arena_init(dynstr_arena_t *arena, size_t chunk_size) {
+	arena->head = arena->current = NULL;
+	arena->top = arena->end = arena->last = NULL;
+	arena->chunk_size = chunk_size ? chunk_size : DYNSTR_ARENA_DEFAULT_CHUNK_SIZE;
+}
+
+void dynstr_arena_destroy(dynstr_arena_t *arena) {
+	dynstr_arena_chunk_t *chunk = arena->head;
+	while (chunk) {
+		dynstr_arena_chunk_t *next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+	dynstr_arena_init(arena, arena->chunk_size);
+}
+
+void dynstr_arena_reset(dynstr_arena_t *arena) {
+	arena->current = arena->head;
+	arena->top = arena->head ? (char*) (arena->head + 1) : NULL;
+	arena->end = arena->head ? arena->top + arena->head->capacity : NULL;
+	arena->last = NULL;
+}
+
+/** Switch to the next chunk of an arena which can hold \p size bytes (reused after a reset or allocated) */
+static bool dynstr_arena_next_chunk(dynstr_arena_t *arena, size_t size) {
+	dynstr_arena_chunk_t *chunk = arena->current ? arena->current->next : arena->head;
+	if (!chunk || chunk->capacity < size) {
+		size_t capacity = size > arena->chunk_size ? size : arena->chunk_size;
+		if (capacity > SIZE_MAX - sizeof(dynstr_arena_chunk_t)) { // Integer overflow
+			return false;
+		}
+		dynstr_arena_chunk_t *new_chunk = malloc(sizeof(dynstr_arena_chunk_t) + capacity);
+		if (!new_chunk) {
+			return false;
+		}
+		new_chunk->capacity = capacity;
+		new_chunk->next = chunk;
+		if (arena->current) {
+			arena->current->next = new_chunk;
+		} else {
+			arena->head = new_chunk;
+		}
+		chunk = new_chunk;
+	}
+	arena->current = chunk;
+	arena->top = (char*) (chunk + 1);
+	arena->end = arena->top + chunk->capacity;
+	return true;
+}
+
+/** Allocate an aligned memory block of \p size bytes from an arena */
+static char *dynstr_arena_alloc_block(dynstr_arena_t *arena, size_t size) {
+	size_t padding = arena->top ? (size_t) (-(uintptr_t) arena->top & (DYNSTR_ARENA_ALIGNMENT - 1)) : 0;
+	if (!arena->top || padding > (size_t) (arena->end - arena->top) ||
+			size > (size_t) (arena->end - arena->top) - padding) {
+		if (!dynstr_arena_next_chunk(arena, size)) {
+			return NULL;
+		}
+		padding = 0;
+	}
+	char *block = arena->top + padding;
+	arena->top = block + size;
+	arena->last = block;
+	return block;
+}
+
+dynstr dynstr_arena_alloc(dynstr_arena_t *arena, size_t capacity) {
+	unsigned type = dynstr_capacity_type(capacity);
+	size_t prefix_size = sizeof(dynstr_arena_t*) + dynstr_type_header_size(type);
+	if (capacity > SIZE_MAX - prefix_size - 1) { // Integer overflow
 		return NULL;
 	}
-	dynstr_header_t *header = malloc(total_size);
-	if (!header) {
+	char *block = dynstr_arena_alloc_block(arena, prefix_size + capacity + 1);
+	if (!block) {
 		return NULL;
 	}
-	header->capacity = capacity;
-	header->size = 0;
-	dynstr s = dynstr_data(header);
+	dynstr s = block + prefix_size;
+	dynstr_init_header(s, type | DYNSTR_FLAG_ARENA, 0, capacity);
+	*dynstr_arena_ptr(s) = arena;
 	s[0] = '\0';
 	return s;
 }
 
+dynstr dynstr_arena_new_chars(dynstr_arena_t *arena, const char *data, size_t count) {
+	dynstr s = dynstr_arena_alloc(arena, count);
+	if (s) {
+		dynstr_set_size(s, count);
+		if (data) {
+			memcpy(s, data, count);
+		}
+		s[count] = '\0';
+	}
+	return s;
+}
+
+dynstr dynstr_arena_new(dynstr_arena_t *arena, const char *data) {
+	return dynstr_arena_new_chars(arena, data, strlen(data));
+}
+
+dynstr dynstr_arena_new_printf(dynstr_arena_t *arena, const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	dynstr s = dynstr_arena_alloc(arena, 0);
+	if (s) {
+		s = dynstr_vprintf(s, fmt, args);
+	}
+	va_end(args);
+	return s;
+}
+
+/**
+ * Reallocate a string allocated in an arena for a new capacity.
+ *
+ * The last allocation of the arena is resized in place if the current chunk has enough room,
+ * other strings are copied to a new block (the old one is reclaimed by dynstr_arena_reset()).
+ */
+static dynstr dynstr_arena_realloc(dynstr s, size_t capacity) {
+	dynstr_arena_t *arena = *dynstr_arena_ptr(s);
+	unsigned new_type = dynstr_capacity_type(capacity);
+	size_t size = dynstr_size(s), new_prefix_size = sizeof(dynstr_arena_t*) + dynstr_type_header_size(new_type);
+	if (capacity > SIZE_MAX - new_prefix_size - 1) { // Integer overflow
+		return NULL;
+	}
+	size_t block_size = new_prefix_size + capacity + 1;
+	char *block = dynstr_block(s);
+	if (block == arena->last && block_size <= (size_t) (arena->end - block)) {
+		memmove(block + new_prefix_size, s, size + 1);
+		arena->top = block + block_size;
+		s = block + new_prefix_size;
+		dynstr_init_header(s, new_type | DYNSTR_FLAG_ARENA, size, capacity);
+		return s;
+	}
+	dynstr copy = dynstr_arena_alloc(arena, capacity);
+	if (copy) {
+		memcpy(copy, s, size + 1);
+		dynstr_set_size(copy, size);
+	}
+	return copy;
+}
+
 dynstr dynstr_new_chars(const char *data, size_t count) {
 	dynstr s = dynstr_alloc(count);
 	if (s) {
-		dynstr_size(s) = count;
+		dynstr_set_size(s, count);
 		if (data) {
 			memcpy(s, data, count);
 		}
@@ -62,61 +222,158 @@ dynstr dynstr_new_printf(const char *fmt, ...) {
 }
 
 dynstr dynstr_new_vprintf(const char *fmt, va_list args) {
+	// Short results are formatted only once (into the stack buffer)
+	char buffer[DYNSTR_PRINTF_BUFFER_SIZE];
 	va_list args_copy;
 	va_copy(args_copy, args);
-	int count = vsnprintf(NULL, 0, fmt, args_copy);
+	int count = vsnprintf(buffer, sizeof(buffer), fmt, args_copy);
 	va_end(args_copy);
-	if (count >= 0) {
-		dynstr s = dynstr_new_chars(NULL, (size_t) count);
-		vsnprintf(s, (size_t) count + 1, fmt, args);
-		return s;
-	} else {
+	if (count < 0) {
 		return dynstr_new(fmt);
 	}
+	if ((size_t) count < sizeof(buffer)) {
+		return dynstr_new_chars(buffer, (size_t) count);
+	}
+	dynstr s = dynstr_new_chars(NULL, (size_t) count);
+	if (s) {
+		vsnprintf(s, (size_t) count + 1, fmt, args);
+	}
+	return s;
 }
 
 dynstr dynstr_dup(dynstr s) {
-	return dynstr_new_chars(s, dynstr_size(s));
+	return dynstr_retain(s);
 }
 
 void dynstr_free(dynstr s) {
 	if (!s) return;
-	dynstr_header_t *header = dynstr_header(s);
-	free(header);
+	if (dynstr_type_byte(s) & DYNSTR_FLAG_ARENA) {
+		// Only the last allocation can be returned to the arena
+		dynstr_arena_t *arena = *dynstr_arena_ptr(s);
+		if (dynstr_block(s) == arena->last) {
+			arena->top = arena->last;
+			arena->last = NULL;
+		}
+		return;
+	}
+	if ((dynstr_type_byte(s) & DYNSTR_FLAG_REFCOUNTED) && --*dynstr_refcount_ptr(s) > 0) {
+		return;
+	}
+	free(dynstr_block(s));
 }
 
-dynstr dynstr_shrink(dynstr s) {
-	dynstr_header_t *header = dynstr_header(s);
-	if (header->size == header->capacity) return s;
-	size_t total_size = sizeof(dynstr_header_t) + header->size + 1;
-	dynstr_header_t *new_header = realloc(header, total_size);
-	if (!new_header) {
-		free(header);
+dynstr dynstr_make_refcounted(dynstr s) {
+	if (dynstr_type_byte(s) & (DYNSTR_FLAG_REFCOUNTED | DYNSTR_FLAG_ARENA)) return s;
+	size_t header_size = dynstr_header_size(s), size = dynstr_size(s), capacity = dynstr_capacity(s);
+	char *block = s - header_size;
+	if (header_size + capacity + 1 > SIZE_MAX - sizeof(size_t)) { // Integer overflow
+		free(block);
+		return NULL;
+	}
+	char *new_block = realloc(block, sizeof(size_t) + header_size + capacity + 1);
+	if (!new_block) {
+		free(block);
 		return NULL;
 	}
-	new_header->capacity = new_header->size;
-	return dynstr_data(new_header);
+	memmove(new_block + sizeof(size_t), new_block, header_size + size + 1);
+	s = new_block + sizeof(size_t) + header_size;
+	dynstr_type_byte(s) |= DYNSTR_FLAG_REFCOUNTED;
+	*dynstr_refcount_ptr(s) = 1;
+	return s;
 }
 
-dynstr dynstr_reserve(dynstr s, size_t capacity) {
-	dynstr_header_t *header = dynstr_header(s);
-	if (capacity <= header->capacity) return s;
-	size_t new_total_size = sizeof(dynstr_header_t) + capacity + 1;
-	if (new_total_size <= sizeof(dynstr_header_t)) { // Integer overflow
-		free(header);
+dynstr dynstr_retain(dynstr s) {
+	if (dynstr_type_byte(s) & DYNSTR_FLAG_REFCOUNTED) {
+		++*dynstr_refcount_ptr(s);
+		return s;
+	}
+	if (dynstr_type_byte(s) & DYNSTR_FLAG_ARENA) {
+		return dynstr_arena_new_chars(*dynstr_arena_ptr(s), s, dynstr_size(s));
+	}
+	return dynstr_new_chars(s, dynstr_size(s));
+}
+
+void dynstr_release(dynstr s) {
+	dynstr_free(s);
+}
+
+/**
+ * Replace a shared dynamic string by an unshared reference-counted copy of its characters [\p begin, \p end)
+ * with at least \p capacity characters of memory block.
+ *
+ * The reference to the original string is dropped, also on memory allocation failure.
+ */
+static dynstr dynstr_detach(dynstr s, size_t begin, size_t end, size_t capacity) {
+	dynstr copy = dynstr_alloc_flags(capacity > end - begin ? capacity : end - begin, DYNSTR_FLAG_REFCOUNTED);
+	if (copy) {
+		memcpy(copy, s + begin, end - begin);
+		copy[end - begin] = '\0';
+		dynstr_set_size(copy, end - begin);
+	}
+	dynstr_release(s);
+	return copy;
+}
+
+dynstr dynstr_unshare(dynstr s) {
+	if (dynstr_refcount(s) <= 1) return s;
+	return dynstr_detach(s, 0, dynstr_size(s), dynstr_capacity(s));
+}
+
+/**
+ * Reallocate memory block of a dynamic string for a new capacity (which must not be less than the string size).
+ *
+ * The header type is changed if the current one doesn't fit the new capacity or is wider than needed,
+ * so the character data is moved inside the block. Flags of the type byte and the reference counter are preserved.
+ * The string must not be shared.
+ */
+static dynstr dynstr_realloc(dynstr s, size_t capacity) {
+	unsigned type_byte = dynstr_type_byte(s);
+	if (type_byte & DYNSTR_FLAG_ARENA) {
+		return dynstr_arena_realloc(s, capacity);
+	}
+	unsigned old_type = type_byte & DYNSTR_TYPE_MASK, new_type = dynstr_capacity_type(capacity);
+	size_t old_header_size = dynstr_type_header_size(old_type), new_header_size = dynstr_type_header_size(new_type);
+	size_t size = dynstr_size(s), refcount_size = dynstr_extra_size(s);
+	size_t old_prefix_size = refcount_size + old_header_size, new_prefix_size = refcount_size + new_header_size;
+	char *block = s - old_prefix_size;
+	if (capacity > SIZE_MAX - new_prefix_size - 1) { // Integer overflow
+		free(block);
 		return NULL;
 	}
-	dynstr_header_t *new_header = realloc(header, new_total_size);
-	if (!new_header) {
-		free(header);
+	if (new_prefix_size < old_prefix_size) {
+		memmove(block + new_prefix_size, s, size + 1);
+	}
+	char *new_block = realloc(block, new_prefix_size + capacity + 1);
+	if (!new_block) {
+		free(block);
 		return NULL;
 	}
-	new_header->capacity = capacity;
-	return dynstr_data(new_header);
+	if (new_prefix_size > old_prefix_size) {
+		memmove(new_block + new_prefix_size, new_block + old_prefix_size, size + 1);
+	}
+	s = new_block + new_prefix_size;
+	dynstr_init_header(s, (type_byte & ~DYNSTR_TYPE_MASK) | new_type, size, capacity);
+	return s;
 }
 
-dynstr dynstr_reserve2(dynstr s, size_t capacity) {
+dynstr dynstr_shrink(dynstr s) {
+	// Other references would be invalidated by reallocation of a shared string
+	if (dynstr_size(s) == dynstr_capacity(s) || dynstr_refcount(s) > 1) return s;
+	// Shrinking an arena string which isn't the last allocation would copy it without saving memory
+	if ((dynstr_type_byte(s) & DYNSTR_FLAG_ARENA) && dynstr_block(s) != (*dynstr_arena_ptr(s))->last) return s;
+	return dynstr_realloc(s, dynstr_size(s));
+}
+
+dynstr dynstr_reserve(dynstr s, size_t capacity) {
+	if (dynstr_refcount(s) > 1) {
+		return dynstr_detach(s, 0, dynstr_size(s), capacity > dynstr_capacity(s) ? capacity : dynstr_capacity(s));
+	}
 	if (capacity <= dynstr_capacity(s)) return s;
+	return dynstr_realloc(s, capacity);
+}
+
+dynstr dynstr_reserve2(dynstr s, size_t capacity) {
+	if (capacity <= dynstr_capacity(s)) return dynstr_unshare(s);
 	roundupsize(capacity);
 	return dynstr_reserve(s, capacity);
 }
@@ -124,15 +381,19 @@ dynstr dynstr_reserve2(dynstr s, size_t capacity) {
 dynstr dynstr_resize(dynstr s, size_t size) {
 	s = dynstr_reserve(s, size);
 	if (s) {
-		dynstr_size(s) = size;
+		dynstr_set_size(s, size);
 		s[size] = '\0';
 	}
 	return s;
 }
 
-void dynstr_clear(dynstr s) {
-	dynstr_size(s) = 0;
+dynstr dynstr_clear(dynstr s) {
+	if (dynstr_refcount(s) > 1) {
+		return dynstr_detach(s, 0, 0, 0);
+	}
+	dynstr_set_size(s, 0);
 	s[0] = '\0';
+	return s;
 }
 
 dynstr dynstr_set_chars(dynstr s, const char *data, size_t count) {
@@ -163,8 +424,10 @@ static inline dynstr dynstr_grow(dynstr s, size_t delta) {
 dynstr dynstr_push(dynstr s, int c) {
 	s = dynstr_grow(s, 1);
 	if (s) {
-		s[dynstr_size(s)++] = (char) c;
-		s[dynstr_size(s)] = '\0';
+		size_t size = dynstr_size(s);
+		s[size] = (char) c;
+		s[size + 1] = '\0';
+		dynstr_set_size(s, size + 1);
 	}
 	return s;
 }
@@ -172,9 +435,10 @@ dynstr dynstr_push(dynstr s, int c) {
 dynstr dynstr_push_chars(dynstr s, const char *chars, size_t count) {
 	s = dynstr_grow(s, count);
 	if (s) {
-		memcpy(s + dynstr_size(s), chars, count);
-		dynstr_size(s) += count;
-		s[dynstr_size(s)] = '\0';
+		size_t size = dynstr_size(s);
+		memcpy(s + size, chars, count);
+		s[size + count] = '\0';
+		dynstr_set_size(s, size + count);
 	}
 	return s;
 }
@@ -196,23 +460,54 @@ dynstr dynstr_printf(dynstr dest, const char *fmt, ...) {
 }
 
 dynstr dynstr_vprintf(dynstr dest, const char *fmt, va_list args) {
+	dest = dynstr_unshare(dest);
+	if (!dest) {
+		return NULL;
+	}
+	// Format directly into spare capacity (or into the stack buffer if it is larger) and format again
+	// only if the result doesn't fit
+	char buffer[DYNSTR_PRINTF_BUFFER_SIZE];
+	size_t size = dynstr_size(dest), spare = dynstr_capacity(dest) - size;
+	bool use_buffer = spare < sizeof(buffer) - 1;
 	va_list args_copy;
 	va_copy(args_copy, args);
-	int count = vsnprintf(NULL, 0, fmt, args_copy);
+	int count = vsnprintf(use_buffer ? buffer : dest + size, use_buffer ? sizeof(buffer) : spare + 1, fmt, args_copy);
 	va_end(args_copy);
-	if (count >= 0) {
+	if (count < 0) {
+		dest[size] = '\0';
+		return dynstr_append(dest, fmt);
+	}
+	if (use_buffer && (size_t) count < sizeof(buffer)) {
+		return dynstr_push_chars(dest, buffer, (size_t) count);
+	}
+	if ((size_t) count > spare) {
 		dest = dynstr_grow(dest, (size_t) count);
-		if (dest) {
-			vsnprintf(dest + dynstr_size(dest), (size_t) count + 1, fmt, args);
-			dynstr_size(dest) += (size_t) count;
+		if (!dest) {
+			return NULL;
 		}
-	} else {
-		dest = dynstr_append(dest, fmt);
+		vsnprintf(dest + size, (size_t) count + 1, fmt, args);
 	}
+	dynstr_set_size(dest, size + (size_t) count);
 	return dest;
 }
 
-void dynstr_range(dynstr s, ptrdiff_t start, ptrdiff_t count) {
+/** Keep only characters [\p begin, \p end) of a dynamic string (copying them if the string is shared). */
+static dynstr dynstr_substr(dynstr s, size_t begin, size_t end) {
+	if (end <= begin) {
+		begin = end = 0;
+	}
+	if (dynstr_refcount(s) > 1) {
+		return dynstr_detach(s, begin, end, 0);
+	}
+	if (begin > 0) {
+		memmove(s, s + begin, end - begin);
+	}
+	dynstr_set_size(s, end - begin);
+	s[end - begin] = '\0';
+	return s;
+}
+
+dynstr dynstr_range(dynstr s, ptrdiff_t start, ptrdiff_t count) {
 	size_t begin;
 	if (start >= 0) {
 		begin = (size_t) start;
@@ -240,48 +535,38 @@ void dynstr_range(dynstr s, ptrdiff_t start, ptrdiff_t count) {
 		}
 	}
 	
-	if (begin < end) {
-		if (begin > 0) {
-			memmove(s, s + begin, end - begin);
-		}
-		dynstr_size(s) = end - begin;
-		s[dynstr_size(s)] = '\0';
-	} else {
-		dynstr_clear(s);
-	}
+	return dynstr_substr(s, begin, end);
 }
 
-void dynstr_trim_start(dynstr s, const char *chars) {
-	size_t i = 0;
-	while (i < dynstr_size(s) && strchr(chars, s[i]) != NULL) i++;
-	if (i > 0) {
-		memmove(s, s + i, dynstr_size(s) - i);
-		dynstr_size(s) -= i;
-		s[dynstr_size(s)] = '\0';
-	}
+dynstr dynstr_trim_start(dynstr s, const char *chars) {
+	charset_t set = charset_make(chars);
+	return dynstr_trim_start_charset(s, &set);
 }
 
-void dynstr_trim_end(dynstr s, const char *chars) {
-	size_t j = dynstr_size(s);
-	while (j > 0 && strchr(chars, s[j - 1]) != NULL) j--;
-	dynstr_size(s) = j;
-	s[j] = '\0';
+dynstr dynstr_trim_end(dynstr s, const char *chars) {
+	charset_t set = charset_make(chars);
+	return dynstr_trim_end_charset(s, &set);
 }
 
-void dynstr_trim(dynstr s, const char *chars) {
-	size_t i = 0;
-	while (i < dynstr_size(s) && strchr(chars, s[i]) != NULL) i++;
-	size_t j = dynstr_size(s);
-	while (j > i && strchr(chars, s[j - 1]) != NULL) j--;
-	if (j > i) {
-		if (i > 0) {
-			memmove(s, s + i, j - i);
-		}
-		dynstr_size(s) = j - i;
-		s[dynstr_size(s)] = '\0';
-	} else {
-		dynstr_clear(s);
-	}
+dynstr dynstr_trim(dynstr s, const char *chars) {
+	charset_t set = charset_make(chars);
+	return dynstr_trim_charset(s, &set);
+}
+
+dynstr dynstr_trim_start_charset(dynstr s, const charset_t *set) {
+	size_t i = charset_span(set, s, dynstr_size(s));
+	return i > 0 ? dynstr_substr(s, i, dynstr_size(s)) : s;
+}
+
+dynstr dynstr_trim_end_charset(dynstr s, const charset_t *set) {
+	size_t j = dynstr_size(s) - charset_rspan(set, s, dynstr_size(s));
+	return j < dynstr_size(s) ? dynstr_substr(s, 0, j) : s;
+}
+
+dynstr dynstr_trim_charset(dynstr s, const charset_t *set) {
+	size_t i = charset_span(set, s, dynstr_size(s));
+	size_t j = dynstr_size(s) - charset_rspan(set, s + i, dynstr_size(s) - i);
+	return i > 0 || j < dynstr_size(s) ? dynstr_substr(s, i, j) : s;
 }
 
 int dynstr_cmp(dynstr a, dynstr b) {
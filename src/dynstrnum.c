@@ -0,0 +1,682 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <locale.h>
+#include <CEssentials/bitops.h>
+#include <CEssentials/dynstrnum.h>
+#include "dynstrnum_pow5.h"
+
+static const char str_digit_pairs[201] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+static inline size_t str_count_digits(uint64_t value) {
+	size_t count = 1;
+	for (;;) {
+		if (value < 10) return count;
+		if (value < 100) return count + 1;
+		if (value < 1000) return count + 2;
+		if (value < 10000) return count + 3;
+		value /= 10000;
+		count += 4;
+	}
+}
+
+size_t str_format_u64(char *buffer, uint64_t value) {
+	size_t count = str_count_digits(value);
+	char *p = buffer + count;
+	while (value >= 100) {
+		size_t i = (size_t) (value % 100) * 2;
+		value /= 100;
+		*--p = str_digit_pairs[i + 1];
+		*--p = str_digit_pairs[i];
+	}
+	if (value >= 10) {
+		size_t i = (size_t) value * 2;
+		*--p = str_digit_pairs[i + 1];
+		*--p = str_digit_pairs[i];
+	} else {
+		*--p = (char) ('0' + value);
+	}
+	return count;
+}
+
+size_t str_format_i64(char *buffer, int64_t value) {
+	if (value < 0) {
+		*buffer = '-';
+		return 1 + str_format_u64(buffer + 1, 0 - (uint64_t) value);
+	}
+	return str_format_u64(buffer, (uint64_t) value);
+}
+
+size_t str_format_hex(char *buffer, uint64_t value) {
+	static const char digits[] = "0123456789abcdef";
+	size_t count = value ? (64 - bitops_clz64(value) + 3) / 4 : 1;
+	for (size_t i = count; i > 0; i--) {
+		buffer[i - 1] = digits[value & 15];
+		value >>= 4;
+	}
+	return count;
+}
+
+/*
+ * Grisu2 algorithm by Florian Loitsch ("Printing Floating-Point Numbers Quickly and Accurately with Integers", 2010).
+ * A double is converted into a "do it yourself" floating point number with 64-bit significand, scaled by a cached
+ * power of ten into a range where digits can be generated with integer arithmetic. The produced digits are
+ * always read back to the same double and are the shortest ones in the vast majority of cases.
+ */
+
+typedef struct str_diyfp {
+	uint64_t f;
+	int e;
+} str_diyfp_t;
+
+#define STR_DP_SIGNIFICAND_SIZE 52
+#define STR_DP_EXPONENT_BIAS (0x3FF + STR_DP_SIGNIFICAND_SIZE)
+#define STR_DP_EXPONENT_MASK 0x7FF0000000000000ull
+#define STR_DP_SIGNIFICAND_MASK 0x000FFFFFFFFFFFFFull
+#define STR_DP_HIDDEN_BIT 0x0010000000000000ull
+
+/*
+ * Normalized 64-bit significands and binary exponents of 10^k for k = -348, -340, ..., 340
+ * (10^k rounded to the nearest f * 2^e where 2^63 <= f < 2^64, computed with exact rational arithmetic).
+ */
+static const uint64_t str_cached_powers_f[] = {
+	0xfa8fd5a0081c0288ull, 0xbaaee17fa23ebf76ull, 0x8b16fb203055ac76ull,
+	0xcf42894a5dce35eaull, 0x9a6bb0aa55653b2dull, 0xe61acf033d1a45dfull,
+	0xab70fe17c79ac6caull, 0xff77b1fcbebcdc4full, 0xbe5691ef416bd60cull,
+	0x8dd01fad907ffc3cull, 0xd3515c2831559a83ull, 0x9d71ac8fada6c9b5ull,
+	0xea9c227723ee8bcbull, 0xaecc49914078536dull, 0x823c12795db6ce57ull,
+	0xc21094364dfb5637ull, 0x9096ea6f3848984full, 0xd77485cb25823ac7ull,
+	0xa086cfcd97bf97f4ull, 0xef340a98172aace5ull, 0xb23867fb2a35b28eull,
+	0x84c8d4dfd2c63f3bull, 0xc5dd44271ad3cdbaull, 0x936b9fcebb25c996ull,
+	0xdbac6c247d62a584ull, 0xa3ab66580d5fdaf6ull, 0xf3e2f893dec3f126ull,
+	0xb5b5ada8aaff80b8ull, 0x87625f056c7c4a8bull, 0xc9bcff6034c13053ull,
+	0x964e858c91ba2655ull, 0xdff9772470297ebdull, 0xa6dfbd9fb8e5b88full,
+	0xf8a95fcf88747d94ull, 0xb94470938fa89bcfull, 0x8a08f0f8bf0f156bull,
+	0xcdb02555653131b6ull, 0x993fe2c6d07b7facull, 0xe45c10c42a2b3b06ull,
+	0xaa242499697392d3ull, 0xfd87b5f28300ca0eull, 0xbce5086492111aebull,
+	0x8cbccc096f5088ccull, 0xd1b71758e219652cull, 0x9c40000000000000ull,
+	0xe8d4a51000000000ull, 0xad78ebc5ac620000ull, 0x813f3978f8940984ull,
+	0xc097ce7bc90715b3ull, 0x8f7e32ce7bea5c70ull, 0xd5d238a4abe98068ull,
+	0x9f4f2726179a2245ull, 0xed63a231d4c4fb27ull, 0xb0de65388cc8ada8ull,
+	0x83c7088e1aab65dbull, 0xc45d1df942711d9aull, 0x924d692ca61be758ull,
+	0xda01ee641a708deaull, 0xa26da3999aef774aull, 0xf209787bb47d6b85ull,
+	0xb454e4a179dd1877ull, 0x865b86925b9bc5c2ull, 0xc83553c5c8965d3dull,
+	0x952ab45cfa97a0b3ull, 0xde469fbd99a05fe3ull, 0xa59bc234db398c25ull,
+	0xf6c69a72a3989f5cull, 0xb7dcbf5354e9beceull, 0x88fcf317f22241e2ull,
+	0xcc20ce9bd35c78a5ull, 0x98165af37b2153dfull, 0xe2a0b5dc971f303aull,
+	0xa8d9d1535ce3b396ull, 0xfb9b7cd9a4a7443cull, 0xbb764c4ca7a44410ull,
+	0x8bab8eefb6409c1aull, 0xd01fef10a657842cull, 0x9b10a4e5e9913129ull,
+	0xe7109bfba19c0c9dull, 0xac2820d9623bf429ull, 0x80444b5e7aa7cf85ull,
+	0xbf21e44003acdd2dull, 0x8e679c2f5e44ff8full, 0xd433179d9c8cb841ull,
+	0x9e19db92b4e31ba9ull, 0xeb96bf6ebadf77d9ull, 0xaf87023b9bf0ee6bull
+};
+
+static const int16_t str_cached_powers_e[] = {
+	-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+	-901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+	-582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+	-263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+	56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+	375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+	694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+	1013, 1039, 1066
+};
+
+static inline str_diyfp_t str_diyfp_make(uint64_t f, int e) {
+	str_diyfp_t x = { f, e };
+	return x;
+}
+
+static inline str_diyfp_t str_diyfp_from_bits(uint64_t bits) {
+	int biased_e = (int) ((bits & STR_DP_EXPONENT_MASK) >> STR_DP_SIGNIFICAND_SIZE);
+	uint64_t significand = bits & STR_DP_SIGNIFICAND_MASK;
+	if (biased_e) {
+		return str_diyfp_make(significand + STR_DP_HIDDEN_BIT, biased_e - STR_DP_EXPONENT_BIAS);
+	} else {
+		return str_diyfp_make(significand, 1 - STR_DP_EXPONENT_BIAS); // Subnormal
+	}
+}
+
+static inline str_diyfp_t str_diyfp_normalize(str_diyfp_t x) {
+	unsigned int shift = bitops_clz64(x.f);
+	return str_diyfp_make(x.f << shift, x.e - (int) shift);
+}
+
+/** Upper 64 bits of the product (rounded) */
+static inline str_diyfp_t str_diyfp_mul(str_diyfp_t x, str_diyfp_t y) {
+	uint64_t high, low = bitops_mul128(x.f, y.f, &high);
+	return str_diyfp_make(high + (low >> 63), x.e + y.e + 64);
+}
+
+/** Get cached power of ten 10^-k which brings binary exponent \p e into [-60, -32] range */
+static inline str_diyfp_t str_cached_power(int e, int *k) {
+	double dk = (-61 - e) * 0.30102999566398114 + 347; // 1 / log2(10)
+	int ik = (int) dk;
+	if (dk - ik > 0.0) {
+		ik++;
+	}
+	unsigned int index = (unsigned int) ((ik >> 3) + 1);
+	*k = -(-348 + (int) (index << 3));
+	return str_diyfp_make(str_cached_powers_f[index], str_cached_powers_e[index]);
+}
+
+static inline int str_count_digits32(uint32_t n) {
+	if (n < 10) return 1;
+	if (n < 100) return 2;
+	if (n < 1000) return 3;
+	if (n < 10000) return 4;
+	if (n < 100000) return 5;
+	if (n < 1000000) return 6;
+	if (n < 10000000) return 7;
+	if (n < 100000000) return 8;
+	return n < 1000000000 ? 9 : 10;
+}
+
+/** Move the last digit closer to the exact value while it stays inside the rounding interval */
+static inline void str_grisu_round(char *buffer, int length, uint64_t delta, uint64_t rest, uint64_t ten_kappa,
+		uint64_t wp_w) {
+	while (rest < wp_w && delta - rest >= ten_kappa &&
+			(rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+		buffer[length - 1]--;
+		rest += ten_kappa;
+	}
+}
+
+static void str_grisu_digits(str_diyfp_t w, str_diyfp_t mp, uint64_t delta, char *buffer, int *length, int *k) {
+	static const uint64_t pow10[] = {
+		1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+		1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull,
+		100000000000000ull, 1000000000000000ull, 10000000000000000ull, 100000000000000000ull,
+		1000000000000000000ull, 10000000000000000000ull
+	};
+	str_diyfp_t one = str_diyfp_make(1ull << -mp.e, mp.e);
+	uint64_t wp_w = mp.f - w.f;
+	uint32_t p1 = (uint32_t) (mp.f >> -one.e);
+	uint64_t p2 = mp.f & (one.f - 1);
+	int kappa = str_count_digits32(p1);
+	*length = 0;
+	while (kappa > 0) {
+		uint32_t d = p1 / (uint32_t) pow10[kappa - 1];
+		p1 %= (uint32_t) pow10[kappa - 1];
+		if (d || *length) {
+			buffer[(*length)++] = (char) ('0' + d);
+		}
+		kappa--;
+		uint64_t rest = ((uint64_t) p1 << -one.e) + p2;
+		if (rest <= delta) {
+			*k += kappa;
+			str_grisu_round(buffer, *length, delta, rest, pow10[kappa] << -one.e, wp_w);
+			return;
+		}
+	}
+	for (;;) {
+		p2 *= 10;
+		delta *= 10;
+		char d = (char) (p2 >> -one.e);
+		if (d || *length) {
+			buffer[(*length)++] = (char) ('0' + d);
+		}
+		p2 &= one.f - 1;
+		kappa--;
+		if (p2 < delta) {
+			*k += kappa;
+			int index = -kappa;
+			str_grisu_round(buffer, *length, delta, p2, one.f, wp_w * (index < 20 ? pow10[index] : 0));
+			return;
+		}
+	}
+}
+
+/** Generate digits of a positive finite double, the value is `digits * 10^k` */
+static void str_grisu2(uint64_t bits, char *buffer, int *length, int *k) {
+	str_diyfp_t v = str_diyfp_from_bits(bits);
+	str_diyfp_t plus = str_diyfp_normalize(str_diyfp_make((v.f << 1) + 1, v.e - 1));
+	str_diyfp_t minus = v.f == STR_DP_HIDDEN_BIT ? // The lower boundary is closer for powers of two
+			str_diyfp_make((v.f << 2) - 1, v.e - 2) :
+			str_diyfp_make((v.f << 1) - 1, v.e - 1);
+	minus.f <<= minus.e - plus.e;
+	minus.e = plus.e;
+	
+	str_diyfp_t c_mk = str_cached_power(plus.e, k);
+	str_diyfp_t w = str_diyfp_mul(str_diyfp_normalize(v), c_mk);
+	str_diyfp_t wp = str_diyfp_mul(plus, c_mk);
+	str_diyfp_t wm = str_diyfp_mul(minus, c_mk);
+	wm.f++;
+	wp.f--;
+	str_grisu_digits(w, wp, wp.f - wm.f, buffer, length, k);
+}
+
+static char *str_write_exponent(char *buffer, int k) {
+	if (k < 0) {
+		*buffer++ = '-';
+		k = -k;
+	}
+	if (k >= 100) {
+		*buffer++ = (char) ('0' + k / 100);
+		k %= 100;
+		*buffer++ = str_digit_pairs[k * 2];
+		*buffer++ = str_digit_pairs[k * 2 + 1];
+	} else if (k >= 10) {
+		*buffer++ = str_digit_pairs[k * 2];
+		*buffer++ = str_digit_pairs[k * 2 + 1];
+	} else {
+		*buffer++ = (char) ('0' + k);
+	}
+	return buffer;
+}
+
+/** Place the decimal point or the exponent into generated digits `digits * 10^k` */
+static size_t str_prettify(char *buffer, int length, int k) {
+	int kk = length + k; // 10^(kk - 1) <= value < 10^kk
+	if (k >= 0 && kk <= 21) {
+		// 1234e7 -> 12340000000
+		memset(buffer + length, '0', (size_t) k);
+		return (size_t) kk;
+	} else if (kk > 0 && kk <= 21) {
+		// 1234e-2 -> 12.34
+		memmove(buffer + kk + 1, buffer + kk, (size_t) (length - kk));
+		buffer[kk] = '.';
+		return (size_t) length + 1;
+	} else if (kk > -6 && kk <= 0) {
+		// 1234e-6 -> 0.001234
+		int offset = 2 - kk;
+		memmove(buffer + offset, buffer, (size_t) length);
+		buffer[0] = '0';
+		buffer[1] = '.';
+		memset(buffer + 2, '0', (size_t) (offset - 2));
+		return (size_t) (length + offset);
+	} else if (length == 1) {
+		// 1e30
+		buffer[1] = 'e';
+		return (size_t) (str_write_exponent(buffer + 2, kk - 1) - buffer);
+	} else {
+		// 1234e30 -> 1.234e33
+		memmove(buffer + 2, buffer + 1, (size_t) (length - 1));
+		buffer[1] = '.';
+		buffer[length + 1] = 'e';
+		return (size_t) (str_write_exponent(buffer + length + 2, kk - 1) - buffer);
+	}
+}
+
+size_t str_format_double(char *buffer, double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	if ((bits & STR_DP_EXPONENT_MASK) == STR_DP_EXPONENT_MASK) {
+		if (bits & STR_DP_SIGNIFICAND_MASK) {
+			memcpy(buffer, "nan", 3);
+			return 3;
+		}
+		size_t sign = bits >> 63;
+		memcpy(buffer, "-inf" + 1 - sign, 3 + sign);
+		return 3 + sign;
+	}
+	size_t sign = 0;
+	if (bits >> 63) {
+		*buffer = '-';
+		sign = 1;
+	}
+	if (!(bits & ~(1ull << 63))) {
+		buffer[sign] = '0';
+		return sign + 1;
+	}
+	int length, k;
+	str_grisu2(bits, buffer + sign, &length, &k);
+	return sign + str_prettify(buffer + sign, length, k);
+}
+
+/** Make room for \p count more characters at the end of a dynamic string */
+static inline dynstr dynstr_room(dynstr s, size_t count) {
+	size_t capacity = dynstr_size(s) + count;
+	if (capacity < count) { // Integer overflow
+		dynstr_free(s);
+		return NULL;
+	}
+	return dynstr_reserve2(s, capacity);
+}
+
+#define dynstr_append_formatted(s, max_chars, format_func, value) do { \
+	s = dynstr_room((s), (max_chars)); \
+	if (s) { \
+		size_t size = dynstr_size(s); \
+		size += format_func(s + size, (value)); \
+		s[size] = '\0'; \
+		dynstr_set_size(s, size); \
+	} \
+	return s; \
+} while (0)
+
+dynstr dynstr_append_u64(dynstr s, uint64_t value) {
+	dynstr_append_formatted(s, STR_INT_MAX_CHARS, str_format_u64, value);
+}
+
+dynstr dynstr_append_i64(dynstr s, int64_t value) {
+	dynstr_append_formatted(s, STR_INT_MAX_CHARS, str_format_i64, value);
+}
+
+dynstr dynstr_append_hex(dynstr s, uint64_t value) {
+	dynstr_append_formatted(s, STR_HEX_MAX_CHARS, str_format_hex, value);
+}
+
+dynstr dynstr_append_double(dynstr s, double value) {
+	dynstr_append_formatted(s, STR_DOUBLE_MAX_CHARS, str_format_double, value);
+}
+
+#if defined(BITOPS_LITTLE_ENDIAN)
+/** Check that 8 characters loaded into a little-endian integer are all decimal digits */
+static inline bool str_is_8digits(uint64_t chunk) {
+	return ((chunk & 0xF0F0F0F0F0F0F0F0ull) |
+			(((chunk + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull;
+}
+
+/** Parse 8 decimal digits loaded into a little-endian integer with 3 multiplications instead of 8 */
+static inline uint32_t str_parse_8digits(uint64_t chunk) {
+	const uint64_t mask = 0x000000FF000000FFull;
+	const uint64_t mul1 = 0x000F424000000064ull; // 100 + (1000000 << 32)
+	const uint64_t mul2 = 0x0000271000000001ull; // 1 + (10000 << 32)
+	chunk -= 0x3030303030303030ull;
+	chunk = (chunk * 10) + (chunk >> 8); // Pairs of digits
+	return (uint32_t) ((((chunk & mask) * mul1) + (((chunk >> 16) & mask) * mul2)) >> 32);
+}
+#endif
+
+/** Parse a non-empty sequence of decimal digits */
+static int str_parse_digits(const char *data, size_t count, uint64_t *result) {
+	if (!count) {
+		return STR_PARSE_INVALID;
+	}
+	while (count > 1 && *data == '0') {
+		data++;
+		count--;
+	}
+	if (count > 20) {
+		for (size_t i = 0; i < count; i++) {
+			if ((unsigned char) (data[i] - '0') > 9) {
+				return STR_PARSE_INVALID;
+			}
+		}
+		return STR_PARSE_RANGE;
+	}
+	// The first 19 digits can't overflow
+	size_t limit = count < 19 ? count : 19, i = 0;
+	uint64_t value = 0;
+#if defined(BITOPS_LITTLE_ENDIAN)
+	for (; i + 8 <= limit; i += 8) {
+		uint64_t chunk;
+		memcpy(&chunk, data + i, sizeof(chunk));
+		if (!str_is_8digits(chunk)) {
+			return STR_PARSE_INVALID;
+		}
+		value = value * 100000000 + str_parse_8digits(chunk);
+	}
+#endif
+	for (; i < count; i++) {
+		unsigned int digit = (unsigned char) (data[i] - '0');
+		if (digit > 9) {
+			return STR_PARSE_INVALID;
+		}
+		if (i >= 19 && (value > UINT64_MAX / 10 || (value == UINT64_MAX / 10 && digit > UINT64_MAX % 10))) {
+			return STR_PARSE_RANGE;
+		}
+		value = value * 10 + digit;
+	}
+	*result = value;
+	return STR_PARSE_OK;
+}
+
+int str_to_u64(const char *data, size_t count, uint64_t *result) {
+	if (count && *data == '+') {
+		data++;
+		count--;
+	}
+	int status = str_parse_digits(data, count, result);
+	if (status == STR_PARSE_RANGE) {
+		*result = UINT64_MAX;
+	}
+	return status;
+}
+
+int str_to_i64(const char *data, size_t count, int64_t *result) {
+	bool negative = count && *data == '-';
+	if (count && (*data == '-' || *data == '+')) {
+		data++;
+		count--;
+	}
+	uint64_t magnitude;
+	int status = str_parse_digits(data, count, &magnitude);
+	if (status == STR_PARSE_INVALID) {
+		return status;
+	}
+	if (status == STR_PARSE_RANGE || magnitude > (uint64_t) INT64_MAX + negative) {
+		*result = negative ? INT64_MIN : INT64_MAX;
+		return STR_PARSE_RANGE;
+	}
+	*result = negative ? (int64_t) (0 - magnitude) : (int64_t) magnitude;
+	return STR_PARSE_OK;
+}
+
+/*
+ * Eisel-Lemire algorithm (Daniel Lemire, "Number Parsing at a Gigabyte per Second", 2021).
+ * Converts w * 10^q into the nearest double by multiplying w by a 128-bit approximation of 5^q. The result
+ * is correctly rounded except in rare cases where the approximation isn't precise enough, these are detected
+ * and -1 is returned (the caller falls back to strtod).
+ */
+static int str_eisel_lemire(uint64_t w, int q, uint64_t *bits) {
+	if (w == 0 || q < STR_POW5_MIN_EXPONENT) {
+		*bits = 0;
+		return 0;
+	}
+	if (q > STR_POW5_MAX_EXPONENT) {
+		*bits = STR_DP_EXPONENT_MASK;
+		return 0;
+	}
+	unsigned int lz = bitops_clz64(w);
+	w <<= lz;
+	size_t index = 2 * (size_t) (q - STR_POW5_MIN_EXPONENT);
+	uint64_t high, low = bitops_mul128(w, str_pow5_128[index], &high);
+	const uint64_t precision_mask = UINT64_MAX >> (STR_DP_SIGNIFICAND_SIZE + 3);
+	if ((high & precision_mask) == precision_mask) {
+		// The lower bits are all ones, so they could be affected by the truncated part of 5^q
+		uint64_t second_high;
+		bitops_mul128(w, str_pow5_128[index + 1], &second_high);
+		low += second_high;
+		if (second_high > low) {
+			high++;
+		}
+		if (low == UINT64_MAX && (q < -27 || q > 55)) {
+			return -1;
+		}
+	}
+	unsigned int upper_bit = (unsigned int) (high >> 63);
+	uint64_t mantissa = high >> (upper_bit + 64 - STR_DP_SIGNIFICAND_SIZE - 3);
+	// floor(log2(10^q)) + 63 computed with integers
+	int64_t power2 = (((152170 + 65536) * (int64_t) q) >> 16) + 63 + upper_bit - lz + 1023;
+	if (power2 <= 0) {
+		// Subnormal
+		if (-power2 + 1 >= 64) {
+			*bits = 0;
+			return 0;
+		}
+		mantissa >>= -power2 + 1;
+		mantissa += mantissa & 1;
+		mantissa >>= 1;
+		power2 = mantissa < (1ull << STR_DP_SIGNIFICAND_SIZE) ? 0 : 1;
+		*bits = (mantissa & STR_DP_SIGNIFICAND_MASK) | ((uint64_t) power2 << STR_DP_SIGNIFICAND_SIZE);
+		return 0;
+	}
+	if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 &&
+			(mantissa << (upper_bit + 64 - STR_DP_SIGNIFICAND_SIZE - 3)) == high) {
+		// Exactly halfway between two doubles: round to even
+		mantissa &= ~1ull;
+	}
+	mantissa += mantissa & 1;
+	mantissa >>= 1;
+	if (mantissa >= (2ull << STR_DP_SIGNIFICAND_SIZE)) {
+		mantissa = 1ull << STR_DP_SIGNIFICAND_SIZE;
+		power2++;
+	}
+	if (power2 >= 0x7FF) {
+		*bits = STR_DP_EXPONENT_MASK;
+		return 0;
+	}
+	*bits = (mantissa & STR_DP_SIGNIFICAND_MASK) | ((uint64_t) power2 << STR_DP_SIGNIFICAND_SIZE);
+	return 0;
+}
+
+/** Parse a double with strtod (slow path), the decimal point is replaced by the one of the current locale */
+static double str_strtod(const char *data, size_t count) {
+	char buffer[128];
+	char *copy = count < sizeof(buffer) ? buffer : malloc(count + 1);
+	if (!copy) {
+		return NAN;
+	}
+	char decimal_point = *localeconv()->decimal_point;
+	for (size_t i = 0; i < count; i++) {
+		copy[i] = data[i] == '.' ? decimal_point : data[i];
+	}
+	copy[count] = '\0';
+	double value = strtod(copy, NULL);
+	if (copy != buffer) {
+		free(copy);
+	}
+	return value;
+}
+
+/** Case-insensitive comparison with a lowercase word */
+static inline bool str_is_word(const char *data, size_t count, const char *word) {
+	size_t i = 0;
+	for (; i < count && word[i]; i++) {
+		if ((data[i] | 0x20) != word[i]) {
+			return false;
+		}
+	}
+	return i == count && !word[i];
+}
+
+int str_to_double(const char *data, size_t count, double *result) {
+	const char *p = data, *end = data + count;
+	bool negative = p < end && *p == '-';
+	if (p < end && (*p == '-' || *p == '+')) {
+		p++;
+	}
+	if (str_is_word(p, (size_t) (end - p), "inf") || str_is_word(p, (size_t) (end - p), "infinity")) {
+		*result = negative ? -INFINITY : INFINITY;
+		return STR_PARSE_OK;
+	}
+	if (str_is_word(p, (size_t) (end - p), "nan")) {
+		*result = NAN;
+		return STR_PARSE_OK;
+	}
+	
+	// Collect up to 19 significant digits into w, the value is w * 10^q
+	uint64_t w = 0;
+	int64_t q = 0;
+	size_t digits = 0, significant = 0;
+	bool truncated = false;
+	for (; p < end && (unsigned char) (*p - '0') <= 9; p++, digits++) {
+		if (significant < 19) {
+			w = w * 10 + (uint64_t) (*p - '0');
+			significant += w != 0;
+		} else {
+			truncated |= *p != '0';
+			q++;
+		}
+	}
+	if (p < end && *p == '.') {
+		p++;
+#if defined(BITOPS_LITTLE_ENDIAN)
+		while (end - p >= 8 && significant + 8 <= 19) {
+			uint64_t chunk;
+			memcpy(&chunk, p, sizeof(chunk));
+			if (!str_is_8digits(chunk)) {
+				break;
+			}
+			w = w * 100000000 + str_parse_8digits(chunk);
+			significant = w ? str_count_digits(w) : 0;
+			q -= 8;
+			p += 8;
+			digits += 8;
+		}
+#endif
+		for (; p < end && (unsigned char) (*p - '0') <= 9; p++, digits++) {
+			if (significant < 19) {
+				w = w * 10 + (uint64_t) (*p - '0');
+				significant += w != 0;
+				q--;
+			} else {
+				truncated |= *p != '0';
+			}
+		}
+	}
+	if (!digits) {
+		return STR_PARSE_INVALID;
+	}
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		p++;
+		bool negative_exponent = p < end && *p == '-';
+		if (p < end && (*p == '-' || *p == '+')) {
+			p++;
+		}
+		if (p == end) {
+			return STR_PARSE_INVALID;
+		}
+		int64_t exponent = 0;
+		for (; p < end && (unsigned char) (*p - '0') <= 9; p++) {
+			if (exponent < 100000) { // Large enough to overflow or underflow any double
+				exponent = exponent * 10 + (*p - '0');
+			}
+		}
+		q += negative_exponent ? -exponent : exponent;
+	}
+	if (p != end) {
+		return STR_PARSE_INVALID;
+	}
+	
+	double value;
+#if FLT_EVAL_METHOD == 0
+	static const double pow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	if (!truncated && w <= (1ull << 53) && q >= -22 && q <= 22) {
+		// Both w and 10^|q| are exact doubles, so a single operation is correctly rounded (Clinger's fast path)
+		value = q < 0 ? (double) w / pow10[-q] : (double) w * pow10[q];
+		*result = negative ? -value : value;
+		return STR_PARSE_OK;
+	}
+#endif
+	uint64_t bits;
+	q = q < INT32_MIN ? INT32_MIN : q > INT32_MAX ? INT32_MAX : q;
+	if (str_eisel_lemire(w, (int) q, &bits) == 0) {
+		uint64_t upper_bits;
+		// Truncated digits can't change the result if w + 1 gives the same double
+		if (!truncated || (str_eisel_lemire(w + 1, (int) q, &upper_bits) == 0 && upper_bits == bits)) {
+			memcpy(&value, &bits, sizeof(value));
+			*result = negative ? -value : value;
+			return bits == STR_DP_EXPONENT_MASK ? STR_PARSE_RANGE : STR_PARSE_OK;
+		}
+	}
+	value = str_strtod(data, count);
+	*result = value;
+	return isinf(value) ? STR_PARSE_RANGE : STR_PARSE_OK;
+}
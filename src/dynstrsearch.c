@@ -0,0 +1,300 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <CEssentials/bitops.h>
+#include <CEssentials/dynstrsearch.h>
+
+/*
+ * Two-Way string matching (Crochemore and Perrin, 1991), used when the first/last character filter degrades.
+ * It splits the needle at a critical factorization and never compares a haystack character more than twice,
+ * so it's linear in the worst case and needs only constant memory. The same code searches backwards (for
+ * str_rfind()) by reading both strings through an accessor which mirrors indices, then the index of the match
+ * in the mirrored haystack is converted back.
+ */
+#define STR_FORWARD_AT(p, count, i) ((unsigned char) (p)[i])
+#define STR_BACKWARD_AT(p, count, i) ((unsigned char) (p)[(count) - 1 - (i)])
+
+#define STR_TWO_WAY(name, at) \
+	static size_t name##_maximal_suffix(const char *needle, size_t needle_count, bool reverse, size_t *period) { \
+		size_t suffix = SIZE_MAX, j = 0, k = 1, p = 1; \
+		while (j + k < needle_count) { \
+			unsigned char a = at(needle, needle_count, j + k), b = at(needle, needle_count, suffix + k); \
+			if (reverse ? a > b : a < b) { \
+				j += k; \
+				k = 1; \
+				p = j - suffix; \
+			} else if (a == b) { \
+				if (k != p) { \
+					k++; \
+				} else { \
+					j += p; \
+					k = 1; \
+				} \
+			} else { \
+				suffix = j++; \
+				k = p = 1; \
+			} \
+		} \
+		*period = p; \
+		return suffix; \
+	} \
+	\
+	static size_t name(const char *data, size_t count, const char *needle, size_t needle_count) { \
+		size_t period, reverse_period; \
+		size_t suffix = name##_maximal_suffix(needle, needle_count, false, &period); \
+		size_t reverse_suffix = name##_maximal_suffix(needle, needle_count, true, &reverse_period); \
+		if (reverse_suffix + 1 >= suffix + 1) { \
+			suffix = reverse_suffix; \
+			period = reverse_period; \
+		} \
+		suffix++; /* Length of the left part of the critical factorization */ \
+		bool periodic = true; \
+		for (size_t i = 0; i < suffix && periodic; i++) { \
+			periodic = at(needle, needle_count, i) == at(needle, needle_count, i + period); \
+		} \
+		size_t memory = 0, j = 0; \
+		if (!periodic) { \
+			period = (suffix > needle_count - suffix ? suffix : needle_count - suffix) + 1; \
+		} \
+		while (j <= count - needle_count) { \
+			/* Match the right part, then the left part (skipping the prefix known to match for periodic needles) */ \
+			size_t i = suffix > memory ? suffix : memory; \
+			while (i < needle_count && at(needle, needle_count, i) == at(data, count, i + j)) { \
+				i++; \
+			} \
+			if (i < needle_count) { \
+				j += i - suffix + 1; \
+				memory = 0; \
+				continue; \
+			} \
+			i = suffix; \
+			while (i > memory && at(needle, needle_count, i - 1) == at(data, count, i - 1 + j)) { \
+				i--; \
+			} \
+			if (i <= memory) { \
+				return j; \
+			} \
+			j += period; \
+			memory = periodic ? needle_count - period : 0; \
+		} \
+		return STR_NPOS; \
+	}
+
+STR_TWO_WAY(str_two_way_forward, STR_FORWARD_AT)
+STR_TWO_WAY(str_two_way_backward, STR_BACKWARD_AT)
+
+/*
+ * Candidate verification costs up to needle_count comparisons, the filter gives up when the total cost
+ * of failed verifications exceeds a few comparisons per scanned position.
+ */
+#define STR_FILTER_BUDGET(scanned) (4 * (scanned) + 1024)
+
+#if defined(BITOPS_SSE2)
+/**
+ * Get a bit mask of positions in a block of 16 candidates where the first, the second and the last characters
+ * match the needle (only the first and the last ones are compared for a needle of a single character).
+ */
+static inline unsigned int str_filter_block(const char *block, size_t needle_count,
+		__m128i first_pattern, __m128i second_pattern, __m128i last_pattern) {
+	size_t second_offset = needle_count > 1 ? 1 : 0;
+	__m128i first_chunk = _mm_loadu_si128((const __m128i*) block);
+	__m128i second_chunk = _mm_loadu_si128((const __m128i*) (block + second_offset));
+	__m128i last_chunk = _mm_loadu_si128((const __m128i*) (block + needle_count - 1));
+	__m128i matches = _mm_and_si128(_mm_cmpeq_epi8(first_chunk, first_pattern),
+		_mm_and_si128(_mm_cmpeq_epi8(second_chunk, second_pattern), _mm_cmpeq_epi8(last_chunk, last_pattern)));
+	return (unsigned int) _mm_movemask_epi8(matches);
+}
+#endif
+
+/** Compare characters of a candidate between the first and the last ones (which are already known to match) */
+static inline bool str_match_middle(const char *candidate, const char *middle, size_t middle_count) {
+	// Most false candidates differ in the second character, checking it inline avoids a memcmp call
+	return middle_count == 0 || (candidate[1] == middle[0] && memcmp(candidate + 1, middle, middle_count) == 0);
+}
+
+size_t str_find(const char *data, size_t count, const char *needle, size_t needle_count) {
+	if (needle_count == 0) {
+		return 0;
+	}
+	if (needle_count > count) {
+		return STR_NPOS;
+	}
+	if (needle_count == 1) {
+		const char *p = memchr(data, needle[0], count);
+		return p ? (size_t) (p - data) : STR_NPOS;
+	}
+	size_t last = count - needle_count, i = 0, cost = 0;
+	const char *middle = needle + 1;
+	size_t middle_count = needle_count - 2;
+#if defined(BITOPS_SSE2)
+	__m128i first_pattern = _mm_set1_epi8(needle[0]), second_pattern = _mm_set1_epi8(needle[1]);
+	__m128i last_pattern = _mm_set1_epi8(needle[needle_count - 1]);
+	for (; i + 16 <= last + 1; i += 16) {
+		unsigned int mask = str_filter_block(data + i, needle_count, first_pattern, second_pattern, last_pattern);
+		if (!mask) {
+			continue;
+		}
+		do {
+			size_t index = i + bitops_ctz32(mask);
+			if (str_match_middle(data + index, middle, middle_count)) {
+				return index;
+			}
+			mask &= mask - 1;
+			cost += middle_count;
+		} while (mask);
+		if (cost > STR_FILTER_BUDGET(i)) {
+			break;
+		}
+	}
+#endif
+	while (i <= last && cost <= STR_FILTER_BUDGET(i)) {
+		const char *p = memchr(data + i, needle[0], last - i + 1);
+		if (!p) {
+			return STR_NPOS;
+		}
+		i = (size_t) (p - data);
+		if (data[i + needle_count - 1] == needle[needle_count - 1]) {
+			if (str_match_middle(data + i, middle, middle_count)) {
+				return i;
+			}
+			cost += middle_count;
+		}
+		i++;
+	}
+	if (i > last) {
+		return STR_NPOS;
+	}
+	size_t index = str_two_way_forward(data + i, count - i, needle, needle_count);
+	return index == STR_NPOS ? STR_NPOS : i + index;
+}
+
+size_t str_rfind(const char *data, size_t count, const char *needle, size_t needle_count) {
+	if (needle_count > count) {
+		return STR_NPOS;
+	}
+	if (needle_count == 0) {
+		return count;
+	}
+	// Candidates are checked from the end, end is one past the last unchecked position
+	size_t end = count - needle_count + 1, cost = 0;
+	const char *middle = needle + 1;
+	size_t middle_count = needle_count - (needle_count > 1 ? 2 : 1);
+#if defined(BITOPS_SSE2)
+	__m128i first_pattern = _mm_set1_epi8(needle[0]), last_pattern = _mm_set1_epi8(needle[needle_count - 1]);
+	__m128i second_pattern = needle_count > 1 ? _mm_set1_epi8(needle[1]) : last_pattern;
+	for (; end >= 16; end -= 16) {
+		const char *block = data + end - 16;
+		unsigned int mask = str_filter_block(block, needle_count, first_pattern, second_pattern, last_pattern);
+		if (!mask) {
+			continue;
+		}
+		while (mask) {
+			unsigned int bit = 63 - bitops_clz64(mask);
+			if (str_match_middle(block + bit, middle, middle_count)) {
+				return end - 16 + bit;
+			}
+			mask &= ~(1u << bit);
+			cost += middle_count;
+		}
+		if (cost > STR_FILTER_BUDGET(count - end)) {
+			break;
+		}
+	}
+#endif
+	for (; end > 0 && cost <= STR_FILTER_BUDGET(count - end); end--) {
+		const char *p = data + end - 1;
+		if (p[0] == needle[0] && p[needle_count - 1] == needle[needle_count - 1]) {
+			if (str_match_middle(p, middle, middle_count)) {
+				return end - 1;
+			}
+			cost += middle_count;
+		}
+	}
+	if (end == 0) {
+		return STR_NPOS;
+	}
+	// Search the remaining prefix (including the needle which may start at end - 1)
+	size_t index = str_two_way_backward(data, end - 1 + needle_count, needle, needle_count);
+	return index == STR_NPOS ? STR_NPOS : end - 1 - index;
+}
+
+size_t str_count(const char *data, size_t count, const char *needle, size_t needle_count) {
+	if (needle_count == 0) {
+		return 0;
+	}
+	size_t result = 0, i = 0, index;
+	while ((index = str_find(data + i, count - i, needle, needle_count)) != STR_NPOS) {
+		result++;
+		i += index + needle_count;
+	}
+	return result;
+}
+
+dynstr dynstr_replace_all_chars(dynstr s, const char *from, size_t from_count, const char *to, size_t to_count) {
+	size_t size = dynstr_size(s), matches = str_count(s, size, from, from_count);
+	if (matches == 0) {
+		return s;
+	}
+	if (to_count <= from_count) {
+		// The result isn't longer, so it's written over the original characters which were already searched
+		s = dynstr_unshare(s);
+		if (!s) {
+			return NULL;
+		}
+		size_t read = 0, write = 0, index;
+		while ((index = str_find(s + read, size - read, from, from_count)) != STR_NPOS) {
+			memmove(s + write, s + read, index);
+			write += index;
+			memcpy(s + write, to, to_count);
+			write += to_count;
+			read += index + from_count;
+		}
+		memmove(s + write, s + read, size - read);
+		write += size - read;
+		dynstr_set_size(s, write);
+		s[write] = '\0';
+		return s;
+	}
+	size_t delta = to_count - from_count;
+	if (matches > (SIZE_MAX - size) / delta) { // Integer overflow
+		dynstr_free(s);
+		return NULL;
+	}
+	dynstr_arena_t *arena = dynstr_arena_of(s);
+	dynstr result = arena ? dynstr_arena_alloc(arena, size + matches * delta) : dynstr_alloc(size + matches * delta);
+	if (result && (dynstr_type_byte(s) & DYNSTR_FLAG_REFCOUNTED)) {
+		result = dynstr_make_refcounted(result);
+	}
+	if (!result) {
+		dynstr_free(s);
+		return NULL;
+	}
+	size_t read = 0, write = 0, index;
+	while ((index = str_find(s + read, size - read, from, from_count)) != STR_NPOS) {
+		memcpy(result + write, s + read, index);
+		write += index;
+		memcpy(result + write, to, to_count);
+		write += to_count;
+		read += index + from_count;
+	}
+	memcpy(result + write, s + read, size - read);
+	write += size - read;
+	dynstr_set_size(result, write);
+	result[write] = '\0';
+	dynstr_free(s);
+	return result;
+}
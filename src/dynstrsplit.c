@@ -39,6 +39,32 @@ bool str_split(const char *s, const char *separator, int max_split, dynstr_list_
 	return true;
 }
 
+bool str_split_any(const char *s, const charset_t *separators, int max_split, dynstr_list_t *result) {
+	size_t count = strlen(s), begin = 0;
+	while (max_split <= 0 || dynvec_size(*result) < (size_t) (max_split - 1)) {
+		size_t end = begin + charset_cspan(separators, s + begin, count - begin);
+		if (end == count) {
+			break;
+		}
+		dynstr sub = dynstr_new_chars(s + begin, end - begin);
+		if (!sub) {
+			return false;
+		}
+		if (!dynvec_push(*result, dynstr, sub)) {
+			return false;
+		}
+		begin = end + 1;
+	}
+	dynstr sub = dynstr_new_chars(s + begin, count - begin);
+	if (!sub) {
+		return false;
+	}
+	if (!dynvec_push(*result, dynstr, sub)) {
+		return false;
+	}
+	return true;
+}
+
 dynstr dynstr_list_join(dynstr dest, dynstr_list_t *list, const char *separator) {
 	return dynstr_join(dest, dynvec_size(*list), &dynvec_at(*list, 0), separator);
 }
@@ -0,0 +1,531 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <CEssentials/bitops.h>
+#include <CEssentials/hamt.h>
+
+struct hamt_node {
+	uint32_t refcount;
+	uint32_t capacity; // Number of allocated slots
+	uint32_t datamap; // Bitmap of entries (number of entries for collision nodes)
+	uint32_t nodemap; // Bitmap of child nodes (always 0 for collision nodes)
+	void *slots[]; // Entries (key and value) followed by child nodes
+};
+
+// The deepest nodes hold entries with equal hashes in an unordered array
+#define hamt_is_collision(shift) ((shift) >= HAMT_HASH_BITS)
+
+#define hamt_fragment(hash, shift) ((uint32_t) ((hash) >> (shift)) & ((1u << HAMT_BITS) - 1))
+
+static inline uint32_t hamt_entry_count(const hamt_node_t *node, unsigned int shift) {
+	return hamt_is_collision(shift) ? node->datamap : bitops_popcount32(node->datamap);
+}
+
+static hamt_node_t *hamt_node_alloc(hamt_pool_t *pool, uint32_t capacity) {
+	size_t size = sizeof(hamt_node_t) + capacity * sizeof(void*);
+	hamt_node_t *node;
+	if (pool && capacity < HAMT_POOL_CLASSES) {
+		if (pool->free_lists[capacity]) {
+			node = pool->free_lists[capacity];
+			memcpy(&pool->free_lists[capacity], node, sizeof(void*));
+		} else {
+			if (pool->chunk_left < size) {
+				void **chunk = malloc(sizeof(void*) + HAMT_POOL_CHUNK_SIZE);
+				if (!chunk) {
+					return NULL;
+				}
+				*chunk = pool->chunks;
+				pool->chunks = chunk;
+				pool->chunk_ptr = (char*) (chunk + 1);
+				pool->chunk_left = HAMT_POOL_CHUNK_SIZE;
+			}
+			node = (hamt_node_t*) pool->chunk_ptr;
+			pool->chunk_ptr += size;
+			pool->chunk_left -= size;
+		}
+	} else {
+		node = malloc(size);
+		if (!node) {
+			return NULL;
+		}
+	}
+	node->refcount = 1;
+	node->capacity = capacity;
+	node->datamap = 0;
+	node->nodemap = 0;
+	return node;
+}
+
+static void hamt_node_free(hamt_pool_t *pool, hamt_node_t *node) {
+	uint32_t capacity = node->capacity;
+	if (pool && capacity < HAMT_POOL_CLASSES) {
+		memcpy(node, &pool->free_lists[capacity], sizeof(void*));
+		pool->free_lists[capacity] = node;
+	} else {
+		free(node);
+	}
+}
+
+static void hamt_node_release(hamt_pool_t *pool, hamt_node_t *node) {
+	if (--node->refcount) return;
+	// Collision nodes have no children, so their datamap doesn't matter here
+	uint32_t first = 2 * bitops_popcount32(node->datamap);
+	uint32_t children = bitops_popcount32(node->nodemap);
+	for (uint32_t i = 0; i < children; i++) {
+		hamt_node_release(pool, node->slots[first + i]);
+	}
+	hamt_node_free(pool, node);
+}
+
+// Return a node which can be modified and has at least `capacity` slots: the node itself if it is owned
+// exclusively by the map being modified or its copy (children of the copy are retained)
+static hamt_node_t *hamt_node_writable(hamt_pool_t *pool, hamt_node_t *node, bool owned, unsigned int shift,
+		uint32_t capacity) {
+	if (owned && node->capacity >= capacity) {
+		return node;
+	}
+	uint32_t entries = hamt_entry_count(node, shift);
+	uint32_t children = bitops_popcount32(node->nodemap);
+	uint32_t count = 2 * entries + children;
+	hamt_node_t *copy = hamt_node_alloc(pool, capacity > count ? capacity : count);
+	if (!copy) {
+		return NULL;
+	}
+	copy->datamap = node->datamap;
+	copy->nodemap = node->nodemap;
+	memcpy(copy->slots, node->slots, count * sizeof(void*));
+	for (uint32_t i = 0; i < children; i++) {
+		((hamt_node_t*) copy->slots[2 * entries + i])->refcount++;
+	}
+	return copy;
+}
+
+static inline void hamt_slots_insert(hamt_node_t *node, uint32_t count, uint32_t pos, uint32_t n) {
+	memmove(&node->slots[pos + n], &node->slots[pos], (count - pos) * sizeof(void*));
+}
+
+static inline void hamt_slots_remove(hamt_node_t *node, uint32_t count, uint32_t pos, uint32_t n) {
+	memmove(&node->slots[pos], &node->slots[pos + n], (count - pos - n) * sizeof(void*));
+}
+
+// Create a subtree holding two entries with different keys
+static hamt_node_t *hamt_node_pair(hamt_pool_t *pool, const void *key1, void *value1, size_t hash1,
+		const void *key2, void *value2, size_t hash2, unsigned int shift) {
+	if (hamt_is_collision(shift)) {
+		hamt_node_t *node = hamt_node_alloc(pool, 4);
+		if (!node) {
+			return NULL;
+		}
+		node->datamap = 2;
+		node->slots[0] = (void*) key1;
+		node->slots[1] = value1;
+		node->slots[2] = (void*) key2;
+		node->slots[3] = value2;
+		return node;
+	}
+	uint32_t fragment1 = hamt_fragment(hash1, shift);
+	uint32_t fragment2 = hamt_fragment(hash2, shift);
+	if (fragment1 == fragment2) {
+		hamt_node_t *child = hamt_node_pair(pool, key1, value1, hash1, key2, value2, hash2, shift + HAMT_BITS);
+		if (!child) {
+			return NULL;
+		}
+		hamt_node_t *node = hamt_node_alloc(pool, 1);
+		if (!node) {
+			hamt_node_release(pool, child);
+			return NULL;
+		}
+		node->nodemap = 1u << fragment1;
+		node->slots[0] = child;
+		return node;
+	}
+	hamt_node_t *node = hamt_node_alloc(pool, 4);
+	if (!node) {
+		return NULL;
+	}
+	node->datamap = (1u << fragment1) | (1u << fragment2);
+	uint32_t first = fragment1 < fragment2 ? 0 : 2;
+	node->slots[first] = (void*) key1;
+	node->slots[first + 1] = value1;
+	node->slots[2 - first] = (void*) key2;
+	node->slots[3 - first] = value2;
+	return node;
+}
+
+// Returns the node replacing `node` (the caller must release `node` if it differs)
+// or NULL in case of memory allocation failure (nothing is modified then)
+static hamt_node_t *hamt_node_put(hamt_t *map, hamt_node_t *node, bool owned, size_t hash, unsigned int shift,
+		const void *key, void *value, int *result) {
+	owned = owned && node->refcount == 1;
+	uint32_t entries = hamt_entry_count(node, shift);
+	uint32_t count = 2 * entries + bitops_popcount32(node->nodemap);
+	if (hamt_is_collision(shift)) {
+		for (uint32_t i = 0; i < entries; i++) {
+			if (map->eq(node->slots[2 * i], key)) {
+				hamt_node_t *w = hamt_node_writable(map->pool, node, owned, shift, count);
+				if (!w) {
+					return NULL;
+				}
+				w->slots[2 * i + 1] = value;
+				*result = 0;
+				return w;
+			}
+		}
+		hamt_node_t *w = hamt_node_writable(map->pool, node, owned, shift, count + 2);
+		if (!w) {
+			return NULL;
+		}
+		w->slots[count] = (void*) key;
+		w->slots[count + 1] = value;
+		w->datamap++;
+		*result = 1;
+		return w;
+	}
+	uint32_t bit = 1u << hamt_fragment(hash, shift);
+	if (node->datamap & bit) {
+		uint32_t pos = 2 * bitops_popcount32(node->datamap & (bit - 1));
+		const void *old_key = node->slots[pos];
+		if (map->eq(old_key, key)) {
+			hamt_node_t *w = hamt_node_writable(map->pool, node, owned, shift, count);
+			if (!w) {
+				return NULL;
+			}
+			w->slots[pos + 1] = value;
+			*result = 0;
+			return w;
+		}
+		// Move both entries into a new child node
+		hamt_node_t *child = hamt_node_pair(map->pool, old_key, node->slots[pos + 1], map->hash(old_key),
+				key, value, hash, shift + HAMT_BITS);
+		if (!child) {
+			return NULL;
+		}
+		hamt_node_t *w = hamt_node_writable(map->pool, node, owned, shift, count - 1);
+		if (!w) {
+			hamt_node_release(map->pool, child);
+			return NULL;
+		}
+		uint32_t child_pos = 2 * (entries - 1) + bitops_popcount32(node->nodemap & (bit - 1));
+		hamt_slots_remove(w, count, pos, 2);
+		hamt_slots_insert(w, count - 2, child_pos, 1);
+		w->slots[child_pos] = child;
+		w->datamap &= ~bit;
+		w->nodemap |= bit;
+		*result = 1;
+		return w;
+	}
+	if (node->nodemap & bit) {
+		uint32_t pos = 2 * entries + bitops_popcount32(node->nodemap & (bit - 1));
+		hamt_node_t *child = node->slots[pos];
+		hamt_node_t *new_child = hamt_node_put(map, child, owned, hash, shift + HAMT_BITS, key, value, result);
+		if (!new_child) {
+			return NULL;
+		}
+		if (new_child == child) { // Modified in place
+			return node;
+		}
+		hamt_node_t *w = hamt_node_writable(map->pool, node, owned, shift, count);
+		if (!w) {
+			hamt_node_release(map->pool, new_child);
+			return NULL;
+		}
+		w->slots[pos] = new_child;
+		hamt_node_release(map->pool, child);
+		return w;
+	}
+	hamt_node_t *w = hamt_node_writable(map->pool, node, owned, shift, count + 2);
+	if (!w) {
+		return NULL;
+	}
+	uint32_t pos = 2 * bitops_popcount32(node->datamap & (bit - 1));
+	hamt_slots_insert(w, count, pos, 2);
+	w->slots[pos] = (void*) key;
+	w->slots[pos + 1] = value;
+	w->datamap |= bit;
+	*result = 1;
+	return w;
+}
+
+// Returns the node replacing `node` (the caller must release `node` if it differs)
+// or NULL in case of memory allocation failure (nothing is modified then)
+static hamt_node_t *hamt_node_delete(hamt_t *map, hamt_node_t *node, bool owned, size_t hash, unsigned int shift,
+		const void *key, int *result) {
+	owned = owned && node->refcount == 1;
+	uint32_t entries = hamt_entry_count(node, shift);
+	uint32_t count = 2 * entries + bitops_popcount32(node->nodemap);
+	*result = 0;
+	if (hamt_is_collision(shift)) {
+		for (uint32_t i = 0; i < entries; i++) {
+			if (map->eq(node->slots[2 * i], key)) {
+				hamt_node_t *w = hamt_node_writable(map->pool, node, owned, shift, count);
+				if (!w) {
+					*result = -1;
+					return NULL;
+				}
+				hamt_slots_remove(w, count, 2 * i, 2);
+				w->datamap--;
+				*result = 1;
+				return w;
+			}
+		}
+		return node;
+	}
+	uint32_t bit = 1u << hamt_fragment(hash, shift);
+	if (node->datamap & bit) {
+		uint32_t pos = 2 * bitops_popcount32(node->datamap & (bit - 1));
+		if (!map->eq(node->slots[pos], key)) {
+			return node;
+		}
+		hamt_node_t *w = hamt_node_writable(map->pool, node, owned, shift, count);
+		if (!w) {
+			*result = -1;
+			return NULL;
+		}
+		hamt_slots_remove(w, count, pos, 2);
+		w->datamap &= ~bit;
+		*result = 1;
+		return w;
+	}
+	if (!(node->nodemap & bit)) {
+		return node;
+	}
+	uint32_t pos = 2 * entries + bitops_popcount32(node->nodemap & (bit - 1));
+	hamt_node_t *child = node->slots[pos];
+	hamt_node_t *new_child = hamt_node_delete(map, child, owned, hash, shift + HAMT_BITS, key, result);
+	if (*result <= 0) {
+		return *result ? NULL : node;
+	}
+	if (!new_child->nodemap && hamt_entry_count(new_child, shift + HAMT_BITS) == 1) {
+		// Move the only entry of the child into this node to keep the trie compact
+		hamt_node_t *w = hamt_node_writable(map->pool, node, owned, shift, count + 1);
+		if (w) {
+			uint32_t entry_pos = 2 * bitops_popcount32(node->datamap & (bit - 1));
+			hamt_slots_remove(w, count, pos, 1);
+			hamt_slots_insert(w, count - 1, entry_pos, 2);
+			w->slots[entry_pos] = new_child->slots[0];
+			w->slots[entry_pos + 1] = new_child->slots[1];
+			w->nodemap &= ~bit;
+			w->datamap |= bit;
+			if (new_child != child) {
+				hamt_node_release(map->pool, new_child);
+			}
+			hamt_node_release(map->pool, child);
+			return w;
+		}
+		// Not enough memory to move the entry, keep the child as is
+	}
+	if (new_child == child) { // Modified in place
+		return node;
+	}
+	hamt_node_t *w = hamt_node_writable(map->pool, node, owned, shift, count);
+	if (!w) {
+		hamt_node_release(map->pool, new_child);
+		*result = -1;
+		return NULL;
+	}
+	w->slots[pos] = new_child;
+	hamt_node_release(map->pool, child);
+	return w;
+}
+
+void hamt_pool_init(hamt_pool_t *pool) {
+	for (size_t i = 0; i < HAMT_POOL_CLASSES; i++) {
+		pool->free_lists[i] = NULL;
+	}
+	pool->chunks = NULL;
+	pool->chunk_ptr = NULL;
+	pool->chunk_left = 0;
+}
+
+void hamt_pool_destroy(hamt_pool_t *pool) {
+	void *chunk = pool->chunks;
+	while (chunk) {
+		void *next = *(void**) chunk;
+		free(chunk);
+		chunk = next;
+	}
+	hamt_pool_init(pool);
+}
+
+void hamt_init(hamt_t *map, hamt_hash_func_t hash, hamt_eq_func_t eq, hamt_pool_t *pool) {
+	map->root = NULL;
+	map->size = 0;
+	map->hash = hash;
+	map->eq = eq;
+	map->pool = pool;
+}
+
+void hamt_destroy(hamt_t *map) {
+	if (map->root) {
+		hamt_node_release(map->pool, map->root);
+	}
+	map->root = NULL;
+	map->size = 0;
+}
+
+void hamt_snapshot(const hamt_t *map, hamt_t *snapshot) {
+	*snapshot = *map;
+	if (map->root) {
+		map->root->refcount++;
+	}
+}
+
+bool hamt_get(const hamt_t *map, const void *key, void **value) {
+	const hamt_node_t *node = map->root;
+	if (!node) {
+		return false;
+	}
+	size_t hash = map->hash(key);
+	for (unsigned int shift = 0; ; shift += HAMT_BITS) {
+		if (hamt_is_collision(shift)) {
+			for (uint32_t i = 0; i < node->datamap; i++) {
+				if (map->eq(node->slots[2 * i], key)) {
+					if (value) {
+						*value = node->slots[2 * i + 1];
+					}
+					return true;
+				}
+			}
+			return false;
+		}
+		uint32_t bit = 1u << hamt_fragment(hash, shift);
+		if (node->datamap & bit) {
+			uint32_t pos = 2 * bitops_popcount32(node->datamap & (bit - 1));
+			if (!map->eq(node->slots[pos], key)) {
+				return false;
+			}
+			if (value) {
+				*value = node->slots[pos + 1];
+			}
+			return true;
+		}
+		if (!(node->nodemap & bit)) {
+			return false;
+		}
+		node = node->slots[2 * bitops_popcount32(node->datamap) + bitops_popcount32(node->nodemap & (bit - 1))];
+	}
+}
+
+int hamt_put(hamt_t *map, const void *key, void *value) {
+	size_t hash = map->hash(key);
+	if (!map->root) {
+		hamt_node_t *root = hamt_node_alloc(map->pool, 2);
+		if (!root) {
+			return -1;
+		}
+		root->datamap = 1u << hamt_fragment(hash, 0);
+		root->slots[0] = (void*) key;
+		root->slots[1] = value;
+		map->root = root;
+		map->size = 1;
+		return 1;
+	}
+	int result;
+	hamt_node_t *root = hamt_node_put(map, map->root, true, hash, 0, key, value, &result);
+	if (!root) {
+		return -1;
+	}
+	if (root != map->root) {
+		hamt_node_release(map->pool, map->root);
+		map->root = root;
+	}
+	map->size += (size_t) result;
+	return result;
+}
+
+int hamt_delete(hamt_t *map, const void *key) {
+	if (!map->root) {
+		return 0;
+	}
+	int result;
+	hamt_node_t *root = hamt_node_delete(map, map->root, true, map->hash(key), 0, key, &result);
+	if (result <= 0) {
+		return result;
+	}
+	if (root != map->root) {
+		hamt_node_release(map->pool, map->root);
+		map->root = root;
+	}
+	if (!--map->size) {
+		hamt_node_release(map->pool, map->root);
+		map->root = NULL;
+	}
+	return 1;
+}
+
+void hamt_iter_init(hamt_iter_t *it, const hamt_t *map) {
+	it->depth = map->root ? 0 : -1;
+	it->nodes[0] = map->root;
+	it->positions[0] = 0;
+	it->key = NULL;
+	it->value = NULL;
+}
+
+bool hamt_iter_next(hamt_iter_t *it) {
+	while (it->depth >= 0) {
+		const hamt_node_t *node = it->nodes[it->depth];
+		uint32_t entries = hamt_entry_count(node, (unsigned int) it->depth * HAMT_BITS);
+		uint32_t children = bitops_popcount32(node->nodemap);
+		uint32_t pos = it->positions[it->depth]++;
+		if (pos < entries) {
+			it->key = node->slots[2 * pos];
+			it->value = node->slots[2 * pos + 1];
+			return true;
+		}
+		if (pos < entries + children) {
+			it->depth++;
+			it->nodes[it->depth] = node->slots[entries + pos];
+			it->positions[it->depth] = 0;
+			continue;
+		}
+		it->depth--;
+	}
+	return false;
+}
+
+size_t hamt_str_hash(const void *key) {
+	// FNV-1a
+#if SIZE_MAX > UINT32_MAX
+	size_t hash = (size_t) 14695981039346656037ULL;
+	const size_t prime = (size_t) 1099511628211ULL;
+#else
+	size_t hash = (size_t) 2166136261UL;
+	const size_t prime = (size_t) 16777619UL;
+#endif
+	for (const unsigned char *s = key; *s; s++) {
+		hash ^= *s;
+		hash *= prime;
+	}
+	return hash;
+}
+
+bool hamt_str_eq(const void *a, const void *b) {
+	return strcmp(a, b) == 0;
+}
+
+size_t hamt_ptr_hash(const void *key) {
+	// splitmix64 finalizer
+	uint64_t x = (uint64_t) (uintptr_t) key;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return (size_t) x;
+}
+
+bool hamt_ptr_eq(const void *a, const void *b) {
+	return a == b;
+}
@@ -0,0 +1,199 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <CEssentials/strbuilder.h>
+
+void strbuilder_init(strbuilder_t *b, size_t block_size) {
+	b->head = b->tail = NULL;
+	b->size = 0;
+	b->block_count = 0;
+	b->block_size = block_size ? block_size : STRBUILDER_DEFAULT_BLOCK_SIZE;
+}
+
+void strbuilder_destroy(strbuilder_t *b) {
+	strbuilder_block_t *block = b->head;
+	while (block) {
+		strbuilder_block_t *next = block->next;
+		free(block);
+		block = next;
+	}
+	strbuilder_init(b, b->block_size);
+}
+
+void strbuilder_clear(strbuilder_t *b) {
+	strbuilder_block_t *head = b->head;
+	if (!head) {
+		return;
+	}
+	b->head = head->next;
+	strbuilder_destroy(b);
+	head->next = NULL;
+	head->size = 0;
+	b->head = b->tail = head;
+	b->block_count = 1;
+}
+
+/**
+ * Append a new block with at least \p count free characters.
+ *
+ * Blocks grow with the total size (so their number is logarithmic until they reach STRBUILDER_MAX_BLOCK_SIZE).
+ */
+static strbuilder_block_t *strbuilder_add_block(strbuilder_t *b, size_t count) {
+	size_t capacity = b->size < b->block_size ? b->block_size : b->size;
+	if (capacity > STRBUILDER_MAX_BLOCK_SIZE) {
+		capacity = STRBUILDER_MAX_BLOCK_SIZE > b->block_size ? STRBUILDER_MAX_BLOCK_SIZE : b->block_size;
+	}
+	if (capacity < count) {
+		capacity = count;
+	}
+	if (capacity > SIZE_MAX - sizeof(strbuilder_block_t) - 1) { // Integer overflow
+		return NULL;
+	}
+	strbuilder_block_t *block = malloc(sizeof(strbuilder_block_t) + capacity + 1);
+	if (!block) {
+		return NULL;
+	}
+	block->next = NULL;
+	block->size = 0;
+	block->capacity = capacity;
+	if (b->tail) {
+		b->tail->next = block;
+	} else {
+		b->head = block;
+	}
+	b->tail = block;
+	b->block_count++;
+	return block;
+}
+
+bool strbuilder_push_chars(strbuilder_t *b, const char *data, size_t count) {
+	strbuilder_block_t *block = b->tail;
+	if (block) {
+		size_t chunk = block->capacity - block->size;
+		if (chunk > count) {
+			chunk = count;
+		}
+		if (chunk) {
+			memcpy(block->data + block->size, data, chunk);
+			block->size += chunk;
+			b->size += chunk;
+			data += chunk;
+			count -= chunk;
+		}
+	}
+	if (count) {
+		block = strbuilder_add_block(b, count);
+		if (!block) {
+			return false;
+		}
+		memcpy(block->data, data, count);
+		block->size = count;
+		b->size += count;
+	}
+	return true;
+}
+
+bool strbuilder_append(strbuilder_t *b, const char *s) {
+	return strbuilder_push_chars(b, s, strlen(s));
+}
+
+bool strbuilder_cat(strbuilder_t *b, const char *s) {
+	return strbuilder_push_chars(b, s, dynstr_size(s));
+}
+
+char *strbuilder_reserve(strbuilder_t *b, size_t count) {
+	strbuilder_block_t *block = b->tail;
+	if (!block || block->capacity - block->size < count) {
+		// The slot must be contiguous, the rest of the current block stays unused
+		block = strbuilder_add_block(b, count);
+		if (!block) {
+			return NULL;
+		}
+	}
+	char *slot = block->data + block->size;
+	block->size += count;
+	b->size += count;
+	return slot;
+}
+
+bool strbuilder_printf(strbuilder_t *b, const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	bool result = strbuilder_vprintf(b, fmt, args);
+	va_end(args);
+	return result;
+}
+
+bool strbuilder_vprintf(strbuilder_t *b, const char *fmt, va_list args) {
+	// Format straight into the free part of the last block (there is always room for the NULL character),
+	// rerun only if the result doesn't fit
+	strbuilder_block_t *block = b->tail;
+	char empty[1];
+	size_t spare = block ? block->capacity - block->size : 0;
+	va_list args_copy;
+	va_copy(args_copy, args);
+	int count = vsnprintf(block ? block->data + block->size : empty, spare + 1, fmt, args_copy);
+	va_end(args_copy);
+	if (count <= 0) {
+		return count == 0;
+	}
+	if ((size_t) count <= spare) {
+		block->size += (size_t) count;
+		b->size += (size_t) count;
+		return true;
+	}
+	char *slot = strbuilder_reserve(b, (size_t) count);
+	if (!slot) {
+		return false;
+	}
+	vsnprintf(slot, (size_t) count + 1, fmt, args);
+	return true;
+}
+
+dynstr strbuilder_to_dynstr(const strbuilder_t *b, dynstr dest) {
+	size_t offset = dest ? dynstr_size(dest) : 0;
+	if (dest) {
+		dest = dynstr_resize(dest, offset + b->size);
+	} else {
+		dest = dynstr_new_chars(NULL, b->size);
+	}
+	if (!dest) {
+		return NULL;
+	}
+	for (strbuilder_block_t *block = b->head; block; block = block->next) {
+		memcpy(dest + offset, block->data, block->size);
+		offset += block->size;
+	}
+	dest[offset] = '\0';
+	return dest;
+}
+
+size_t strbuilder_iovec(const strbuilder_t *b, strbuilder_iovec_t *iov, size_t max_count) {
+	size_t count = 0;
+	for (strbuilder_block_t *block = b->head; block; block = block->next) {
+		if (block->size == 0) {
+			continue;
+		}
+		if (count < max_count) {
+			iov[count].iov_base = block->data;
+			iov[count].iov_len = block->size;
+		}
+		count++;
+	}
+	return count;
+}
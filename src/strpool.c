@@ -0,0 +1,152 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <CEssentials/strpool.h>
+
+#define STRPOOL_ALIGN _Alignof(strpool_entry_t)
+
+typedef struct strpool_key {
+	const char *data;
+	size_t count;
+	uint32_t hash;
+} strpool_key_t;
+
+#define strpool_key_eq(a, b) ( \
+	strpool_entry(a)->hash == (b).hash && \
+	dynstr_size(a) == (b).count && \
+	memcmp((a), (b).data, (b).count) == 0 \
+)
+
+static inline uint32_t strpool_chars_hash(const char *data, size_t count) {
+	return (uint32_t) hs_u32_hash((uint32_t) hs_strn_hash(data, count));
+}
+
+void strpool_init(strpool_t *pool) {
+	hs_init(pool->index);
+	dynvec_init(pool->strings);
+	pool->chunks = NULL;
+	pool->chunk_ptr = NULL;
+	pool->chunk_left = 0;
+	pool->memory = 0;
+}
+
+void strpool_destroy(strpool_t *pool) {
+	strpool_chunk_t *chunk = pool->chunks;
+	while (chunk) {
+		strpool_chunk_t *next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+	hs_destroy(pool->index);
+	dynvec_destroy(pool->strings);
+	strpool_init(pool);
+}
+
+static strpool_entry_t *strpool_alloc(strpool_t *pool, size_t count) {
+	if (count > SIZE_MAX - sizeof(strpool_chunk_t) - sizeof(strpool_entry_t) - sizeof(dynstr_header64_t) - STRPOOL_ALIGN) {
+		return NULL;
+	}
+	size_t header_size = dynstr_type_header_size(dynstr_capacity_type(count));
+	size_t size = (sizeof(strpool_entry_t) + header_size + count + 1 + STRPOOL_ALIGN - 1) & ~(STRPOOL_ALIGN - 1);
+	if (size <= pool->chunk_left) {
+		strpool_entry_t *entry = (strpool_entry_t*) pool->chunk_ptr;
+		pool->chunk_ptr += size;
+		pool->chunk_left -= size;
+		return entry;
+	}
+	if (size > STRPOOL_CHUNK_SIZE / 4) {
+		// Large strings get a dedicated chunk, so the current chunk remains in use
+		strpool_chunk_t *chunk = malloc(sizeof(strpool_chunk_t) + size);
+		if (!chunk) {
+			return NULL;
+		}
+		if (pool->chunks) {
+			chunk->next = pool->chunks->next;
+			pool->chunks->next = chunk;
+		} else {
+			chunk->next = NULL;
+			pool->chunks = chunk;
+		}
+		pool->memory += size;
+		return (strpool_entry_t*) (chunk + 1);
+	}
+	strpool_chunk_t *chunk = malloc(sizeof(strpool_chunk_t) + STRPOOL_CHUNK_SIZE);
+	if (!chunk) {
+		return NULL;
+	}
+	chunk->next = pool->chunks;
+	pool->chunks = chunk;
+	pool->chunk_ptr = (char*) (chunk + 1) + size;
+	pool->chunk_left = STRPOOL_CHUNK_SIZE - size;
+	pool->memory += STRPOOL_CHUNK_SIZE;
+	return (strpool_entry_t*) (chunk + 1);
+}
+
+const char *strpool_intern_chars(strpool_t *pool, const char *data, size_t count) {
+	strpool_key_t key = { data, count, strpool_chars_hash(data, count) };
+	size_t index;
+	hs_get_hashed(pool->index, key, key.hash, index, strpool_key_eq);
+	if (hs_valid(pool->index, index)) {
+		return hs_key(pool->index, index);
+	}
+	if (dynvec_size(pool->strings) >= STRPOOL_INVALID_ID) {
+		return NULL;
+	}
+	bool success;
+	hs_ensure_room(pool->index, const char*, success, strpool_hash);
+	if (!success) {
+		return NULL;
+	}
+	if (!dynvec_push(pool->strings, const char*, NULL)) {
+		return NULL;
+	}
+	strpool_entry_t *entry = strpool_alloc(pool, count);
+	if (!entry) {
+		dynvec_size(pool->strings)--;
+		return NULL;
+	}
+	entry->id = (uint32_t) (dynvec_size(pool->strings) - 1);
+	entry->hash = key.hash;
+	char *s = (char*) (entry + 1) + dynstr_type_header_size(dynstr_capacity_type(count));
+	dynstr_init_header(s, dynstr_capacity_type(count), count, count);
+	memcpy(s, data, count);
+	s[count] = '\0';
+	dynvec_at(pool->strings, entry->id) = s;
+	int absent;
+	hs_put_hashed(pool->index, (const char*) s, key.hash, index, absent, strpool_eq);
+	(void) absent;
+	return s;
+}
+
+const char *strpool_intern(strpool_t *pool, const char *s) {
+	return strpool_intern_chars(pool, s, strlen(s));
+}
+
+const char *strpool_intern_dynstr(strpool_t *pool, dynstr s) {
+	return strpool_intern_chars(pool, s, dynstr_size(s));
+}
+
+const char *strpool_find_chars(const strpool_t *pool, const char *data, size_t count) {
+	strpool_key_t key = { data, count, strpool_chars_hash(data, count) };
+	size_t index;
+	hs_get_hashed_nostats(pool->index, key, key.hash, index, strpool_key_eq); // The pool is const, so no statistics
+	return hs_valid(pool->index, index) ? hs_key(pool->index, index) : NULL;
+}
+
+const char *strpool_find(const strpool_t *pool, const char *s) {
+	return strpool_find_chars(pool, s, strlen(s));
+}
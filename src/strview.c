@@ -0,0 +1,165 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#include <string.h>
+#include <CEssentials/strview.h>
+#include <CEssentials/dynstrsearch.h>
+
+dynstr strview_to_dynstr(strview_t v) {
+	return dynstr_new_chars(v.ptr, v.len);
+}
+
+dynstr dynstr_push_view(dynstr s, strview_t v) {
+	return dynstr_push_chars(s, v.ptr, v.len);
+}
+
+strview_t strview_slice(strview_t v, ptrdiff_t start, ptrdiff_t count) {
+	size_t begin;
+	if (start >= 0) {
+		begin = (size_t) start;
+		if (begin > v.len) {
+			begin = v.len;
+		}
+	} else {
+		begin = (size_t) -start;
+		if (begin <= v.len) {
+			begin = v.len - begin;
+		} else {
+			begin = 0;
+		}
+	}
+	
+	size_t end;
+	if (count >= 0) {
+		end = begin + (size_t) count;
+		if (end < begin /* Integer overflow */ || end > v.len) {
+			end = v.len;
+		}
+	} else {
+		end = (size_t) -count;
+		if (end <= v.len) {
+			end = v.len - end;
+		} else {
+			end = 0;
+		}
+	}
+	
+	return begin < end ? strview_make(v.ptr + begin, end - begin) : strview_make(v.ptr + begin, 0);
+}
+
+strview_t strview_trim_start(strview_t v, const char *chars) {
+	charset_t set = charset_make(chars);
+	return strview_trim_start_charset(v, &set);
+}
+
+strview_t strview_trim_end(strview_t v, const char *chars) {
+	charset_t set = charset_make(chars);
+	return strview_trim_end_charset(v, &set);
+}
+
+strview_t strview_trim(strview_t v, const char *chars) {
+	charset_t set = charset_make(chars);
+	return strview_trim_charset(v, &set);
+}
+
+strview_t strview_trim_start_charset(strview_t v, const charset_t *set) {
+	size_t i = charset_span(set, v.ptr, v.len);
+	return strview_make(v.ptr + i, v.len - i);
+}
+
+strview_t strview_trim_end_charset(strview_t v, const charset_t *set) {
+	return strview_make(v.ptr, v.len - charset_rspan(set, v.ptr, v.len));
+}
+
+strview_t strview_trim_charset(strview_t v, const charset_t *set) {
+	return strview_trim_end_charset(strview_trim_start_charset(v, set), set);
+}
+
+int strview_cmp(strview_t a, strview_t b) {
+	size_t min_size = a.len <= b.len ? a.len : b.len;
+	int result = min_size ? memcmp(a.ptr, b.ptr, min_size) : 0;
+	if (result == 0) {
+		if (a.len > b.len) {
+			return 1;
+		} else if (a.len < b.len) {
+			return -1;
+		} else {
+			return 0;
+		}
+	} else {
+		return result;
+	}
+}
+
+size_t strview_find_char(strview_t v, int c) {
+	const char *p = v.len ? memchr(v.ptr, c, v.len) : NULL;
+	return p ? (size_t) (p - v.ptr) : STRVIEW_NPOS;
+}
+
+size_t strview_rfind_char(strview_t v, int c) {
+	size_t i = v.len;
+	while (i > 0) {
+		if (v.ptr[--i] == (char) c) {
+			return i;
+		}
+	}
+	return STRVIEW_NPOS;
+}
+
+size_t strview_find(strview_t v, strview_t needle) {
+	return str_find(v.ptr, v.len, needle.ptr, needle.len);
+}
+
+size_t strview_rfind(strview_t v, strview_t needle) {
+	return str_rfind(v.ptr, v.len, needle.ptr, needle.len);
+}
+
+size_t strview_find_any(strview_t v, const charset_t *set) {
+	size_t index = charset_cspan(set, v.ptr, v.len);
+	return index < v.len ? index : STRVIEW_NPOS;
+}
+
+size_t strview_rfind_any(strview_t v, const charset_t *set) {
+	size_t count = charset_rcspan(set, v.ptr, v.len);
+	return count < v.len ? v.len - count - 1 : STRVIEW_NPOS;
+}
+
+bool strview_split_next(strview_t *rest, strview_t separator, strview_t *token) {
+	if (rest->len == 0) {
+		return false;
+	}
+	size_t index = separator.len ? strview_find(*rest, separator) : STRVIEW_NPOS;
+	if (index == STRVIEW_NPOS) {
+		*token = *rest;
+		*rest = strview_make(rest->ptr + rest->len, 0);
+	} else {
+		*token = strview_make(rest->ptr, index);
+		*rest = strview_make(rest->ptr + index + separator.len, rest->len - index - separator.len);
+	}
+	return true;
+}
+
+bool strview_split_next_any(strview_t *rest, const charset_t *separators, strview_t *token) {
+	if (rest->len == 0) {
+		return false;
+	}
+	size_t index = charset_cspan(separators, rest->ptr, rest->len);
+	*token = strview_make(rest->ptr, index);
+	if (index < rest->len) {
+		index++;
+	}
+	*rest = strview_make(rest->ptr + index, rest->len - index);
+	return true;
+}
@@ -17,17 +17,49 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "test_dynstr.h"
 #include "test_dynvec.h"
 #include "test_dynstrsplit.h"
+#include "test_dynstrhash.h"
+#include "test_dynstrnum.h"
+#include "test_dynstrsearch.h"
+#include "test_strpool.h"
+#include "test_strview.h"
+#include "test_strbuilder.h"
 #include "test_hashtable.h"
 #include "test_hashset.h"
+#include "test_hashtable_stats.h"
+#include "test_orderedhashtable.h"
+#include "test_concurrenthashtable.h"
+#include "test_hamt.h"
+#include "test_flatmap.h"
+#include "test_flatset.h"
+#include "test_intset.h"
+#include "test_cache.h"
 #include "test_qsort.h"
+#include "test_bitops.h"
+#include "test_charset.h"
 
 int main() {
 	test_dynstr();
 	test_dynvec();
 	test_dynstrsplit();
+	test_dynstrhash();
+	test_dynstrnum();
+	test_dynstrsearch();
+	test_strpool();
+	test_strview();
+	test_strbuilder();
 	test_hashtable();
 	test_hashset();
+	test_hashtable_stats();
+	test_orderedhashtable();
+	test_concurrenthashtable();
+	test_hamt();
+	test_flatmap();
+	test_flatset();
+	test_intset();
+	test_cache();
 	test_qsort();
+	test_bitops();
+	test_charset();
 	fflush(stdout);
 	return 0;
 }
@@ -0,0 +1,63 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <CEssentials/bitops.h>
+#include "test_bitops.h"
+
+static void test_bitops_scan(void) {
+	assert(bitops_ctz32(1) == 0);
+	assert(bitops_ctz32(0x80000000u) == 31);
+	assert(bitops_ctz64(0x100000000ull) == 32);
+	assert(bitops_clz64(1) == 63);
+	assert(bitops_clz64(0x8000000000000000ull) == 0);
+	assert(bitops_clz64(0x100000000ull) == 31);
+	assert(bitops_popcount32(0xF0F0u) == 8);
+	assert(bitops_popcount64(0xFFFFFFFFFFFFFFFFull) == 64);
+	uint64_t high;
+	assert(bitops_mul128(0xFFFFFFFFFFFFFFFFull, 0xFFFFFFFFFFFFFFFFull, &high) == 1);
+	assert(high == 0xFFFFFFFFFFFFFFFEull);
+	assert(bitops_mul128(1ull << 32, 1ull << 33, &high) == 0);
+	assert(high == 2);
+}
+
+static void test_bitops_find_byte(void) {
+	char data[100];
+	memset(data, 2, sizeof(data));
+	assert(bitops_find_byte(data, sizeof(data), 0, 1) == sizeof(data));
+	for (size_t i = 0; i < sizeof(data); i++) {
+		data[i] = 1;
+		for (size_t start = 0; start <= i; start++) {
+			assert(bitops_find_byte(data, sizeof(data), start, 1) == i);
+		}
+		assert(bitops_find_byte(data, sizeof(data), i + 1, 1) == sizeof(data));
+		assert(bitops_find_byte(data, i, 0, 1) == i);
+		data[i] = 0;
+	}
+	data[10] = 1;
+	data[90] = 1;
+	assert(bitops_find_byte(data, sizeof(data), 11, 1) == 90);
+}
+
+void test_bitops(void) {
+	test_bitops_scan();
+	test_bitops_find_byte();
+	printf("bitops.h passed all tests!\n");
+}
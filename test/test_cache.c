@@ -0,0 +1,159 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <CEssentials/cache.h>
+#include "test_cache.h"
+
+static int evicted_sum = 0;
+
+#define test_cache_evict(key, value) (evicted_sum += (value))
+
+void test_cache_clock(void) {
+	size_t index = 0;
+	int absent, old = 0;
+	typedef CACHE_ENTRY(int) entry_t;
+	CACHE(uint64_t, entry_t) cache;
+	cache_init(cache, 100);
+	
+	for (int i = 0; i < 1000; i++) {
+		cache_put_u64(cache, entry_t, (uint64_t) i, i, 10, index, absent, old, cache_evict_none);
+		assert(absent == 1);
+		assert(cache_cost(cache) <= 100);
+		// Keep touching the first element, so it should never be evicted
+		cache_get_u64(cache, 0, index);
+		assert(cache_valid(cache, index));
+	}
+	assert(cache_size(cache) == 10);
+	assert(cache_evictions(cache) == 990);
+	cache_get_u64(cache, 999, index);
+	assert(cache_valid(cache, index));
+	assert(cache_hits(cache) == 1001);
+	cache_put_u64(cache, entry_t, 999, -1, 10, index, absent, old, cache_evict_none);
+	assert(absent == 0);
+	assert(old == 999);
+	assert(cache_evictions(cache) == 990);
+	
+	cache_destroy(cache);
+}
+
+#define test_cache_free_owned(key, value) do { free((char*) (key)); free(value); } while (0)
+
+void test_cache_owned_keys(void) {
+	size_t index = 0;
+	int absent;
+	char *old = NULL;
+	typedef CACHE_ENTRY(char*) entry_t;
+	CACHE(const char*, entry_t) cache;
+	cache_init(cache, 10);
+	
+	char *key = strdup("page");
+	cache_put_str(cache, entry_t, key, strdup("v1"), 1, index, absent, old, test_cache_free_owned);
+	assert(absent == 1);
+	
+	// The stored key stays in the table, so the caller frees its own copy and the old value
+	key = strdup("page");
+	cache_put_str(cache, entry_t, key, strdup("v2"), 1, index, absent, old, test_cache_free_owned);
+	assert(absent == 0);
+	assert(cache_key(cache, index) != key);
+	assert(strcmp(old, "v1") == 0);
+	free(old);
+	free(key);
+	assert(cache_evictions(cache) == 0);
+	
+	cache_get_str(cache, "page", index);
+	assert(cache_valid(cache, index));
+	assert(strcmp(cache_value(cache, index), "v2") == 0);
+	
+	// Real evictions still go through the callback
+	for (int i = 0; i < 20; i++) {
+		char name[16];
+		snprintf(name, sizeof(name), "key%i", i);
+		key = strdup(name);
+		cache_put_str(cache, entry_t, key, strdup(name), 1, index, absent, old, test_cache_free_owned);
+		assert(absent == 1);
+		cache_get_str(cache, name, index);
+		assert(cache_valid(cache, index) && strcmp(cache_value(cache, index), name) == 0);
+	}
+	assert(cache_size(cache) == 10);
+	assert(cache_evictions(cache) == 11);
+	
+	cache_for_each(cache, i) {
+		test_cache_free_owned(cache_key(cache, i), cache_value(cache, i));
+	}
+	cache_destroy(cache);
+}
+
+void test_cache(void) {
+	size_t index = 0;
+	int absent, old = 0;
+	typedef CACHE_ENTRY(int) entry_t;
+	CACHE(const char*, entry_t) cache;
+	cache_init(cache, 10);
+	
+	cache_get_str(cache, "a", index);
+	assert(!cache_valid(cache, index));
+	assert(cache_misses(cache) == 1);
+	
+	cache_put_str(cache, entry_t, "a", 1, 4, index, absent, old, test_cache_evict);
+	assert(absent == 1);
+	cache_put_str(cache, entry_t, "b", 2, 4, index, absent, old, test_cache_evict);
+	assert(absent == 1);
+	assert(cache_cost(cache) == 8);
+	
+	cache_get_str(cache, "a", index);
+	assert(cache_valid(cache, index));
+	assert(cache_value(cache, index) == 1);
+	
+	// "b" wasn't referenced, so it goes first
+	cache_put_str(cache, entry_t, "c", 3, 4, index, absent, old, test_cache_evict);
+	assert(absent == 1);
+	assert(evicted_sum == 2);
+	assert(cache_size(cache) == 2);
+	assert(cache_cost(cache) == 8);
+	cache_get_str(cache, "b", index);
+	assert(!cache_valid(cache, index));
+	
+	// Replacement returns the old value instead of evicting it
+	cache_put_str(cache, entry_t, "c", 30, 2, index, absent, old, test_cache_evict);
+	assert(absent == 0);
+	assert(old == 3);
+	assert(evicted_sum == 2);
+	assert(cache_cost(cache) == 6);
+	assert(cache_value(cache, index) == 30);
+	
+	cache_set_max_cost(cache, 2, test_cache_evict);
+	assert(cache_cost(cache) <= 2);
+	assert(cache_size(cache) == 1);
+	
+	int sum = 0;
+	cache_for_each(cache, i) {
+		sum += cache_value(cache, i);
+	}
+	assert(sum == 30);
+	
+	cache_destroy(cache);
+	
+	test_cache_clock();
+	test_cache_owned_keys();
+	
+	printf("cache.h passed all tests!\n");
+}
@@ -0,0 +1,103 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <CEssentials/charset.h>
+#include "test_charset.h"
+
+static void test_charset_basic(void) {
+	charset_t set = charset_make("abc");
+	assert(set.size == 3);
+	assert(charset_contains(&set, 'a') && charset_contains(&set, 'c'));
+	assert(!charset_contains(&set, 'd') && !charset_contains(&set, '\0'));
+	charset_add(&set, 'a');
+	assert(set.size == 3);
+	charset_add(&set, '\0');
+	charset_add(&set, (char) 0xFF);
+	assert(set.size == 5 && charset_contains(&set, '\0') && charset_contains(&set, (char) 0xFF));
+	
+	charset_invert(&set);
+	assert(set.size == 251);
+	assert(!charset_contains(&set, 'a') && charset_contains(&set, 'd') && !charset_contains(&set, '\0'));
+	
+	charset_t digits = charset_empty();
+	charset_add_range(&digits, '0', '9');
+	assert(digits.size == 10);
+	charset_t all = charset_empty();
+	charset_add_range(&all, '\0', (char) 0xFF);
+	assert(all.size == 256);
+	charset_invert(&all);
+	assert(all.size == 0);
+	charset_invert(&digits);
+	charset_invert(&digits);
+	assert(digits.size == 10 && charset_contains(&digits, '5') && !charset_contains(&digits, 'a'));
+	
+	const char *s = "  \t hello world \t ";
+	charset_t blank = charset_make(" \t");
+	assert(charset_span(&blank, s, strlen(s)) == 4);
+	assert(charset_cspan(&blank, s + 4, strlen(s) - 4) == 5);
+	assert(charset_rspan(&blank, s, strlen(s)) == 3);
+	assert(charset_rcspan(&blank, s, strlen(s) - 3) == 5);
+	assert(charset_span(&blank, s, 0) == 0 && charset_cspan(&blank, s, 0) == 0);
+	charset_t empty = charset_empty();
+	assert(charset_span(&empty, s, strlen(s)) == 0 && charset_cspan(&empty, s, strlen(s)) == strlen(s));
+	assert(charset_rspan(&empty, s, strlen(s)) == 0 && charset_rcspan(&empty, s, strlen(s)) == strlen(s));
+}
+
+static void test_charset_random(void) {
+	char data[200];
+	srand(777);
+	for (int k = 0; k < 20000; k++) {
+		// Sets of different sizes are scanned by different code paths (SIMD for small ones)
+		charset_t set = charset_empty();
+		int set_size = rand() % 12;
+		for (int i = 0; i < set_size; i++) {
+			charset_add(&set, (char) (rand() % 16 * 17));
+		}
+		if (rand() % 4 == 0) {
+			charset_invert(&set);
+		}
+		size_t count = (size_t) rand() % sizeof(data);
+		for (size_t i = 0; i < count; i++) {
+			data[i] = (char) (rand() % 16 * 17);
+		}
+		// Long runs of members and non-members
+		size_t run = (size_t) rand() % (count + 1);
+		char filler = (char) (rand() % 16 * 17);
+		memset(rand() % 2 ? data : data + count - run, filler, run);
+		
+		size_t span = 0, cspan = 0, rspan = 0, rcspan = 0;
+		while (span < count && charset_contains(&set, data[span])) span++;
+		while (cspan < count && !charset_contains(&set, data[cspan])) cspan++;
+		while (rspan < count && charset_contains(&set, data[count - rspan - 1])) rspan++;
+		while (rcspan < count && !charset_contains(&set, data[count - rcspan - 1])) rcspan++;
+		assert(charset_span(&set, data, count) == span);
+		assert(charset_cspan(&set, data, count) == cspan);
+		assert(charset_rspan(&set, data, count) == rspan);
+		assert(charset_rcspan(&set, data, count) == rcspan);
+	}
+}
+
+void test_charset(void) {
+	test_charset_basic();
+	test_charset_random();
+	printf("charset.h passed all tests!\n");
+}
@@ -0,0 +1,138 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <CEssentials/concurrenthashtable.h>
+#include "test_concurrenthashtable.h"
+
+static void test_concurrenthashtable_basic(void) {
+	int absent;
+	bool found, deleted;
+	int value;
+	CHT(const char*, int) ht;
+	cht_init(ht);
+	
+	int reader = cht_register_reader(ht);
+	assert(reader >= 0);
+	
+	cht_get_str(ht, int, reader, "10", value, found);
+	assert(!found);
+	
+	cht_put_str(ht, int, "10", 10, absent);
+	assert(absent == 1);
+	cht_put_str(ht, int, "20", 20, absent);
+	assert(absent == 1);
+	cht_put_str(ht, int, "10", 11, absent);
+	assert(absent == 0);
+	assert(cht_size(ht) == 2);
+	
+	cht_get_str(ht, int, reader, "10", value, found);
+	assert(found);
+	assert(value == 11);
+	
+	cht_delete_str(ht, "20", deleted);
+	assert(deleted);
+	cht_delete_str(ht, "20", deleted);
+	assert(!deleted);
+	cht_get_str(ht, int, reader, "20", value, found);
+	assert(!found);
+	assert(cht_size(ht) == 1);
+	
+	// Updates and deletions consume slots until the next rehash
+	for (int i = 0; i < 1000; i++) {
+		cht_put_str(ht, int, "10", i, absent);
+		assert(absent == 0);
+	}
+	assert(cht_capacity(ht) <= 8);
+	cht_get_str(ht, int, reader, "10", value, found);
+	assert(found);
+	assert(value == 999);
+	
+	// Replaced arrays are freed when no reader is in a lookup
+	assert(cht_collect(ht));
+	
+	int second = cht_register_reader(ht);
+	assert(second >= 0 && second != reader);
+	cht_unregister_reader(ht, second);
+	cht_unregister_reader(ht, reader);
+	
+	cht_destroy(ht);
+}
+
+static void test_concurrenthashtable_readers(void) {
+	CHT(int, int) ht;
+	cht_init(ht);
+	int failures = 0;
+	
+	#pragma omp parallel num_threads(4) reduction(+:failures)
+	{
+		int reader = cht_register_reader(ht);
+		assert(reader >= 0);
+		#pragma omp barrier
+		#pragma omp master
+		{
+			int absent;
+			bool deleted;
+			for (int i = 0; i < 20000; i++) {
+				cht_put_int(ht, int, i, i * 2, absent);
+				assert(absent == 1);
+				if (i % 3 == 0) {
+					cht_put_int(ht, int, i, i * 2, absent); // Same value, readers must always see it
+					assert(absent == 0);
+				}
+				if (i % 5 == 0) {
+					cht_delete_int(ht, i, deleted);
+					assert(deleted);
+				}
+			}
+		}
+		for (int i = 0; i < 20000; i++) {
+			int value;
+			bool found;
+			cht_get_int(ht, int, reader, i, value, found);
+			if (found && value != i * 2) {
+				failures++;
+			}
+		}
+		cht_unregister_reader(ht, reader);
+	}
+	assert(!failures);
+	
+	int reader = cht_register_reader(ht);
+	for (int i = 0; i < 20000; i++) {
+		int value;
+		bool found;
+		cht_get_int(ht, int, reader, i, value, found);
+		assert(found == (i % 5 != 0));
+		if (found) {
+			assert(value == i * 2);
+		}
+	}
+	cht_unregister_reader(ht, reader);
+	assert(cht_size(ht) == 16000);
+	assert(cht_collect(ht));
+	
+	cht_destroy(ht);
+}
+
+void test_concurrenthashtable(void) {
+	test_concurrenthashtable_basic();
+	test_concurrenthashtable_readers();
+	printf("concurrenthashtable.h passed all tests!\n");
+}
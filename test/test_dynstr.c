@@ -55,6 +55,156 @@ static void test_dynstr_shrink(void) {
 	dynstr_free(s);
 }
 
+static void test_dynstr_header_types(void) {
+	dynstr s = dynstr_new("short");
+	assert(dynstr_type(s) == DYNSTR_TYPE_8);
+	assert(dynstr_header_size(s) == 3);
+	
+	// Growing past 255 characters switches to a wider header and keeps contents
+	for (int i = 0; i < 300; i++) {
+		s = dynstr_push(s, 'a' + i % 26);
+		assert(s);
+	}
+	assert(dynstr_type(s) == DYNSTR_TYPE_16);
+	assert(dynstr_size(s) == 305);
+	assert(memcmp(s, "shortabc", 8) == 0);
+	assert(s[304] == 'a' + 299 % 26 && s[305] == '\0');
+	
+	s = dynstr_reserve(s, 70000);
+	assert(dynstr_type(s) == DYNSTR_TYPE_32);
+	assert(dynstr_capacity(s) == 70000);
+	assert(dynstr_size(s) == 305);
+	assert(memcmp(s, "shortabc", 8) == 0);
+	
+	// Shrinking switches back to a narrower header
+	s = dynstr_range(s, 0, 5);
+	s = dynstr_shrink(s);
+	assert(dynstr_type(s) == DYNSTR_TYPE_8);
+	assert(dynstr_capacity(s) == 5);
+	assert(strcmp(s, "short") == 0);
+	dynstr_free(s);
+	
+	s = dynstr_alloc(UINT8_MAX);
+	assert(dynstr_type(s) == DYNSTR_TYPE_8);
+	s = dynstr_resize(s, UINT8_MAX + 1);
+	assert(dynstr_type(s) == DYNSTR_TYPE_16);
+	assert(dynstr_size(s) == UINT8_MAX + 1);
+	dynstr_free(s);
+}
+
+static void test_dynstr_refcounted(void) {
+	dynstr s = dynstr_new("  shared payload  ");
+	assert(dynstr_refcount(s) == 1);
+	s = dynstr_make_refcounted(s);
+	assert(s);
+	assert(dynstr_refcount(s) == 1);
+	assert(strcmp(s, "  shared payload  ") == 0);
+	
+	// Sharing doesn't copy
+	dynstr consumers[10];
+	for (int i = 0; i < 10; i++) {
+		consumers[i] = i % 2 ? dynstr_retain(s) : dynstr_dup(s);
+		assert(consumers[i] == s);
+	}
+	assert(dynstr_refcount(s) == 11);
+	
+	// Modifications copy the shared string and leave other references intact
+	consumers[0] = dynstr_trim(consumers[0], " ");
+	assert(consumers[0] != s);
+	assert(strcmp(consumers[0], "shared payload") == 0);
+	assert(dynstr_refcount(consumers[0]) == 1);
+	consumers[1] = dynstr_append(consumers[1], "!");
+	assert(strcmp(consumers[1], "  shared payload  !") == 0);
+	consumers[2] = dynstr_range(consumers[2], 2, 6);
+	assert(strcmp(consumers[2], "shared") == 0);
+	consumers[3] = dynstr_clear(consumers[3]);
+	assert(dynstr_size(consumers[3]) == 0);
+	consumers[4] = dynstr_shrink(consumers[4]); // Does nothing for shared strings
+	assert(consumers[4] == s);
+	assert(dynstr_refcount(s) == 7);
+	assert(strcmp(s, "  shared payload  ") == 0);
+	
+	// The last reference can be modified in place
+	for (int i = 4; i < 10; i++) {
+		dynstr_release(consumers[i]);
+	}
+	assert(dynstr_refcount(s) == 1);
+	dynstr t = dynstr_trim_end(s, " ");
+	assert(t == s);
+	s = dynstr_reserve(t, 1000);
+	assert(dynstr_refcount(s) == 1);
+	assert(strcmp(s, "  shared payload") == 0);
+	
+	// Strings which are not reference-counted are copied by retain
+	dynstr plain = dynstr_new("plain");
+	dynstr copy = dynstr_retain(plain);
+	assert(copy != plain);
+	assert(strcmp(copy, "plain") == 0);
+	dynstr_free(copy);
+	dynstr_free(plain);
+	
+	dynstr_free_array(4, consumers);
+	dynstr_free(s);
+}
+
+static void test_dynstr_arena(void) {
+	dynstr_arena_t arena;
+	dynstr_arena_init(&arena, 1024);
+	dynstr a = dynstr_arena_new(&arena, "alpha");
+	assert(dynstr_arena_of(a) == &arena);
+	assert(strcmp(a, "alpha") == 0 && dynstr_size(a) == 5);
+	dynstr b = dynstr_arena_new_printf(&arena, "%s-%d", "beta", 42);
+	assert(strcmp(b, "beta-42") == 0);
+	
+	// The last allocation grows in place (also when its header becomes wider)
+	char *b_before = b;
+	b = dynstr_append(b, " grows in place");
+	assert(b == b_before);
+	b = dynstr_reserve(b, 300);
+	assert(strcmp(b, "beta-42 grows in place") == 0 && dynstr_capacity(b) >= 300);
+	assert(dynstr_arena_of(b) == &arena);
+	
+	// Other strings are copied to the end of the arena
+	a = dynstr_append(a, " moved");
+	assert(strcmp(a, "alpha moved") == 0 && dynstr_arena_of(a) == &arena);
+	assert(strcmp(b, "beta-42 grows in place") == 0);
+	
+	// Strings larger than a chunk get their own chunks
+	for (int i = 0; i < 1000; i++) {
+		a = dynstr_printf(a, " %d", i);
+	}
+	assert(dynstr_size(a) > 1024 && dynstr_has_suffix(a, " 998 999"));
+	assert(dynstr_arena_of(a) == &arena);
+	
+	dynstr c = dynstr_dup(b);
+	assert(c != b && strcmp(c, b) == 0 && dynstr_arena_of(c) == &arena);
+	assert(dynstr_make_refcounted(c) == c && dynstr_refcount(c) == 1);
+	c = dynstr_range(c, 0, 4);
+	c = dynstr_shrink(c);
+	assert(strcmp(c, "beta") == 0 && dynstr_capacity(c) == 4);
+	
+	// Freeing the last allocation returns its memory
+	char *top = arena.top;
+	dynstr d = dynstr_arena_new(&arena, "temporary");
+	dynstr_free(d);
+	assert(arena.top <= top + sizeof(void*));
+	dynstr_free(b); // Does nothing
+	
+	dynstr_arena_chunk_t *head = arena.head;
+	dynstr_arena_reset(&arena);
+	assert(arena.head == head && arena.top == (char*) (head + 1));
+	for (int i = 0; i < 10000; i++) {
+		dynstr s = dynstr_arena_new_chars(&arena, "0123456789", (size_t) (i % 11));
+		assert(dynstr_size(s) == (size_t) (i % 11) && s[dynstr_size(s)] == '\0');
+		assert(((uintptr_t) (s - dynstr_header_size(s) - sizeof(void*)) & (sizeof(void*) - 1)) == 0);
+		s = dynstr_push(s, '!');
+		assert(s[dynstr_size(s) - 1] == '!');
+	}
+	assert(arena.head == head);
+	dynstr_arena_destroy(&arena);
+	assert(arena.head == NULL);
+}
+
 static void test_dynstr_set(void) {
 	dynstr s = dynstr_new("test");
 	s = dynstr_set(s, "qwerty");
@@ -100,6 +250,33 @@ static void test_dynstr_printf(void) {
 	dynstr s = dynstr_new("abc");
 	s = dynstr_printf(s, "%s=%s", "d", "f");
 	assert(strcmp(s, "abcd=f") == 0);
+	
+	// Results which don't fit the spare capacity or the stack buffer
+	char long_arg[1000];
+	memset(long_arg, 'x', sizeof(long_arg) - 1);
+	long_arg[sizeof(long_arg) - 1] = '\0';
+	s = dynstr_printf(s, "[%s]", long_arg);
+	assert(dynstr_size(s) == 6 + 2 + 999);
+	assert(s[6] == '[' && s[7] == 'x' && s[1006] == ']' && s[1007] == '\0');
+	dynstr_free(s);
+	
+	// Results which fit the spare capacity
+	s = dynstr_reserve(dynstr_new("n="), 4096);
+	for (int i = 0; i < 100; i++) {
+		s = dynstr_printf(s, "%i,", i);
+	}
+	assert(dynstr_capacity(s) == 4096);
+	assert(dynstr_has_prefix(s, "n=0,1,2,"));
+	assert(dynstr_has_suffix(s, ",98,99,"));
+	size_t size = dynstr_size(s);
+	s = dynstr_printf(s, "%s", long_arg);
+	assert(dynstr_size(s) == size + 999);
+	assert(memcmp(s + size - 3, "99,xxx", 6) == 0);
+	dynstr_free(s);
+	
+	s = dynstr_new_printf("%s", long_arg);
+	assert(dynstr_size(s) == 999);
+	assert(strcmp(s, long_arg) == 0);
 	dynstr_free(s);
 }
 
@@ -107,19 +284,19 @@ static void test_dynstr_range(void) {
 	dynstr s = dynstr_new("");
 	
 	s = dynstr_set(s, "1234");
-	dynstr_range(s, 0, dynstr_size(s));
+	s = dynstr_range(s, 0, dynstr_size(s));
 	assert(strcmp(s, "1234") == 0);
 	
 	s = dynstr_set(s, "1234");
-	dynstr_range(s, 1, dynstr_size(s) - 2);
+	s = dynstr_range(s, 1, dynstr_size(s) - 2);
 	assert(strcmp(s, "23") == 0);
 	
 	s = dynstr_set(s, "1234");
-	dynstr_range(s, 0, -1);
+	s = dynstr_range(s, 0, -1);
 	assert(strcmp(s, "123") == 0);
 	
 	s = dynstr_set(s, "1234");
-	dynstr_range(s, -1, 1);
+	s = dynstr_range(s, -1, 1);
 	assert(strcmp(s, "4") == 0);
 	
 	dynstr_free(s);
@@ -127,28 +304,48 @@ static void test_dynstr_range(void) {
 
 static void test_dynstr_trim_start(void) {
 	dynstr s = dynstr_new("\r\nabc");
-	dynstr_trim_start(s, "\n\r");
+	s = dynstr_trim_start(s, "\n\r");
 	assert(strcmp(s, "abc") == 0);
-	dynstr_trim_start(s, "\n\r");
+	s = dynstr_trim_start(s, "\n\r");
 	assert(strcmp(s, "abc") == 0);
 	dynstr_free(s);
 }
 
 static void test_dynstr_trim_end(void) {
 	dynstr s = dynstr_new("abc\r\n");
-	dynstr_trim_end(s, "\n\r");
+	s = dynstr_trim_end(s, "\n\r");
 	assert(strcmp(s, "abc") == 0);
-	dynstr_trim_end(s, "\n\r");
+	s = dynstr_trim_end(s, "\n\r");
 	assert(strcmp(s, "abc") == 0);
 	dynstr_free(s);
 }
 
 static void test_dynstr_trim(void) {
 	dynstr s = dynstr_new("\r\nabc\r\n");
-	dynstr_trim(s, "\n\r");
+	s = dynstr_trim(s, "\n\r");
+	assert(strcmp(s, "abc") == 0);
+	s = dynstr_trim(s, "\n\r");
 	assert(strcmp(s, "abc") == 0);
-	dynstr_trim(s, "\n\r");
+	dynstr_free(s);
+}
+
+static void test_dynstr_trim_charset(void) {
+	charset_t set = charset_make(" \t");
+	charset_add(&set, '\0');
+	dynstr s = dynstr_new_chars(" \t\0 abc \0\t ", 12);
+	s = dynstr_trim_charset(s, &set);
+	assert(dynstr_size(s) == 3 && strcmp(s, "abc") == 0);
+	s = dynstr_set(s, "\t\tabc\t");
+	s = dynstr_trim_start_charset(s, &set);
+	assert(strcmp(s, "abc\t") == 0);
+	s = dynstr_trim_end_charset(s, &set);
 	assert(strcmp(s, "abc") == 0);
+	s = dynstr_set(s, "                              x                              ");
+	s = dynstr_trim_charset(s, &set);
+	assert(strcmp(s, "x") == 0);
+	s = dynstr_set(s, "                                        ");
+	s = dynstr_trim_charset(s, &set);
+	assert(dynstr_size(s) == 0);
 	dynstr_free(s);
 }
 
@@ -189,6 +386,9 @@ void test_dynstr(void) {
 	test_dynstr_new_printf();
 	test_dynstr_dup();
 	test_dynstr_shrink();
+	test_dynstr_header_types();
+	test_dynstr_refcounted();
+	test_dynstr_arena();
 	test_dynstr_set();
 	test_dynstr_copy();
 	test_dynstr_push();
@@ -199,6 +399,7 @@ void test_dynstr(void) {
 	test_dynstr_trim_start();
 	test_dynstr_trim_end();
 	test_dynstr_trim();
+	test_dynstr_trim_charset();
 	test_dynstr_has_prefix();
 	test_dynstr_has_suffix();
 	test_dynstr_join();
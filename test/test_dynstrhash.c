@@ -0,0 +1,123 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <CEssentials/dynstrhash.h>
+#include "test_dynstrhash.h"
+
+static void test_dynstrhash_strn(void) {
+	size_t index = 0;
+	int absent;
+	HT(const char*, int) ht;
+	ht_init(ht);
+	
+	ht_put_str(ht, int, "key", index, absent);
+	assert(absent == 1);
+	ht_value(ht, index) = 1;
+	ht_put_str(ht, int, "ke", index, absent);
+	ht_value(ht, index) = 2;
+	
+	assert(ht_strn_hash("key", 3) == ht_str_hash("key"));
+	
+	const char *line = "key=value";
+	ht_get_strn(ht, line, 3, index);
+	assert(ht_valid(ht, index));
+	assert(ht_value(ht, index) == 1);
+	ht_get_strn(ht, line, 2, index);
+	assert(ht_valid(ht, index));
+	assert(ht_value(ht, index) == 2);
+	ht_get_strn(ht, line, 4, index);
+	assert(!ht_valid(ht, index));
+	ht_get_strn(ht, "key\0", 4, index);
+	assert(!ht_valid(ht, index));
+	
+	ht_destroy(ht);
+	
+	HS(const char*) hs;
+	hs_init(hs);
+	hs_put_str(hs, "value", index, absent);
+	hs_get_strn(hs, line + 4, 5, index);
+	assert(hs_valid(hs, index));
+	hs_destroy(hs);
+}
+
+static void test_dynstrhash_table(void) {
+	size_t index = 0;
+	int absent;
+	HT(dynstr, int) ht;
+	ht_init(ht);
+	
+	const char *line = "a,bb,a,ccc,bb,a";
+	const char *begin = line;
+	for (;;) {
+		const char *end = strchr(begin, ',');
+		size_t len = end ? (size_t) (end - begin) : strlen(begin);
+		ht_put_dynstr_chars(ht, int, begin, len, index, absent);
+		assert(absent >= 0);
+		if (absent) {
+			ht_value(ht, index) = 0;
+		}
+		ht_value(ht, index)++;
+		if (!end) break;
+		begin = end + 1;
+	}
+	assert(ht_size(ht) == 3);
+	
+	ht_get_dynstr_chars(ht, "bb", 2, index);
+	assert(ht_valid(ht, index));
+	assert(ht_value(ht, index) == 2);
+	
+	dynstr key = dynstr_new("a");
+	ht_get_dynstr(ht, key, index);
+	assert(ht_valid(ht, index));
+	assert(ht_value(ht, index) == 3);
+	dynstr_free(key);
+	
+	// Keys with NULL characters inside
+	dynstr zero_key = dynstr_new_chars("a\0b", 3);
+	ht_put_dynstr(ht, int, zero_key, index, absent);
+	assert(absent == 1);
+	ht_value(ht, index) = 10;
+	ht_get_dynstr_chars(ht, "a\0b", 3, index);
+	assert(ht_valid(ht, index));
+	assert(ht_value(ht, index) == 10);
+	ht_get_dynstr_chars(ht, "a\0c", 3, index);
+	assert(!ht_valid(ht, index));
+	
+	ht_free_dynstr_keys(ht);
+	ht_destroy(ht);
+	
+	HS(dynstr) hs;
+	hs_init(hs);
+	hs_put_dynstr_chars(hs, "xyz", 2, index, absent);
+	assert(absent == 1);
+	hs_put_dynstr_chars(hs, "xy", 2, index, absent);
+	assert(absent == 0);
+	hs_get_dynstr_chars(hs, "xy", 2, index);
+	assert(hs_valid(hs, index));
+	assert(dynstr_size(hs_key(hs, index)) == 2);
+	hs_free_dynstr_keys(hs);
+	hs_destroy(hs);
+}
+
+void test_dynstrhash(void) {
+	test_dynstrhash_strn();
+	test_dynstrhash_table();
+	printf("dynstrhash.h passed all tests!\n");
+}
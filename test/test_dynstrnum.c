@@ -0,0 +1,248 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <math.h>
+#include <CEssentials/dynstrnum.h>
+#include "test_dynstrnum.h"
+
+static void check_double(double value, const char *expected) {
+	char buffer[STR_DOUBLE_MAX_CHARS + 1];
+	size_t count = str_format_double(buffer, value);
+	assert(count <= STR_DOUBLE_MAX_CHARS);
+	buffer[count] = '\0';
+	assert(strcmp(buffer, expected) == 0);
+}
+
+static void check_roundtrip(double value) {
+	char buffer[STR_DOUBLE_MAX_CHARS + 1];
+	size_t count = str_format_double(buffer, value);
+	assert(count <= STR_DOUBLE_MAX_CHARS);
+	buffer[count] = '\0';
+	double parsed = strtod(buffer, NULL);
+	assert(memcmp(&parsed, &value, sizeof(double)) == 0);
+	assert(str_to_double(buffer, count, &parsed) == STR_PARSE_OK);
+	assert(memcmp(&parsed, &value, sizeof(double)) == 0);
+}
+
+static void check_parse_double(const char *text) {
+	double expected = strtod(text, NULL), parsed;
+	assert(str_to_double(text, strlen(text), &parsed) == (isinf(expected) ? STR_PARSE_RANGE : STR_PARSE_OK));
+	assert(memcmp(&parsed, &expected, sizeof(double)) == 0);
+}
+
+static void test_dynstrnum_int(void) {
+	dynstr s = dynstr_new("");
+	s = dynstr_append_u64(s, 0);
+	s = dynstr_push(s, ' ');
+	s = dynstr_append_u64(s, UINT64_MAX);
+	s = dynstr_push(s, ' ');
+	s = dynstr_append_i64(s, INT64_MIN);
+	s = dynstr_push(s, ' ');
+	s = dynstr_append_i64(s, INT64_MAX);
+	s = dynstr_push(s, ' ');
+	s = dynstr_append_i64(s, -7);
+	s = dynstr_push(s, ' ');
+	s = dynstr_append_hex(s, 0);
+	s = dynstr_push(s, ' ');
+	s = dynstr_append_hex(s, 0xDEADBEEFull);
+	s = dynstr_push(s, ' ');
+	s = dynstr_append_hex(s, UINT64_MAX);
+	assert(strcmp(s, "0 18446744073709551615 -9223372036854775808 9223372036854775807 -7 0 deadbeef ffffffffffffffff") == 0);
+	assert(dynstr_size(s) == strlen(s));
+	dynstr_free(s);
+	
+	char expected[32], buffer[STR_INT_MAX_CHARS];
+	uint64_t value = 1;
+	for (int i = 0; i < 64; i++, value = value * 3 + 1) {
+		snprintf(expected, sizeof(expected), "%llu", (unsigned long long) value);
+		assert(str_format_u64(buffer, value) == strlen(expected));
+		assert(memcmp(buffer, expected, strlen(expected)) == 0);
+		snprintf(expected, sizeof(expected), "%lld", -(long long) (value >> 1));
+		assert(str_format_i64(buffer, -(int64_t) (value >> 1)) == strlen(expected));
+		assert(memcmp(buffer, expected, strlen(expected)) == 0);
+	}
+}
+
+static void test_dynstrnum_double(void) {
+	check_double(0.0, "0");
+	check_double(-0.0, "-0");
+	check_double(1.0, "1");
+	check_double(-1.5, "-1.5");
+	check_double(0.1, "0.1");
+	check_double(0.3, "0.3");
+	check_double(100.0, "100");
+	check_double(123.456, "123.456");
+	check_double(1e21, "1e21");
+	check_double(1e20, "100000000000000000000");
+	check_double(1.5e-7, "1.5e-7");
+	check_double(0.000001, "0.000001");
+	check_double(1.7976931348623157e308, "1.7976931348623157e308");
+	check_double(5e-324, "5e-324");
+	check_double(INFINITY, "inf");
+	check_double(-INFINITY, "-inf");
+	check_double(NAN, "nan");
+	
+	check_roundtrip(DBL_MIN);
+	check_roundtrip(DBL_MAX);
+	check_roundtrip(DBL_EPSILON);
+	check_roundtrip(2.2250738585072009e-308); // The largest subnormal
+	srand(12345);
+	for (int i = 0; i < 100000; i++) {
+		uint64_t bits = 0;
+		for (int j = 0; j < 4; j++) {
+			bits = (bits << 16) ^ (uint64_t) (rand() & 0xFFFF);
+		}
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		if (isfinite(value)) {
+			check_roundtrip(value);
+		}
+		check_roundtrip((double) rand() / RAND_MAX);
+	}
+	
+	dynstr s = dynstr_new("x=");
+	s = dynstr_append_double(s, 2.5);
+	assert(strcmp(s, "x=2.5") == 0);
+	assert(dynstr_size(s) == 5);
+	dynstr_free(s);
+}
+
+static void test_dynstrnum_parse_int(void) {
+	uint64_t u = 7;
+	int64_t i = 7;
+	assert(str_to_u64("0", 1, &u) == STR_PARSE_OK && u == 0);
+	assert(str_to_u64("+42", 3, &u) == STR_PARSE_OK && u == 42);
+	assert(str_to_u64("18446744073709551615", 20, &u) == STR_PARSE_OK && u == UINT64_MAX);
+	assert(str_to_u64("00000000000000000000018446744073709551615", 41, &u) == STR_PARSE_OK && u == UINT64_MAX);
+	assert(str_to_u64("18446744073709551616", 20, &u) == STR_PARSE_RANGE && u == UINT64_MAX);
+	assert(str_to_u64("99999999999999999999", 20, &u) == STR_PARSE_RANGE && u == UINT64_MAX);
+	assert(str_to_u64("123456789012345678901", 21, &u) == STR_PARSE_RANGE && u == UINT64_MAX);
+	u = 7;
+	assert(str_to_u64("", 0, &u) == STR_PARSE_INVALID && u == 7);
+	assert(str_to_u64("+", 1, &u) == STR_PARSE_INVALID && u == 7);
+	assert(str_to_u64("-1", 2, &u) == STR_PARSE_INVALID && u == 7);
+	assert(str_to_u64(" 1", 2, &u) == STR_PARSE_INVALID && u == 7);
+	assert(str_to_u64("1234567x", 8, &u) == STR_PARSE_INVALID && u == 7);
+	assert(str_to_u64("12345678:", 9, &u) == STR_PARSE_INVALID && u == 7);
+	assert(str_to_u64("1234567890123456789012x", 23, &u) == STR_PARSE_INVALID && u == 7);
+	assert(str_to_u64("123", 2, &u) == STR_PARSE_OK && u == 12); // Length-bounded
+	
+	assert(str_to_i64("-0", 2, &i) == STR_PARSE_OK && i == 0);
+	assert(str_to_i64("-9223372036854775808", 20, &i) == STR_PARSE_OK && i == INT64_MIN);
+	assert(str_to_i64("9223372036854775807", 19, &i) == STR_PARSE_OK && i == INT64_MAX);
+	assert(str_to_i64("+9223372036854775808", 20, &i) == STR_PARSE_RANGE && i == INT64_MAX);
+	assert(str_to_i64("-9223372036854775809", 20, &i) == STR_PARSE_RANGE && i == INT64_MIN);
+	assert(str_to_i64("-99999999999999999999999", 24, &i) == STR_PARSE_RANGE && i == INT64_MIN);
+	i = 7;
+	assert(str_to_i64("--1", 3, &i) == STR_PARSE_INVALID && i == 7);
+	assert(str_to_i64("1.5", 3, &i) == STR_PARSE_INVALID && i == 7);
+	
+	char buffer[STR_INT_MAX_CHARS];
+	uint64_t value = 1;
+	for (int k = 0; k < 64; k++, value = value * 3 + 1) {
+		assert(str_to_u64(buffer, str_format_u64(buffer, value), &u) == STR_PARSE_OK && u == value);
+		int64_t negative = -(int64_t) (value >> 1);
+		assert(str_to_i64(buffer, str_format_i64(buffer, negative), &i) == STR_PARSE_OK && i == negative);
+	}
+	
+	dynstr s = dynstr_new("-12345");
+	assert(dynstr_to_i64(s, &i) == STR_PARSE_OK && i == -12345);
+	assert(dynstr_to_u64(s, &u) == STR_PARSE_INVALID);
+	assert(strview_to_u64(strview_slice(strview_from_dynstr(s), 1, 3), &u) == STR_PARSE_OK && u == 123);
+	dynstr_free(s);
+}
+
+static void test_dynstrnum_parse_double(void) {
+	double d = 7.0;
+	assert(str_to_double("", 0, &d) == STR_PARSE_INVALID && d == 7.0);
+	assert(str_to_double(".", 1, &d) == STR_PARSE_INVALID && d == 7.0);
+	assert(str_to_double("-", 1, &d) == STR_PARSE_INVALID && d == 7.0);
+	assert(str_to_double("e5", 2, &d) == STR_PARSE_INVALID && d == 7.0);
+	assert(str_to_double("1e", 2, &d) == STR_PARSE_INVALID && d == 7.0);
+	assert(str_to_double("1e+", 3, &d) == STR_PARSE_INVALID && d == 7.0);
+	assert(str_to_double("1.5 ", 4, &d) == STR_PARSE_INVALID && d == 7.0);
+	assert(str_to_double("0x10", 4, &d) == STR_PARSE_INVALID && d == 7.0);
+	assert(str_to_double("infinit", 7, &d) == STR_PARSE_INVALID && d == 7.0);
+	assert(str_to_double("1.5", 1, &d) == STR_PARSE_OK && d == 1.0); // Length-bounded
+	assert(str_to_double("-0", 2, &d) == STR_PARSE_OK && d == 0.0 && signbit(d));
+	assert(str_to_double("INF", 3, &d) == STR_PARSE_OK && d == INFINITY);
+	assert(str_to_double("-Infinity", 9, &d) == STR_PARSE_OK && d == -INFINITY);
+	assert(str_to_double("nan", 3, &d) == STR_PARSE_OK && isnan(d));
+	assert(str_to_double("1e400", 5, &d) == STR_PARSE_RANGE && d == INFINITY);
+	assert(str_to_double("-1e400", 6, &d) == STR_PARSE_RANGE && d == -INFINITY);
+	assert(str_to_double("1e-400", 6, &d) == STR_PARSE_OK && d == 0.0);
+	
+	static const char *const cases[] = {
+		"0", "1", ".5", "5.", "0.1", "-2.5e-3", "1e22", "1e23", "9007199254740993", "123456789012345678",
+		"1.7976931348623157e308", "1.7976931348623158e308", "1.7976931348623159e308", "2.2250738585072011e-308",
+		"2.2250738585072012e-308", "4.9406564584124654e-324", "2.4703282292062327e-324", "2.4703282292062328e-324",
+		"9007199254740992.5", "9007199254740993.0000000000000000001", "0.000000000000000000000000000000000001",
+		"3.14159265358979323846264338327950288419716939937510", "1000000000000000000000000000000000000e-20",
+		"7.2057594037927933e16", "1.00000000000000011102230246251565404236316680908203125",
+		"1.00000000000000011102230246251565404236316680908203124",
+		"1.00000000000000011102230246251565404236316680908203126", "1e-1000000", "1e1000000",
+		"0.00000000000000000000000000000000000000000000000000000000000000000000000000000000000001e100",
+		"1234567890.12345678901234567890e-5", "+1.25", "12345678.12345678", "0.1234567812345678",
+	};
+	for (size_t k = 0; k < sizeof(cases) / sizeof(cases[0]); k++) {
+		check_parse_double(cases[k]);
+	}
+	
+	// Random decimal strings with up to 25 significant digits
+	char text[64];
+	srand(54321);
+	for (int k = 0; k < 100000; k++) {
+		int integer_digits = rand() % 13, fraction_digits = rand() % 13, length = 0;
+		for (int j = 0; j < integer_digits; j++) {
+			text[length++] = (char) ('0' + rand() % 10);
+		}
+		text[length++] = '.';
+		for (int j = 0; j < fraction_digits; j++) {
+			text[length++] = (char) ('0' + rand() % 10);
+		}
+		if (length == 1) {
+			text[length++] = '0';
+		}
+		length += snprintf(text + length, sizeof(text) - (size_t) length, "e%d", rand() % 660 - 340);
+		check_parse_double(text);
+	}
+	
+	strview_t rest = strview_from_cstr("1.5,-2,abc"), token;
+	assert(strview_split_next(&rest, strview_from_cstr(","), &token));
+	assert(strview_to_double(token, &d) == STR_PARSE_OK && d == 1.5);
+	assert(strview_split_next(&rest, strview_from_cstr(","), &token));
+	assert(strview_to_double(token, &d) == STR_PARSE_OK && d == -2.0);
+	assert(strview_split_next(&rest, strview_from_cstr(","), &token));
+	assert(strview_to_double(token, &d) == STR_PARSE_INVALID);
+	dynstr s = dynstr_new("6.02214076e23");
+	assert(dynstr_to_double(s, &d) == STR_PARSE_OK && d == 6.02214076e23);
+	dynstr_free(s);
+}
+
+void test_dynstrnum(void) {
+	test_dynstrnum_int();
+	test_dynstrnum_double();
+	test_dynstrnum_parse_int();
+	test_dynstrnum_parse_double();
+	printf("dynstrnum.h passed all tests!\n");
+}
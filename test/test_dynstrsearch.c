@@ -0,0 +1,176 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <CEssentials/dynstrsearch.h>
+#include "test_dynstrsearch.h"
+
+static size_t naive_find(const char *data, size_t count, const char *needle, size_t needle_count) {
+	for (size_t i = 0; i + needle_count <= count; i++) {
+		if (memcmp(data + i, needle, needle_count) == 0) {
+			return i;
+		}
+	}
+	return STR_NPOS;
+}
+
+static size_t naive_rfind(const char *data, size_t count, const char *needle, size_t needle_count) {
+	for (size_t i = count + 1; i-- > 0;) {
+		if (i + needle_count <= count && memcmp(data + i, needle, needle_count) == 0) {
+			return i;
+		}
+	}
+	return STR_NPOS;
+}
+
+static void test_dynstrsearch_basic(void) {
+	dynstr s = dynstr_new("one fish, two fish, red fish, blue fish");
+	assert(dynstr_find(s, "fish") == 4);
+	assert(dynstr_rfind(s, "fish") == 35);
+	assert(dynstr_count(s, "fish") == 4);
+	assert(dynstr_find(s, "cat") == STR_NPOS);
+	assert(dynstr_rfind(s, "cat") == STR_NPOS);
+	assert(dynstr_count(s, "cat") == 0);
+	assert(dynstr_find(s, "") == 0);
+	assert(dynstr_rfind(s, "") == dynstr_size(s));
+	assert(dynstr_count(s, "") == 0);
+	assert(dynstr_find(s, "o") == 0);
+	assert(dynstr_rfind(s, "o") == 12);
+	assert(dynstr_find(s, "one fish, two fish, red fish, blue fish!") == STR_NPOS);
+	
+	s = dynstr_replace_all(s, "fish", "cat");
+	assert(strcmp(s, "one cat, two cat, red cat, blue cat") == 0);
+	assert(dynstr_size(s) == strlen(s));
+	s = dynstr_replace_all(s, "cat", "catfish");
+	assert(strcmp(s, "one catfish, two catfish, red catfish, blue catfish") == 0);
+	assert(dynstr_size(s) == strlen(s));
+	s = dynstr_replace_all(s, ", ", "");
+	assert(strcmp(s, "one catfishtwo catfishred catfishblue catfish") == 0);
+	s = dynstr_replace_all(s, "", "x");
+	assert(strcmp(s, "one catfishtwo catfishred catfishblue catfish") == 0);
+	s = dynstr_replace_all(s, "dog", "x");
+	assert(strcmp(s, "one catfishtwo catfishred catfishblue catfish") == 0);
+	
+	s = dynstr_set(s, "key=value; other=42");
+	charset_t separators = charset_make("=;");
+	assert(dynstr_find_any(s, &separators) == 3);
+	assert(dynstr_rfind_any(s, &separators) == 16);
+	separators = charset_make("#");
+	assert(dynstr_find_any(s, &separators) == STR_NPOS && dynstr_rfind_any(s, &separators) == STR_NPOS);
+	dynstr_free(s);
+	
+	// Non-overlapping occurrences are taken from left to right
+	s = dynstr_new("aaaaa");
+	assert(dynstr_count(s, "aa") == 2);
+	s = dynstr_replace_all(s, "aa", "b");
+	assert(strcmp(s, "bba") == 0);
+	dynstr_free(s);
+	
+	// Embedded NULL characters
+	s = dynstr_new_chars("a\0b\0c\0b", 7);
+	assert(dynstr_find_chars(s, "\0b", 2) == 1);
+	assert(dynstr_rfind_chars(s, "\0b", 2) == 5);
+	assert(dynstr_count_chars(s, "\0", 1) == 3);
+	s = dynstr_replace_all_chars(s, "\0", 1, "--", 2);
+	assert(dynstr_size(s) == 10);
+	assert(memcmp(s, "a--b--c--b", 11) == 0);
+	dynstr_free(s);
+	
+	// Shared strings are copied before the replacement
+	s = dynstr_make_refcounted(dynstr_new("a-b-c"));
+	dynstr t = dynstr_retain(s);
+	t = dynstr_replace_all(t, "-", "+");
+	assert(strcmp(s, "a-b-c") == 0 && strcmp(t, "a+b+c") == 0);
+	t = dynstr_replace_all(t, "+", "<+>");
+	assert(strcmp(t, "a<+>b<+>c") == 0);
+	assert(dynstr_refcount(t) == 1 && (dynstr_type_byte(t) & DYNSTR_FLAG_REFCOUNTED));
+	assert(dynstr_refcount(s) == 1);
+	dynstr_free(t);
+	dynstr_free(s);
+}
+
+static void test_dynstrsearch_random(void) {
+	char data[300], needle[40];
+	srand(4242);
+	for (int k = 0; k < 20000; k++) {
+		// Small alphabets (including the NULL character) give many partial matches
+		int alphabet = 1 + rand() % 4;
+		size_t count = (size_t) rand() % sizeof(data), needle_count = 1 + (size_t) rand() % (k % 2 ? 4 : sizeof(needle));
+		for (size_t i = 0; i < count; i++) {
+			data[i] = (char) (rand() % alphabet);
+		}
+		if (count >= needle_count && rand() % 2) {
+			memcpy(needle, data + (size_t) rand() % (count - needle_count + 1), needle_count);
+		} else {
+			for (size_t i = 0; i < needle_count; i++) {
+				needle[i] = (char) (rand() % alphabet);
+			}
+		}
+		assert(str_find(data, count, needle, needle_count) == naive_find(data, count, needle, needle_count));
+		assert(str_rfind(data, count, needle, needle_count) == naive_rfind(data, count, needle, needle_count));
+		size_t expected = 0;
+		for (size_t i = 0, index; (index = naive_find(data + i, count - i, needle, needle_count)) != STR_NPOS;) {
+			expected++;
+			i += index + needle_count;
+		}
+		assert(str_count(data, count, needle, needle_count) == expected);
+	}
+}
+
+static void test_dynstrsearch_worst_case(void) {
+	// Every position is a candidate for the first/last character filter, so the search switches to Two-Way
+	size_t count = 1 << 20;
+	char *data = malloc(count);
+	assert(data);
+	memset(data, 'a', count);
+	char needle[64];
+	memset(needle, 'a', sizeof(needle));
+	needle[0] = 'b';
+	needle[sizeof(needle) - 1] = 'a';
+	assert(str_find(data, count, needle, sizeof(needle)) == STR_NPOS);
+	assert(str_rfind(data, count, needle, sizeof(needle)) == STR_NPOS);
+	data[count - 64] = 'b';
+	assert(str_find(data, count, needle, sizeof(needle)) == count - 64);
+	data[100] = 'b';
+	assert(str_rfind(data, count, needle, sizeof(needle)) == count - 64);
+	data[count - 64] = 'a';
+	assert(str_rfind(data, count, needle, sizeof(needle)) == 100);
+	assert(str_find(data, count, needle, sizeof(needle)) == 100);
+	
+	// Periodic needle
+	for (size_t i = 0; i < count; i++) {
+		data[i] = "abcab"[i % 5];
+	}
+	const char *periodic = "abcababcababcababcababcababcababcababcababcababcabx";
+	assert(str_find(data, count, periodic, strlen(periodic)) == STR_NPOS);
+	assert(str_rfind(data, count, periodic, strlen(periodic)) == STR_NPOS);
+	memcpy(data + 500000, periodic, strlen(periodic));
+	assert(str_find(data, count, periodic, strlen(periodic)) == 500000);
+	assert(str_rfind(data, count, periodic, strlen(periodic)) == 500000);
+	free(data);
+}
+
+void test_dynstrsearch(void) {
+	test_dynstrsearch_basic();
+	test_dynstrsearch_random();
+	test_dynstrsearch_worst_case();
+	printf("dynstrsearch.h passed all tests!\n");
+}
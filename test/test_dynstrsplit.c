@@ -35,6 +35,26 @@ void test_dynstrsplit(void) {
 	assert(strcmp(s, "A::B==C") == 0);
 	dynstr_free(s);
 	
+	dynstr_list_clear(&strings);
+	
+	charset_t separators = charset_make(",; ");
+	str_split_any("a,b;;c d", &separators, 0, &strings);
+	assert(dynvec_size(strings) == 5);
+	assert(strcmp(dynvec_at(strings, 0), "a") == 0);
+	assert(strcmp(dynvec_at(strings, 1), "b") == 0);
+	assert(strcmp(dynvec_at(strings, 2), "") == 0);
+	assert(strcmp(dynvec_at(strings, 3), "c") == 0);
+	assert(strcmp(dynvec_at(strings, 4), "d") == 0);
+	dynstr_list_clear(&strings);
+	
+	str_split_any("a,b;c", &separators, 2, &strings);
+	assert(dynvec_size(strings) == 2);
+	assert(strcmp(dynvec_at(strings, 1), "b;c") == 0);
+	dynstr_list_clear(&strings);
+	
+	str_split_any("", &separators, 0, &strings);
+	assert(dynvec_size(strings) == 1);
+	assert(strcmp(dynvec_at(strings, 0), "") == 0);
 	dynstr_list_clear(&strings);
 	dynvec_destroy(strings);
 	
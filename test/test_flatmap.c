@@ -0,0 +1,198 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <CEssentials/flatmap.h>
+#include "test_flatmap.h"
+
+typedef FLATMAP_ENTRY(int, int) int_entry_t;
+typedef FLATMAP_ENTRY(const char*, int) str_entry_t;
+
+static void test_flatmap_bulk(void) {
+	FLATMAP(int_entry_t) m; size_t index, begin, end; bool success;
+	flatmap_init(m);
+	
+	flatmap_build_int(m, int_entry_t, success); // Nothing to build
+	assert(success);
+	flatmap_get_int(m, 10, index);
+	assert(!flatmap_valid(m, index));
+	
+	// Pseudo-random order with duplicates
+	for (int i = 0; i < 1000; i++) {
+		int key = (i * 7919) % 500;
+		assert(flatmap_push(m, int_entry_t, key, key * 2));
+	}
+	assert(flatmap_size(m) == 0); // Not built yet
+	flatmap_build_int(m, int_entry_t, success);
+	assert(success);
+	assert(flatmap_size(m) == 500);
+	flatmap_for_each(m, i) {
+		assert(flatmap_key(m, i) == (int) i);
+		assert(flatmap_value(m, i) == (int) i * 2);
+	}
+	
+	// Already sorted input appended after existing keys
+	for (int i = 500; i < 600; i++) {
+		assert(flatmap_push(m, int_entry_t, i, i * 2));
+	}
+	flatmap_build_int(m, int_entry_t, success);
+	assert(success);
+	assert(flatmap_size(m) == 600);
+	
+	// Interleaved input replacing some existing keys
+	for (int i = 599; i >= 0; i -= 3) {
+		assert(flatmap_push(m, int_entry_t, i, -i));
+	}
+	for (int i = 1000; i > 600; i -= 2) {
+		assert(flatmap_push(m, int_entry_t, i, i * 2));
+	}
+	flatmap_build_int(m, int_entry_t, success);
+	assert(success);
+	assert(flatmap_size(m) == 800);
+	for (size_t i = 1; i < flatmap_size(m); i++) {
+		assert(flatmap_key(m, i - 1) < flatmap_key(m, i));
+	}
+	for (int i = 0; i < 600; i++) {
+		flatmap_get_int(m, i, index);
+		assert(flatmap_valid(m, index));
+		assert(flatmap_key(m, index) == i);
+		assert(flatmap_value(m, index) == ((599 - i) % 3 == 0 ? -i : i * 2));
+	}
+	flatmap_get_int(m, 601, index);
+	assert(!flatmap_valid(m, index));
+	flatmap_get_int(m, 1000, index);
+	assert(flatmap_valid(m, index));
+	flatmap_get_int(m, 1001, index);
+	assert(!flatmap_valid(m, index));
+	flatmap_get_int(m, -1, index);
+	assert(!flatmap_valid(m, index));
+	
+	// Range queries
+	flatmap_range_int(m, 590, 610, begin, end);
+	assert(end - begin == 14);
+	assert(flatmap_key(m, begin) == 590);
+	assert(flatmap_key(m, end - 1) == 608);
+	flatmap_range_int(m, 2000, 3000, begin, end);
+	assert(begin == end);
+	assert(begin == flatmap_size(m));
+	flatmap_range_int(m, 10, 5, begin, end);
+	assert(begin == end);
+	flatmap_lower_bound(m, 601, index, flatmap_int_cmp);
+	assert(flatmap_key(m, index) == 602);
+	flatmap_upper_bound(m, 602, index, flatmap_int_cmp);
+	assert(flatmap_key(m, index) == 604);
+	flatmap_upper_bound(m, 1000, index, flatmap_int_cmp);
+	assert(index == flatmap_size(m));
+	flatmap_lower_bound(m, -5, index, flatmap_int_cmp);
+	assert(index == 0);
+	
+	flatmap_destroy(m);
+}
+
+static void test_flatmap_duplicates(void) {
+	FLATMAP(int_entry_t) m; size_t index; bool success;
+	flatmap_init(m);
+	
+	// Bulk load with few distinct keys (quadratic with a two-way partition)
+	for (int i = 0; i < 200000; i++) {
+		assert(flatmap_push(m, int_entry_t, (i * 7919) % 4, i));
+	}
+	flatmap_build_int(m, int_entry_t, success);
+	assert(success);
+	assert(flatmap_size(m) == 4);
+	for (int i = 0; i < 4; i++) {
+		flatmap_get_int(m, i, index);
+		assert(flatmap_valid(m, index));
+		assert(flatmap_value(m, index) % 4 == (i * 3) % 4); // Value of one of the entries with this key
+	}
+	
+	// All keys equal
+	for (int i = 0; i < 100000; i++) {
+		assert(flatmap_push(m, int_entry_t, 2, -1));
+	}
+	flatmap_build_int(m, int_entry_t, success);
+	assert(success);
+	assert(flatmap_size(m) == 4);
+	flatmap_get_int(m, 2, index);
+	assert(flatmap_value(m, index) == -1);
+	
+	flatmap_destroy(m);
+}
+
+static void test_flatmap_put_delete(void) {
+	FLATMAP(str_entry_t) m; size_t index; int absent; bool success;
+	flatmap_init(m);
+	
+	const char *keys[] = {"pear", "apple", "peach", "banana", "cherry"};
+	for (int i = 0; i < 5; i++) {
+		flatmap_put_str(m, str_entry_t, keys[i], index, absent);
+		assert(absent == 1);
+		flatmap_value(m, index) = i;
+	}
+	flatmap_put_str(m, str_entry_t, "peach", index, absent);
+	assert(absent == 0);
+	assert(flatmap_value(m, index) == 2);
+	assert(flatmap_size(m) == 5);
+	
+	const char *sorted[] = {"apple", "banana", "cherry", "peach", "pear"};
+	flatmap_for_each(m, i) {
+		assert(strcmp(flatmap_key(m, i), sorted[i]) == 0);
+	}
+	
+	// Put while there are pending entries
+	assert(flatmap_push(m, str_entry_t, "apricot", 10));
+	flatmap_put_str(m, str_entry_t, "melon", index, absent);
+	assert(absent == 1);
+	flatmap_value(m, index) = 11;
+	flatmap_get_str(m, "apricot", index);
+	assert(!flatmap_valid(m, index));
+	flatmap_build_str(m, str_entry_t, success);
+	assert(success);
+	assert(flatmap_size(m) == 7);
+	flatmap_get_str(m, "apricot", index);
+	assert(flatmap_valid(m, index));
+	assert(index == 1);
+	assert(flatmap_value(m, index) == 10);
+	
+	flatmap_get_str(m, "cherry", index);
+	assert(flatmap_valid(m, index));
+	flatmap_delete(m, index);
+	assert(flatmap_size(m) == 6);
+	flatmap_get_str(m, "cherry", index);
+	assert(!flatmap_valid(m, index));
+	flatmap_get_str(m, "melon", index);
+	assert(flatmap_valid(m, index));
+	assert(flatmap_value(m, index) == 11);
+	
+	flatmap_clear(m);
+	assert(flatmap_size(m) == 0);
+	flatmap_get_str(m, "pear", index);
+	assert(!flatmap_valid(m, index));
+	
+	flatmap_destroy(m);
+}
+
+void test_flatmap(void) {
+	test_flatmap_bulk();
+	test_flatmap_duplicates();
+	test_flatmap_put_delete();
+	
+	printf("flatmap.h passed all tests!\n");
+}
@@ -0,0 +1,106 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <CEssentials/flatset.h>
+#include "test_flatset.h"
+
+void test_flatset(void) {
+	FLATSET(int) a, b, c; size_t index, begin, end; int absent; bool success;
+	flatset_init(a);
+	flatset_init(b);
+	flatset_init(c);
+	
+	// Multiples of 2 (reverse order with duplicates) and multiples of 3 (one by one)
+	for (int i = 100; i >= 0; i -= 2) {
+		assert(flatset_push(a, int, i));
+		assert(flatset_push(a, int, i));
+	}
+	flatset_build_int(a, int, success);
+	assert(success);
+	assert(flatset_size(a) == 51);
+	for (int i = 0; i <= 100; i += 3) {
+		flatset_put_int(b, int, i, index, absent);
+		assert(absent == 1);
+		assert(flatset_key(b, index) == i);
+	}
+	flatset_put_int(b, int, 99, index, absent);
+	assert(absent == 0);
+	assert(flatset_size(b) == 34);
+	
+	flatset_union_int(c, a, b, int, success);
+	assert(success);
+	assert(flatset_size(c) == 51 + 34 - 17);
+	flatset_for_each(c, i) {
+		assert(flatset_key(c, i) % 2 == 0 || flatset_key(c, i) % 3 == 0);
+		assert(i == 0 || flatset_key(c, i - 1) < flatset_key(c, i));
+	}
+	
+	flatset_intersection_int(c, a, b, int, success);
+	assert(success);
+	assert(flatset_size(c) == 17);
+	flatset_for_each(c, i) {
+		assert(flatset_key(c, i) == (int) i * 6);
+	}
+	
+	flatset_difference_int(c, a, b, int, success);
+	assert(success);
+	assert(flatset_size(c) == 34);
+	flatset_for_each(c, i) {
+		assert(flatset_key(c, i) % 2 == 0 && flatset_key(c, i) % 3 != 0);
+	}
+	flatset_get_int(c, 4, index);
+	assert(flatset_valid(c, index));
+	flatset_get_int(c, 6, index);
+	assert(!flatset_valid(c, index));
+	
+	flatset_range_int(c, 10, 21, begin, end);
+	assert(end - begin == 4); // 10, 14, 16, 20
+	flatset_delete(c, begin);
+	flatset_range_int(c, 10, 21, begin, end);
+	assert(end - begin == 3);
+	
+	flatset_clear(b);
+	flatset_intersection_int(c, a, b, int, success);
+	assert(success);
+	assert(flatset_size(c) == 0);
+	flatset_difference_int(c, a, b, int, success);
+	assert(success);
+	assert(flatset_size(c) == flatset_size(a));
+	
+	FLATSET(const char*) s;
+	flatset_init(s);
+	assert(flatset_push(s, const char*, "pear"));
+	assert(flatset_push(s, const char*, "apple"));
+	assert(flatset_push(s, const char*, "pear"));
+	flatset_build_str(s, const char*, success);
+	assert(success);
+	assert(flatset_size(s) == 2);
+	assert(strcmp(flatset_key(s, 0), "apple") == 0);
+	flatset_get_str(s, "pear", index);
+	assert(index == 1);
+	flatset_destroy(s);
+	
+	flatset_destroy(a);
+	flatset_destroy(b);
+	flatset_destroy(c);
+	
+	printf("flatset.h passed all tests!\n");
+}
@@ -0,0 +1,176 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <CEssentials/hamt.h>
+#include "test_hamt.h"
+
+#define KEY(i) ((const void*) (uintptr_t) ((i) + 1))
+#define VALUE(i) ((void*) (uintptr_t) ((i) * 10 + 1))
+
+// Only 4 distinct hashes: produces deep paths and collision nodes
+static size_t bad_hash(const void *key) {
+	return (size_t) ((uintptr_t) key % 4);
+}
+
+static void test_hamt_basic(void) {
+	hamt_t map;
+	hamt_init(&map, hamt_str_hash, hamt_str_eq, NULL);
+	
+	assert(hamt_put(&map, "10", VALUE(10)) == 1);
+	assert(hamt_put(&map, "20", VALUE(20)) == 1);
+	assert(hamt_put(&map, "10", VALUE(11)) == 0);
+	assert(hamt_size(&map) == 2);
+	
+	void *value;
+	assert(hamt_get(&map, "10", &value));
+	assert(value == VALUE(11));
+	assert(!hamt_get(&map, "30", &value));
+	
+	assert(hamt_delete(&map, "30") == 0);
+	assert(hamt_delete(&map, "10") == 1);
+	assert(!hamt_get(&map, "10", NULL));
+	assert(hamt_delete(&map, "20") == 1);
+	assert(hamt_size(&map) == 0);
+	
+	hamt_destroy(&map);
+}
+
+static void test_hamt_model(hamt_hash_func_t hash, hamt_pool_t *pool) {
+	enum { COUNT = 3000 };
+	static int present[COUNT];
+	for (int i = 0; i < COUNT; i++) {
+		present[i] = 0;
+	}
+	hamt_t map;
+	hamt_init(&map, hash, hamt_ptr_eq, pool);
+	srand(42);
+	size_t size = 0;
+	for (int step = 0; step < COUNT * 4; step++) {
+		int i = rand() % COUNT;
+		if (rand() % 3) {
+			int result = hamt_put(&map, KEY(i), VALUE(i + step));
+			assert(result == !present[i]);
+			if (!present[i]) {
+				size++;
+			}
+			present[i] = i + step + 1;
+		} else {
+			int result = hamt_delete(&map, KEY(i));
+			assert(result == !!present[i]);
+			if (present[i]) {
+				size--;
+			}
+			present[i] = 0;
+		}
+		assert(hamt_size(&map) == size);
+	}
+	for (int i = 0; i < COUNT; i++) {
+		void *value;
+		bool found = hamt_get(&map, KEY(i), &value);
+		assert(found == !!present[i]);
+		if (found) {
+			assert(value == VALUE(present[i] - 1));
+		}
+	}
+	size_t count = 0;
+	hamt_iter_t it;
+	hamt_iter_init(&it, &map);
+	while (hamt_iter_next(&it)) {
+		int i = (int) ((uintptr_t) it.key - 1);
+		assert(present[i]);
+		assert(it.value == VALUE(present[i] - 1));
+		count++;
+	}
+	assert(count == size);
+	
+	for (int i = 0; i < COUNT; i++) {
+		assert(hamt_delete(&map, KEY(i)) == !!present[i]);
+	}
+	assert(hamt_size(&map) == 0);
+	hamt_destroy(&map);
+}
+
+static void test_hamt_snapshot(hamt_hash_func_t hash, hamt_pool_t *pool) {
+	hamt_t map;
+	hamt_init(&map, hash, hamt_ptr_eq, pool);
+	for (int i = 0; i < 1000; i++) {
+		assert(hamt_put(&map, KEY(i), VALUE(i)) == 1);
+	}
+	
+	hamt_t snapshot;
+	hamt_snapshot(&map, &snapshot);
+	for (int i = 0; i < 1000; i += 2) {
+		assert(hamt_delete(&map, KEY(i)) == 1);
+	}
+	for (int i = 1; i < 1000; i += 2) {
+		assert(hamt_put(&map, KEY(i), VALUE(i + 1)) == 0);
+	}
+	for (int i = 1000; i < 1500; i++) {
+		assert(hamt_put(&map, KEY(i), VALUE(i)) == 1);
+	}
+	
+	hamt_t snapshot2;
+	hamt_snapshot(&map, &snapshot2);
+	assert(hamt_put(&map, KEY(2000), VALUE(2000)) == 1);
+	
+	// The first snapshot hasn't changed
+	assert(hamt_size(&snapshot) == 1000);
+	for (int i = 0; i < 1500; i++) {
+		void *value;
+		bool found = hamt_get(&snapshot, KEY(i), &value);
+		assert(found == (i < 1000));
+		if (found) {
+			assert(value == VALUE(i));
+		}
+	}
+	hamt_destroy(&snapshot);
+	
+	assert(hamt_size(&snapshot2) == 1000);
+	assert(!hamt_get(&snapshot2, KEY(2000), NULL));
+	for (int i = 0; i < 1500; i++) {
+		void *value;
+		bool found = hamt_get(&map, KEY(i), &value);
+		assert(found == (i % 2 == 1 || i >= 1000));
+		if (found) {
+			assert(value == VALUE(i < 1000 ? i + 1 : i));
+		}
+		assert(hamt_get(&snapshot2, KEY(i), NULL) == found);
+	}
+	hamt_destroy(&snapshot2);
+	assert(hamt_size(&map) == 1001);
+	hamt_destroy(&map);
+}
+
+void test_hamt(void) {
+	test_hamt_basic();
+	
+	hamt_pool_t pool;
+	hamt_pool_init(&pool);
+	test_hamt_model(hamt_ptr_hash, NULL);
+	test_hamt_model(hamt_ptr_hash, &pool);
+	test_hamt_model(bad_hash, &pool);
+	test_hamt_snapshot(hamt_ptr_hash, &pool);
+	test_hamt_snapshot(bad_hash, NULL);
+	hamt_pool_destroy(&pool);
+	
+	printf("hamt.h passed all tests!\n");
+}
@@ -18,6 +18,7 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #endif
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <CEssentials/hashset.h>
 #include "test_hashset.h"
 
@@ -35,12 +36,182 @@ void test_hashset_overflow(void) {
 	hs_delete(hs, index);
 	
 	hs_put_str(hs, "40", index, absent);
+	assert(absent == 1);
 	
 	hs_get_str(hs, "10", index); // Will hang if there is a bug
 	
 	hs_destroy(hs);
 }
 
+void test_hashset_build(void) {
+	size_t index = 0;
+	HS(int) hs;
+	hs_init(hs);
+	
+	enum { count = 10000 };
+	int *keys = malloc(count * sizeof(int));
+	for (int i = 0; i < count; i++) {
+		keys[i] = i * 7;
+	}
+	keys[count - 1] = 0;
+	
+	bool success;
+	hs_build_from_array_int(hs, keys, count, success);
+	assert(success);
+	assert(hs_size(hs) == count - 1);
+	
+	for (int i = 0; i < count - 1; i++) {
+		hs_get_int(hs, i * 7, index);
+		assert(hs_valid(hs, index));
+	}
+	hs_get_int(hs, 1, index);
+	assert(!hs_valid(hs, index));
+	
+	free(keys);
+	hs_destroy(hs);
+}
+
+void test_hashset_deleted_duplicate(void) {
+	size_t index = 0;
+	int absent;
+	HS(int) hs;
+	hs_init(hs);
+	
+	bool success;
+	hs_reserve(hs, int, 4, success, hs_int_hash);
+	assert(success);
+	hs_put_int(hs, 0, index, absent);
+	hs_put_int(hs, 8, index, absent);
+	hs_get_int(hs, 0, index);
+	hs_delete(hs, index);
+	
+	hs_put_int(hs, 8, index, absent);
+	assert(absent == 0);
+	assert(hs_size(hs) == 1);
+	
+	hs_destroy(hs);
+}
+
+void test_hashset_load_factor(void) {
+	size_t index = 0;
+	int absent;
+	bool success;
+	HS(int) hs;
+	hs_init(hs);
+	hs_set_load_factor(hs, 0.5f, 0.1f);
+	
+	for (int i = 0; i < 1000; i++) {
+		hs_put_int(hs, i, index, absent);
+		assert(absent == 1);
+	}
+	assert(hs_capacity(hs) == 2048);
+	
+	for (int i = 0; i < 990; i++) {
+		hs_get_int(hs, i, index);
+		assert(hs_valid(hs, index));
+		hs_delete_shrink(hs, int, index, success, hs_int_hash);
+		assert(success);
+	}
+	assert(hs_size(hs) == 10);
+	assert(hs_capacity(hs) < 2048);
+	for (int i = 990; i < 1000; i++) {
+		hs_get_int(hs, i, index);
+		assert(hs_valid(hs, index));
+	}
+	
+	hs_shrink_to_fit(hs, int, success, hs_int_hash);
+	assert(success);
+	assert(hs_capacity(hs) == 32);
+	
+	// Deleted elements shouldn't make the hash set grow infinitely
+	for (int i = 1000; i < 100000; i++) {
+		hs_put_int(hs, i, index, absent);
+		assert(absent == 1);
+		hs_delete(hs, index);
+	}
+	assert(hs_capacity(hs) <= 64);
+	
+	hs_destroy(hs);
+}
+
+void test_hashset_i64(void) {
+	size_t index = 0;
+	int absent;
+	HS(int64_t) hs;
+	hs_init(hs);
+	
+	for (int64_t i = -500; i < 500; i++) {
+		hs_put_i64(hs, i * 1000000007, index, absent);
+		assert(absent == 1);
+	}
+	for (int64_t i = -500; i < 500; i++) {
+		hs_get_i64(hs, i * 1000000007, index);
+		assert(hs_valid(hs, index));
+	}
+	hs_get_i64(hs, 1, index);
+	assert(!hs_valid(hs, index));
+	hs_destroy(hs);
+}
+
+void test_hashset_small(void) {
+	size_t index = 0;
+	int absent;
+	HS_SMALL(const char*, 2) hs;
+	hs_small_init(hs);
+	
+	hs_small_put_str(hs, "a", index, absent);
+	assert(absent == 1);
+	hs_small_put_str(hs, "b", index, absent);
+	assert(absent == 1);
+	hs_small_put_str(hs, "a", index, absent);
+	assert(absent == 0);
+	assert(hs_small_is_inline(hs));
+	
+	hs_small_put_str(hs, "c", index, absent);
+	assert(absent == 1);
+	assert(!hs_small_is_inline(hs));
+	assert(hs_small_size(hs) == 3);
+	
+	hs_small_get_str(hs, "b", index);
+	assert(hs_small_valid(hs, index));
+	assert(strcmp(hs_small_key(hs, index), "b") == 0);
+	hs_small_delete(hs, index);
+	hs_small_get_str(hs, "b", index);
+	assert(!hs_small_valid(hs, index));
+	
+	size_t count = 0;
+	hs_small_for_each(hs, i) {
+		count++;
+	}
+	assert(count == 2);
+	
+	hs_small_destroy(hs);
+}
+
+void test_hashset_parallel_rehash(void) {
+	size_t index = 0;
+	int absent;
+	HS(uint32_t) hs;
+	hs_init(hs);
+	
+	uint32_t count = HS_PARALLEL_REHASH_MIN * 2;
+	for (uint32_t i = 0; i < count; i++) {
+		hs_put_u32(hs, i, index, absent);
+		assert(absent == 1);
+	}
+	size_t capacity = hs_capacity(hs);
+	bool success;
+	hs_reserve_u32(hs, capacity * 2, success);
+	assert(success);
+	assert(hs_size(hs) == count);
+	for (uint32_t i = 0; i < count; i++) {
+		hs_get_u32(hs, i, index);
+		assert(hs_valid(hs, index));
+	}
+	
+	hs_destroy(hs);
+}
+
 void test_hashset(void) {
 	size_t index = 0;
 	int absent;
@@ -98,6 +269,12 @@ void test_hashset(void) {
 	hs_destroy(hs);
 	
 	test_hashset_overflow();
+	test_hashset_build();
+	test_hashset_deleted_duplicate();
+	test_hashset_load_factor();
+	test_hashset_i64();
+	test_hashset_small();
+	test_hashset_parallel_rehash();
 	
 	printf("hashset.h passed all tests!\n");
 }
@@ -18,6 +18,7 @@ OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #endif
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <CEssentials/hashtable.h>
 #include "test_hashtable.h"
 
@@ -35,12 +36,293 @@ void test_hashtable_overflow(void) {
 	ht_delete(ht, index);
 	
 	ht_put_str(ht, int, "40", index, absent);
+	assert(absent == 1);
 	
 	ht_get_str(ht, "10", index); // Will hang if there is a bug
 	
 	ht_destroy(ht);
 }
 
+void test_hashtable_build(void) {
+	size_t index = 0;
+	HT(int, int) ht;
+	ht_init(ht);
+	
+	enum { count = 10000 };
+	int *keys = malloc(count * sizeof(int));
+	int *values = malloc(count * sizeof(int));
+	for (int i = 0; i < count; i++) {
+		keys[i] = i * 7;
+		values[i] = i;
+	}
+	keys[count - 1] = 0; // Duplicate key, the last value should win
+	
+	bool success;
+	ht_build_from_arrays_int(ht, int, keys, values, count, success);
+	assert(success);
+	assert(ht_size(ht) == count - 1);
+	
+	for (int i = 1; i < count - 1; i++) {
+		ht_get_int(ht, i * 7, index);
+		assert(ht_valid(ht, index));
+		assert(ht_value(ht, index) == i);
+	}
+	ht_get_int(ht, 0, index);
+	assert(ht_valid(ht, index));
+	assert(ht_value(ht, index) == count - 1);
+	
+	free(values);
+	free(keys);
+	ht_destroy(ht);
+	
+	HT(const char*, int) hts;
+	ht_init(hts);
+	const char *str_keys[] = {"10", "20", "30"};
+	int str_values[] = {10, 20, 30};
+	ht_build_from_arrays_str(hts, int, str_keys, str_values, 3, success);
+	assert(success);
+	assert(ht_size(hts) == 3);
+	ht_get_str(hts, "20", index);
+	assert(ht_valid(hts, index));
+	assert(ht_value(hts, index) == 20);
+	ht_destroy(hts);
+}
+
+void test_hashtable_deleted_duplicate(void) {
+	size_t index = 0;
+	int absent;
+	HT(int, int) ht;
+	ht_init(ht);
+	
+	// 0 and 8 share the same slot, so 8 is placed after 0 in the probe sequence
+	bool success;
+	ht_reserve(ht, int, int, 4, success, ht_int_hash);
+	assert(success);
+	ht_put_int(ht, int, 0, index, absent);
+	ht_put_int(ht, int, 8, index, absent);
+	ht_get_int(ht, 0, index);
+	ht_delete(ht, index);
+	
+	ht_put_int(ht, int, 8, index, absent);
+	assert(absent == 0);
+	assert(ht_size(ht) == 1);
+	
+	ht_destroy(ht);
+}
+
+void test_hashtable_load_factor(void) {
+	size_t index = 0;
+	int absent;
+	bool success;
+	HT(int, int) ht;
+	ht_init(ht);
+	ht_set_load_factor(ht, 0.5f, 0.1f);
+	
+	for (int i = 0; i < 1000; i++) {
+		ht_put_int(ht, int, i, index, absent);
+		assert(absent == 1);
+	}
+	assert(ht_capacity(ht) == 2048);
+	
+	for (int i = 0; i < 990; i++) {
+		ht_get_int(ht, i, index);
+		assert(ht_valid(ht, index));
+		ht_delete_shrink(ht, int, int, index, success, ht_int_hash);
+		assert(success);
+	}
+	assert(ht_size(ht) == 10);
+	assert(ht_capacity(ht) < 2048);
+	for (int i = 990; i < 1000; i++) {
+		ht_get_int(ht, i, index);
+		assert(ht_valid(ht, index));
+	}
+	
+	ht_shrink_to_fit(ht, int, int, success, ht_int_hash);
+	assert(success);
+	assert(ht_capacity(ht) == 32);
+	
+	// Deleted elements shouldn't make the hash table grow infinitely
+	for (int i = 1000; i < 100000; i++) {
+		ht_put_int(ht, int, i, index, absent);
+		assert(absent == 1);
+		ht_delete(ht, index);
+	}
+	assert(ht_capacity(ht) <= 64);
+	
+	ht_destroy(ht);
+}
+
+void test_hashtable_u64(void) {
+	size_t index = 0;
+	int absent;
+	HT(uint64_t, int) ht;
+	ht_init(ht);
+	
+	for (int i = 0; i < 1000; i++) {
+		ht_put_u64(ht, int, (uint64_t) i << 40, index, absent);
+		assert(absent == 1);
+		ht_value(ht, index) = i;
+	}
+	for (int i = 0; i < 1000; i++) {
+		ht_get_u64(ht, (uint64_t) i << 40, index);
+		assert(ht_valid(ht, index));
+		assert(ht_value(ht, index) == i);
+	}
+	ht_destroy(ht);
+	
+	int objects[4];
+	HT(const void*, int) htp;
+	ht_init(htp);
+	bool success;
+	ht_reserve_ptr(htp, int, 4, success);
+	assert(success);
+	for (int i = 0; i < 4; i++) {
+		ht_put_ptr(htp, int, &objects[i], index, absent);
+		assert(absent == 1);
+		ht_value(htp, index) = i;
+	}
+	ht_get_ptr(htp, &objects[2], index);
+	assert(ht_valid(htp, index));
+	assert(ht_value(htp, index) == 2);
+	ht_destroy(htp);
+}
+
+void test_hashtable_aggregate(void) {
+	size_t index = 0;
+	int absent;
+	HT(const char*, int) ht;
+	ht_init(ht);
+	
+	const char *words[] = {"a", "b", "a", "c", "a", "b"};
+	int ones[] = {1, 1, 1, 1, 1, 1};
+	for (size_t i = 0; i < 6; i++) {
+		ht_increment_str(ht, int, words[i], 1, index, absent);
+		assert(absent >= 0);
+	}
+	ht_get_str(ht, "a", index);
+	assert(ht_value(ht, index) == 3);
+	
+	bool success;
+	ht_aggregate_str(ht, int, words, ones, 6, success);
+	assert(success);
+	ht_get_str(ht, "a", index);
+	assert(ht_value(ht, index) == 6);
+	ht_get_str(ht, "b", index);
+	assert(ht_value(ht, index) == 4);
+	ht_get_str(ht, "c", index);
+	assert(ht_value(ht, index) == 2);
+	
+	ht_upsert_min(ht, const char*, int, "c", -5, index, absent, ht_str_hash, ht_str_eq);
+	assert(absent == 0);
+	assert(ht_value(ht, index) == -5);
+	ht_upsert_max(ht, const char*, int, "d", 7, index, absent, ht_str_hash, ht_str_eq);
+	assert(absent == 1);
+	assert(ht_value(ht, index) == 7);
+	ht_upsert(ht, const char*, int, "d", 0, index, absent, ht_str_hash, ht_str_eq);
+	assert(absent == 0);
+	assert(ht_value(ht, index) == 7);
+	ht_destroy(ht);
+	
+	HT(uint64_t, int) counts;
+	ht_init(counts);
+	enum { count = 100000 };
+	uint64_t *keys = malloc(count * sizeof(uint64_t));
+	int *deltas = malloc(count * sizeof(int));
+	for (size_t i = 0; i < count; i++) {
+		keys[i] = i % 1000;
+		deltas[i] = 1;
+	}
+	ht_aggregate_u64(counts, int, keys, deltas, count, success);
+	assert(success);
+	assert(ht_size(counts) == 1000);
+	ht_for_each(counts, i) {
+		assert(ht_value(counts, i) == count / 1000);
+	}
+	free(deltas);
+	free(keys);
+	ht_destroy(counts);
+}
+
+void test_hashtable_small(void) {
+	size_t index = 0;
+	int absent;
+	HT_SMALL(int, int, 4) ht;
+	ht_small_init(ht);
+	assert(ht_small_inline_capacity(ht) == 4);
+	
+	for (int i = 0; i < 4; i++) {
+		ht_small_put_int(ht, int, i, index, absent);
+		assert(absent == 1);
+		ht_small_value(ht, index) = i * 10;
+	}
+	ht_small_put_int(ht, int, 2, index, absent);
+	assert(absent == 0);
+	assert(ht_small_value(ht, index) == 20);
+	assert(ht_small_is_inline(ht));
+	assert(ht.table.flags == NULL);
+	
+	ht_small_get_int(ht, 1, index);
+	assert(ht_small_valid(ht, index));
+	ht_small_delete(ht, index);
+	ht_small_get_int(ht, 1, index);
+	assert(!ht_small_valid(ht, index));
+	assert(ht_small_size(ht) == 3);
+	ht_small_get_int(ht, 3, index);
+	assert(ht_small_valid(ht, index));
+	assert(ht_small_value(ht, index) == 30);
+	
+	// Spill to the heap
+	for (int i = 4; i < 100; i++) {
+		ht_small_put_int(ht, int, i, index, absent);
+		assert(absent == 1);
+		ht_small_value(ht, index) = i * 10;
+	}
+	assert(!ht_small_is_inline(ht));
+	assert(ht_small_size(ht) == 99);
+	int sum = 0;
+	ht_small_for_each(ht, i) {
+		assert(ht_small_value(ht, i) == ht_small_key(ht, i) * 10);
+		sum += ht_small_key(ht, i);
+	}
+	assert(sum == 99 * 100 / 2 - 1);
+	ht_small_get_int(ht, 0, index);
+	assert(ht_small_valid(ht, index));
+	assert(ht_small_value(ht, index) == 0);
+	
+	ht_small_destroy(ht);
+}
+
+void test_hashtable_parallel_rehash(void) {
+	size_t index = 0;
+	int absent;
+	HT(int, int) ht;
+	ht_init(ht);
+	
+	int count = HT_PARALLEL_REHASH_MIN * 2;
+	bool success;
+	ht_reserve_int(ht, int, (size_t) count, success);
+	assert(success);
+	for (int i = 0; i < count; i++) {
+		ht_put_int(ht, int, i * 7, index, absent);
+		assert(absent == 1);
+		ht_value(ht, index) = i;
+	}
+	size_t capacity = ht_capacity(ht);
+	ht_reserve_int(ht, int, capacity * 2, success);
+	assert(success);
+	assert(ht_capacity(ht) > capacity);
+	assert(ht_size(ht) == (size_t) count);
+	for (int i = 0; i < count; i++) {
+		ht_get_int(ht, i * 7, index);
+		assert(ht_valid(ht, index));
+		assert(ht_value(ht, index) == i);
+	}
+	ht_get_int(ht, 1, index);
+	assert(!ht_valid(ht, index));
+	
+	ht_destroy(ht);
+}
+
 void test_hashtable(void) {
 	size_t index = 0;
 	int absent;
@@ -106,6 +388,13 @@ void test_hashtable(void) {
 	ht_destroy(ht);
 	
 	test_hashtable_overflow();
+	test_hashtable_build();
+	test_hashtable_deleted_duplicate();
+	test_hashtable_load_factor();
+	test_hashtable_u64();
+	test_hashtable_aggregate();
+	test_hashtable_small();
+	test_hashtable_parallel_rehash();
 	
 	printf("hashtable.h passed all tests!\n");
 }
@@ -0,0 +1,100 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef HT_STATS
+#define HT_STATS
+#endif
+#ifndef HS_STATS
+#define HS_STATS
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <CEssentials/hashtable.h>
+#include <CEssentials/hashset.h>
+#include "test_hashtable_stats.h"
+
+#define bad_hash(key) ((size_t) 0)
+
+void test_hashtable_stats(void) {
+	size_t index = 0;
+	int absent;
+	typedef HT(int, int) int_ht_t;
+	int_ht_t ht;
+	ht_init(ht);
+	
+	for (int i = 0; i < 100; i++) {
+		ht_put_int(ht, int, i, index, absent);
+		assert(absent == 1);
+	}
+	for (int i = 0; i < 100; i++) {
+		ht_get_int(ht, i, index);
+		assert(ht_valid(ht, index));
+	}
+	assert(ht_stats(ht).puts == 100);
+	assert(ht_stats(ht).gets == 100);
+	assert(ht_stats(ht).rehashes > 0);
+	assert(ht_stats(ht).bytes_allocated >= ht_capacity(ht) * (1 + 2 * sizeof(int)));
+	size_t total = 0;
+	for (size_t i = 0; i < HT_STATS_PROBE_BUCKETS; i++) {
+		total += ht_stats(ht).probes[i];
+	}
+	assert(total == 200);
+	
+	// Lookups without statistics work on a const hash table
+	const int_ht_t *cht = &ht;
+	ht_get_hashed_nostats(*cht, 42, ht_int_hash(42), index, ht_int_eq);
+	assert(ht_valid(*cht, index) && ht_key(*cht, index) == 42);
+	ht_get_hashed_nostats(*cht, 1000, ht_int_hash(1000), index, ht_int_eq);
+	assert(!ht_valid(*cht, index));
+	assert(ht_stats(ht).gets == 100);
+	ht_destroy(ht);
+	
+	// A bad hash function is visible in probe lengths
+	HS(int) hs;
+	hs_init(hs);
+	for (int i = 0; i < 32; i++) {
+		hs_put(hs, int, i, index, absent, bad_hash, hs_int_eq);
+		assert(absent == 1);
+	}
+	assert(hs_stats(hs).max_probe == 31);
+	assert(hs_stats(hs).probes[HS_STATS_PROBE_BUCKETS - 1] == 32 - (HS_STATS_PROBE_BUCKETS - 1));
+	
+	// Lookups without statistics don't write to the hash set
+	hs_get(hs, 31, index, bad_hash, hs_int_eq);
+	assert(hs_valid(hs, index));
+	assert(hs_stats(hs).gets == 1);
+	hs_get_hashed_nostats(hs, 31, bad_hash(31), index, hs_int_eq);
+	assert(hs_valid(hs, index) && hs_key(hs, index) == 31);
+	hs_get_hashed_nostats(hs, 100, bad_hash(100), index, hs_int_eq);
+	assert(!hs_valid(hs, index));
+	assert(hs_stats(hs).gets == 1);
+	
+	FILE *out = tmpfile();
+	if (out) {
+		hs_stats_dump(hs, out);
+		long size = ftell(out);
+		assert(size > 0);
+		fclose(out);
+	}
+	
+	hs_stats_reset(hs);
+	assert(hs_stats(hs).puts == 0);
+	hs_destroy(hs);
+	
+	printf("hashtable.h statistics passed all tests!\n");
+}
@@ -0,0 +1,94 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <CEssentials/intset.h>
+#include "test_intset.h"
+
+void test_intset_delete(void) {
+	size_t index = 0;
+	int absent;
+	INTSET(uint64_t) s;
+	intset_init(s, UINT64_MAX);
+	
+	enum { count = 10000 };
+	for (uint64_t i = 0; i < count; i++) {
+		intset_put_u64(s, i << 32, index, absent);
+		assert(absent == 1);
+	}
+	assert(intset_size(s) == count);
+	
+	for (uint64_t i = 0; i < count; i += 3) {
+		intset_get_u64(s, i << 32, index);
+		assert(intset_valid(s, index));
+		intset_delete_u64(s, index);
+	}
+	for (uint64_t i = 0; i < count; i++) {
+		intset_get_u64(s, i << 32, index);
+		assert(intset_valid(s, index) == (i % 3 != 0));
+	}
+	
+	size_t visited = 0;
+	intset_for_each(s, i) {
+		assert((intset_key(s, i) >> 32) % 3 != 0);
+		visited++;
+	}
+	assert(visited == intset_size(s));
+	
+	intset_destroy(s);
+}
+
+void test_intset(void) {
+	size_t index = 0;
+	int absent;
+	INTSET(int64_t) s;
+	intset_init(s, 0);
+	
+	intset_get_i64(s, 10, index);
+	assert(!intset_valid(s, index));
+	
+	intset_put_i64(s, 10, index, absent);
+	assert(absent == 1);
+	assert(intset_valid(s, index));
+	
+	intset_put_i64(s, -20, index, absent);
+	assert(absent == 1);
+	
+	intset_put_i64(s, 10, index, absent);
+	assert(absent == 0);
+	
+	intset_put_i64(s, 0, index, absent); // The reserved key
+	assert(absent == -1);
+	
+	intset_get_i64(s, -20, index);
+	assert(intset_valid(s, index));
+	assert(intset_key(s, index) == -20);
+	
+	assert(intset_size(s) == 2);
+	intset_clear(s);
+	assert(intset_size(s) == 0);
+	intset_get_i64(s, 10, index);
+	assert(!intset_valid(s, index));
+	
+	intset_destroy(s);
+	
+	test_intset_delete();
+	
+	printf("intset.h passed all tests!\n");
+}
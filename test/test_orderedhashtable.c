@@ -0,0 +1,140 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <CEssentials/orderedhashtable.h>
+#include "test_orderedhashtable.h"
+
+void test_orderedhashtable_order(void) {
+	size_t index = 0;
+	int absent;
+	OHT(int, int) ht;
+	oht_init(ht);
+	
+	for (int i = 0; i < 1000; i++) {
+		oht_put_int(ht, int, (i * 37) % 1000, index, absent);
+		assert(absent == 1);
+		oht_value(ht, index) = i;
+	}
+	assert(oht_size(ht) == 1000);
+	assert(ht.index_width == 2);
+	
+	for (int i = 0; i < 1000; i += 2) {
+		oht_get_int(ht, (i * 37) % 1000, index);
+		assert(oht_valid(ht, index));
+		oht_delete(ht, index);
+	}
+	
+	int expected = 1;
+	oht_for_each(ht, i) {
+		assert(oht_key(ht, i) == (expected * 37) % 1000);
+		assert(oht_value(ht, i) == expected);
+		expected += 2;
+	}
+	assert(expected == 1001);
+	
+	// Rehash must compact elements preserving their order
+	for (int i = 1000; i < 2000; i++) {
+		oht_put_int(ht, int, i, index, absent);
+		assert(absent == 1);
+		oht_value(ht, index) = i;
+	}
+	assert(oht_count(ht) == oht_size(ht));
+	expected = 1;
+	oht_for_each(ht, i) {
+		assert(oht_value(ht, i) == expected);
+		expected += expected < 999 ? 2 : 1;
+	}
+	assert(expected == 2000);
+	
+	oht_destroy(ht);
+}
+
+void test_orderedhashtable(void) {
+	size_t index = 0;
+	int absent;
+	OHT(const char*, int) ht;
+	oht_init(ht);
+	
+	oht_get_str(ht, "10", index);
+	assert(!oht_valid(ht, index));
+	
+	oht_put_str(ht, int, "20", index, absent);
+	assert(absent == 1);
+	assert(oht_valid(ht, index));
+	oht_value(ht, index) = 20;
+	
+	oht_put_str(ht, int, "10", index, absent);
+	assert(absent == 1);
+	assert(oht_valid(ht, index));
+	oht_value(ht, index) = 10;
+	
+	oht_put_str(ht, int, "30", index, absent);
+	assert(absent == 1);
+	oht_value(ht, index) = 30;
+	
+	oht_put_str(ht, int, "20", index, absent);
+	assert(absent == 0);
+	assert(oht_value(ht, index) == 20);
+	
+	int order[3], count = 0;
+	oht_for_each(ht, i) {
+		order[count++] = oht_value(ht, i);
+	}
+	assert(count == 3);
+	assert(order[0] == 20 && order[1] == 10 && order[2] == 30);
+	
+	oht_get_str(ht, "10", index);
+	assert(oht_valid(ht, index));
+	oht_delete(ht, index);
+	oht_get_str(ht, "10", index);
+	assert(!oht_valid(ht, index));
+	
+	// Re-inserted element goes to the end
+	oht_put_str(ht, int, "10", index, absent);
+	assert(absent == 1);
+	oht_value(ht, index) = 10;
+	count = 0;
+	oht_for_each(ht, i) {
+		order[count++] = oht_value(ht, i);
+	}
+	assert(count == 3);
+	assert(order[0] == 20 && order[1] == 30 && order[2] == 10);
+	
+	oht_clear(ht);
+	oht_get_str(ht, "20", index);
+	assert(!oht_valid(ht, index));
+	assert(oht_size(ht) == 0);
+	
+	oht_destroy(ht);
+	
+	OHT(int, int) loose;
+	oht_init(loose);
+	oht_set_load_factor(loose, 0.25f, 0.0f);
+	bool success;
+	oht_reserve_int(loose, int, 100, success);
+	assert(success);
+	assert(oht_capacity(loose) == 512);
+	assert(oht_max_used(loose) >= 100);
+	oht_destroy(loose);
+	
+	test_orderedhashtable_order();
+	
+	printf("orderedhashtable.h passed all tests!\n");
+}
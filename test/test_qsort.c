@@ -42,6 +42,16 @@ void test_qsort(void) {
 	assert(arr[2] == 3);
 	assert(arr[3] == 5);
 	
+	int dupArr[1000];
+	for (int i = 0; i < 1000; i++) {
+		dupArr[i] = (i * 7919) % 3;
+	}
+	qsort_int(dupArr, 1000);
+	for (int i = 1; i < 1000; i++) {
+		assert(dupArr[i - 1] <= dupArr[i]);
+	}
+	assert(dupArr[0] == 0 && dupArr[999] == 2);
+	
 	const char *strArr[] = {"pear", "peach", "apple"};
 	
 	qsort_str_const(strArr, sizeof(strArr) / sizeof(const char*));
@@ -0,0 +1,134 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <CEssentials/strbuilder.h>
+#include "test_strbuilder.h"
+
+static void test_strbuilder_basic(void) {
+	strbuilder_t b;
+	strbuilder_init(&b, 16);
+	dynstr s = strbuilder_to_dynstr(&b, NULL);
+	assert(dynstr_size(s) == 0 && strcmp(s, "") == 0);
+	dynstr_free(s);
+	assert(strbuilder_iovec(&b, NULL, 0) == 0);
+	assert(strbuilder_printf(&b, "%s", ""));
+	assert(strbuilder_size(&b) == 0);
+	
+	assert(strbuilder_append(&b, "Hello"));
+	assert(strbuilder_push(&b, ','));
+	assert(strbuilder_push(&b, ' '));
+	dynstr world = dynstr_new("world");
+	assert(strbuilder_cat(&b, world));
+	dynstr_free(world);
+	assert(strbuilder_printf(&b, "! %d + %d = %d", 2, 2, 4));
+	assert(strbuilder_push_chars(&b, "\0end", 4));
+	assert(strbuilder_size(&b) == 27);
+	assert(b.block_count > 1);
+	
+	s = strbuilder_to_dynstr(&b, NULL);
+	assert(dynstr_size(s) == 27);
+	assert(memcmp(s, "Hello, world! 2 + 2 = 4\0end", 27) == 0 && s[27] == '\0');
+	dynstr_free(s);
+	
+	s = strbuilder_to_dynstr(&b, dynstr_new(">> "));
+	assert(dynstr_size(s) == 30);
+	assert(memcmp(s, ">> Hello, world!", 16) == 0);
+	dynstr_free(s);
+	
+	strbuilder_iovec_t iov[16];
+	size_t count = strbuilder_iovec(&b, iov, 16);
+	assert(count >= 2 && count <= b.block_count);
+	size_t total = 0;
+	for (size_t i = 0; i < count; i++) {
+		total += iov[i].iov_len;
+	}
+	assert(total == 27);
+	assert(memcmp(iov[0].iov_base, "Hello", 5) == 0);
+	assert(strbuilder_iovec(&b, iov, 1) == count);
+	
+	strbuilder_clear(&b);
+	assert(strbuilder_size(&b) == 0 && b.block_count == 1);
+	assert(strbuilder_append(&b, "again"));
+	s = strbuilder_to_dynstr(&b, NULL);
+	assert(strcmp(s, "again") == 0);
+	dynstr_free(s);
+	strbuilder_destroy(&b);
+}
+
+static void test_strbuilder_reserve(void) {
+	strbuilder_t b;
+	strbuilder_init(&b, 8);
+	assert(strbuilder_append(&b, "len="));
+	char *slot = strbuilder_reserve(&b, 6); // Doesn't fit into the rest of the first block
+	assert(slot);
+	assert(strbuilder_push(&b, ';'));
+	size_t body = strbuilder_size(&b);
+	for (int i = 0; i < 100; i++) {
+		assert(strbuilder_printf(&b, "%d,", i));
+	}
+	char buffer[7];
+	snprintf(buffer, sizeof(buffer), "%06zu", strbuilder_size(&b) - body);
+	memcpy(slot, buffer, 6);
+	dynstr s = strbuilder_to_dynstr(&b, NULL);
+	assert(strncmp(s, "len=000290;0,1,2,", 17) == 0);
+	assert(dynstr_size(s) == strbuilder_size(&b));
+	dynstr_free(s);
+	strbuilder_destroy(&b);
+}
+
+static void test_strbuilder_large(void) {
+	strbuilder_t b;
+	strbuilder_init(&b, 0);
+	dynstr expected = dynstr_new("");
+	char piece[1000];
+	srand(99);
+	for (int i = 0; i < 5000; i++) {
+		size_t count = (size_t) rand() % sizeof(piece);
+		for (size_t j = 0; j < count; j++) {
+			piece[j] = (char) ('a' + rand() % 26);
+		}
+		assert(strbuilder_push_chars(&b, piece, count));
+		expected = dynstr_push_chars(expected, piece, count);
+	}
+	// A single append larger than the maximum block size
+	char *big = malloc(STRBUILDER_MAX_BLOCK_SIZE + 10);
+	assert(big);
+	memset(big, 'x', STRBUILDER_MAX_BLOCK_SIZE + 10);
+	assert(strbuilder_push_chars(&b, big, STRBUILDER_MAX_BLOCK_SIZE + 10));
+	expected = dynstr_push_chars(expected, big, STRBUILDER_MAX_BLOCK_SIZE + 10);
+	free(big);
+	
+	assert(strbuilder_size(&b) == dynstr_size(expected));
+	assert(b.block_count < 20); // Blocks grow with the total size
+	dynstr s = strbuilder_to_dynstr(&b, NULL);
+	assert(dynstr_size(s) == dynstr_size(expected) && memcmp(s, expected, dynstr_size(s) + 1) == 0);
+	dynstr_free(s);
+	dynstr_free(expected);
+	strbuilder_destroy(&b);
+}
+
+void test_strbuilder(void) {
+	test_strbuilder_basic();
+	test_strbuilder_reserve();
+	test_strbuilder_large();
+	printf("strbuilder.h passed all tests!\n");
+}
@@ -0,0 +1,115 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <CEssentials/strpool.h>
+#include <CEssentials/hashtable.h>
+#include "test_strpool.h"
+
+static void test_strpool_intern(void) {
+	strpool_t pool;
+	strpool_init(&pool);
+	
+	const char *a = strpool_intern(&pool, "hello");
+	assert(a);
+	assert(strcmp(a, "hello") == 0);
+	assert(dynstr_size(a) == 5);
+	assert(strpool_id(a) == 0);
+	
+	const char *b = strpool_intern_chars(&pool, "hello world", 5);
+	assert(b == a);
+	const char *c = strpool_intern_chars(&pool, "hello world", 11);
+	assert(c != a);
+	assert(strpool_id(c) == 1);
+	assert(strpool_count(&pool) == 2);
+	assert(strpool_at(&pool, 1) == c);
+	
+	dynstr s = dynstr_new_chars("a\0b", 3);
+	const char *d = strpool_intern_dynstr(&pool, s);
+	assert(d != strpool_intern(&pool, "a"));
+	assert(dynstr_size(d) == 3);
+	assert(memcmp(d, "a\0b", 4) == 0);
+	dynstr_free(s);
+	
+	const char *empty = strpool_intern(&pool, "");
+	assert(empty && *empty == '\0');
+	assert(strpool_intern_chars(&pool, "", 0) == empty);
+	
+	assert(strpool_find(&pool, "hello") == a);
+	assert(strpool_find(&pool, "world") == NULL);
+	assert(strpool_find_chars(&pool, "a\0b", 3) == d);
+	
+	strpool_destroy(&pool);
+	assert(strpool_count(&pool) == 0);
+}
+
+static void test_strpool_many(void) {
+	strpool_t pool;
+	strpool_init(&pool);
+	
+	const char *strings[5000];
+	char buffer[32];
+	for (int i = 0; i < 5000; i++) {
+		snprintf(buffer, sizeof(buffer), "str%i", i);
+		strings[i] = strpool_intern(&pool, buffer);
+		assert(strings[i]);
+		assert(strpool_id(strings[i]) == (uint32_t) i);
+	}
+	// Duplicates don't allocate
+	size_t memory = strpool_memory(&pool);
+	for (int i = 0; i < 5000; i++) {
+		snprintf(buffer, sizeof(buffer), "str%i", i);
+		assert(strpool_intern(&pool, buffer) == strings[i]);
+	}
+	assert(strpool_memory(&pool) == memory);
+	assert(strpool_count(&pool) == 5000);
+	
+	// Large strings get dedicated chunks and keep the current chunk in use
+	char large[STRPOOL_CHUNK_SIZE];
+	memset(large, 'x', sizeof(large));
+	const char *l = strpool_intern_chars(&pool, large, sizeof(large));
+	assert(l && dynstr_size(l) == sizeof(large) && l[sizeof(large)] == '\0');
+	assert(strpool_intern_chars(&pool, large, sizeof(large)) == l);
+	for (int i = 0; i < 5000; i++) {
+		assert(strcmp(strpool_at(&pool, i), strings[i]) == 0);
+	}
+	
+	// Interned strings as hash table keys
+	size_t index;
+	int absent;
+	HT(const char*, int) ht;
+	ht_init(ht);
+	for (int i = 0; i < 5000; i++) {
+		ht_put(ht, const char*, int, strings[i], index, absent, strpool_hash, strpool_eq);
+		assert(absent == 1);
+		ht_value(ht, index) = i;
+	}
+	ht_get(ht, strpool_find(&pool, "str123"), index, strpool_hash, strpool_eq);
+	assert(ht_valid(ht, index));
+	assert(ht_value(ht, index) == 123);
+	ht_destroy(ht);
+	
+	strpool_destroy(&pool);
+}
+
+void test_strpool(void) {
+	test_strpool_intern();
+	test_strpool_many();
+	printf("strpool.h passed all tests!\n");
+}
@@ -0,0 +1,144 @@
+/*
+Copyright 2022 Ivan Kolesnikov <kiv.apple@gmail.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software
+and associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <CEssentials/strview.h>
+#include "test_strview.h"
+
+#define SV(s) strview_from_cstr(s)
+
+static void test_strview_slice_trim(void) {
+	const char *buffer = "  Hello, world!\n";
+	strview_t v = SV(buffer);
+	assert(v.len == strlen(buffer));
+	
+	strview_t t = strview_trim(v, " \n");
+	assert(t.ptr == buffer + 2); // No copies
+	assert(strview_eq(t, SV("Hello, world!")));
+	assert(strview_eq(strview_trim_start(v, " "), SV("Hello, world!\n")));
+	assert(strview_eq(strview_trim_end(v, "\n!"), SV("  Hello, world")));
+	assert(strview_empty(strview_trim(SV("   "), " ")));
+	
+	assert(strview_eq(strview_slice(t, 0, 5), SV("Hello")));
+	assert(strview_eq(strview_slice(t, 7, -1), SV("world")));
+	assert(strview_eq(strview_slice(t, -6, 100), SV("world!")));
+	assert(strview_empty(strview_slice(t, 100, 5)));
+	assert(strview_empty(strview_slice(t, 5, -100)));
+	
+	assert(strview_has_prefix(t, SV("Hell")));
+	assert(!strview_has_prefix(t, SV("hell")));
+	assert(strview_has_prefix(t, SV("")));
+	assert(strview_has_suffix(t, SV("world!")));
+	assert(!strview_has_suffix(SV("!"), SV("world!")));
+	
+	assert(strview_cmp(SV("abc"), SV("abd")) < 0);
+	assert(strview_cmp(SV("abc"), SV("ab")) > 0);
+	assert(strview_cmp(SV("ab"), SV("abc")) < 0);
+	assert(strview_cmp(SV(""), SV("")) == 0);
+	assert(strview_cmp(strview_slice(t, 0, 5), SV("Hello")) == 0);
+}
+
+static void test_strview_find(void) {
+	strview_t v = SV("abracadabra");
+	assert(strview_find_char(v, 'c') == 4);
+	assert(strview_find_char(v, 'z') == STRVIEW_NPOS);
+	assert(strview_rfind_char(v, 'a') == 10);
+	assert(strview_rfind_char(v, 'z') == STRVIEW_NPOS);
+	assert(strview_find(v, SV("cad")) == 4);
+	assert(strview_find(v, SV("bra")) == 1);
+	assert(strview_find(v, SV("abra")) == 0);
+	assert(strview_find(strview_slice(v, 1, -1), SV("abr")) == 6);
+	assert(strview_find(strview_slice(v, 1, -1), SV("abra")) == STRVIEW_NPOS);
+	assert(strview_find(v, SV("")) == 0);
+	assert(strview_find(SV("ab"), SV("abc")) == STRVIEW_NPOS);
+	assert(strview_rfind(v, SV("abra")) == 7);
+	assert(strview_rfind(v, SV("")) == v.len);
+	assert(strview_rfind(v, SV("x")) == STRVIEW_NPOS);
+}
+
+static void test_strview_split(void) {
+	strview_t rest = SV(" key = value;other=42;;last;"), token;
+	const char *expected[] = {" key = value", "other=42", "", "last"};
+	int count = 0;
+	while (strview_split_next(&rest, SV(";"), &token)) {
+		assert(count < 4);
+		assert(strview_eq(token, SV(expected[count])));
+		count++;
+	}
+	assert(count == 4);
+	
+	rest = SV("a::b");
+	assert(strview_split_next(&rest, SV("::"), &token));
+	assert(strview_eq(token, SV("a")));
+	assert(strview_split_next(&rest, SV("::"), &token));
+	assert(strview_eq(token, SV("b")));
+	assert(!strview_split_next(&rest, SV("::"), &token));
+	
+	rest = SV("abc");
+	assert(strview_split_next(&rest, SV(""), &token));
+	assert(strview_eq(token, SV("abc")));
+	assert(!strview_split_next(&rest, SV(""), &token));
+}
+
+static void test_strview_dynstr(void) {
+	dynstr s = dynstr_new("  padded  ");
+	strview_t v = strview_trim(strview_from_dynstr(s), " ");
+	dynstr copy = strview_to_dynstr(v);
+	assert(strcmp(copy, "padded") == 0);
+	assert(dynstr_size(copy) == 6);
+	copy = dynstr_push_view(copy, strview_slice(v, 0, 3));
+	assert(strcmp(copy, "paddedpad") == 0);
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "[" STRVIEW_FMT "]", STRVIEW_ARG(v));
+	assert(strcmp(buffer, "[padded]") == 0);
+	dynstr_free(copy);
+	dynstr_free(s);
+}
+
+static void test_strview_charset(void) {
+	charset_t digits = charset_empty();
+	charset_add_range(&digits, '0', '9');
+	strview_t v = SV("abc123def456ghi");
+	assert(strview_find_any(v, &digits) == 3);
+	assert(strview_rfind_any(v, &digits) == 11);
+	assert(strview_find_any(SV("abc"), &digits) == STRVIEW_NPOS);
+	assert(strview_rfind_any(SV("abc"), &digits) == STRVIEW_NPOS);
+	assert(strview_eq(strview_trim_charset(SV("12ab34"), &digits), SV("ab")));
+	
+	charset_t separators = charset_make(" ,");
+	strview_t rest = SV("a, b,c"), token;
+	const char *expected[] = {"a", "", "b", "c"};
+	int count = 0;
+	while (strview_split_next_any(&rest, &separators, &token)) {
+		assert(count < 4);
+		assert(strview_eq(token, SV(expected[count])));
+		count++;
+	}
+	assert(count == 4);
+}
+
+void test_strview(void) {
+	test_strview_slice_trim();
+	test_strview_find();
+	test_strview_split();
+	test_strview_charset();
+	test_strview_dynstr();
+	printf("strview.h passed all tests!\n");
+}